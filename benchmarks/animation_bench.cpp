@@ -0,0 +1,229 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "animator.h"
+#include "easing.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace geom = mir::geometry;
+using namespace miracle;
+
+namespace
+{
+class BenchAnimation : public Animation
+{
+public:
+    using Animation::Animation;
+
+    void on_tick(AnimationStepResult const& result) override
+    {
+        // Keep the compiler from discarding the step
+        if (result.position)
+            sink += result.position->x;
+    }
+
+    float sink = 0;
+};
+
+struct NamedFunction
+{
+    EaseFunction function;
+    char const* name;
+};
+
+/// The curves that are configured for the window and workspace events
+/// by default, plus a few of the more expensive ones.
+NamedFunction const functions[] = {
+    { EaseFunction::ease_out_back,       "ease_out_back"       },
+    { EaseFunction::ease_in_out_sine,    "ease_in_out_sine"    },
+    { EaseFunction::ease_out_bounce,     "ease_out_bounce"     },
+    { EaseFunction::ease_out_expo,       "ease_out_expo"       },
+    { EaseFunction::ease_in_out_elastic, "ease_in_out_elastic" }
+};
+
+AnimationType const types[] = {
+    AnimationType::slide,
+    AnimationType::grow,
+    AnimationType::shrink
+};
+
+struct Scenario
+{
+    AnimatorStorage storage;
+    int animations;
+};
+
+struct EaseResult
+{
+    double scalar_ns;
+    double batched_ns;
+    double table_ns;
+};
+
+/// Measures the nanoseconds per value spent easing [values] with [ease], with
+/// [ease_batch] and with the curve's [EaseTable].
+EaseResult run_ease(EaseFunction function, int values, int repeats)
+{
+    AnimationDefinition definition;
+    definition.function = function;
+    std::vector<float> progress(values);
+    std::vector<float> eased(values);
+    for (int i = 0; i < values; i++)
+        progress[i] = (float)i / (float)values;
+
+    float sink = 0;
+    auto const start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++)
+    {
+        for (int i = 0; i < values; i++)
+            eased[i] = ease(definition, progress[i]);
+        sink += eased[r % values];
+    }
+    auto const middle = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++)
+    {
+        ease_batch(definition, progress.data(), eased.data(), values);
+        sink += eased[r % values];
+    }
+    auto const after_batch = std::chrono::steady_clock::now();
+    auto const table = ease_table(definition);
+    for (int r = 0; r < repeats; r++)
+    {
+        table->ease_batch(progress.data(), eased.data(), values);
+        sink += eased[r % values];
+    }
+    auto const end = std::chrono::steady_clock::now();
+
+    if (sink == -1.f)
+        printf("\n");
+
+    auto const per_value = [&](auto elapsed)
+    {
+        return std::chrono::duration<double, std::nano>(elapsed).count() / ((double)repeats * values);
+    };
+    return { per_value(middle - start), per_value(after_batch - middle), per_value(end - after_batch) };
+}
+
+std::shared_ptr<BenchAnimation> make_animation(AnimationHandle handle, int i, float duration_seconds)
+{
+    AnimationDefinition definition;
+    definition.type = types[i % std::size(types)];
+    definition.function = functions[i % std::size(functions)].function;
+    definition.duration_seconds = duration_seconds;
+
+    geom::Rectangle const from {
+        { (i % 10) * 100, (i / 10) * 100 },
+        { 100, 100 }
+    };
+    geom::Rectangle const to {
+        { (i % 10) * 100 + 50, (i / 10) * 100 + 50 },
+        { 150, 150 }
+    };
+    return std::make_shared<BenchAnimation>(handle, definition, from, to, from);
+}
+
+double run(Scenario const& scenario, int ticks)
+{
+    // Each animation is long enough that none finish during the run, so that
+    // every tick steps all of them.
+    float const dt = 1.f / 144.f;
+    Animator animator(scenario.storage);
+    for (int i = 0; i < scenario.animations; i++)
+        animator.append(make_animation(animator.register_animateable(), i, dt * (float)(ticks + 1)));
+
+    auto const start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ticks; i++)
+        animator.tick(dt);
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::micro>(elapsed).count() / ticks;
+}
+
+/// Measures the nanoseconds spent replacing an in-flight animation, as happens
+/// to every window during a rapid relayout.
+double run_supersede(Scenario const& scenario, int repeats)
+{
+    Animator animator(scenario.storage);
+    std::vector<AnimationHandle> handles;
+    for (int i = 0; i < scenario.animations; i++)
+    {
+        handles.push_back(animator.register_animateable());
+        animator.append(make_animation(handles.back(), i, 1.f));
+    }
+
+    std::vector<std::shared_ptr<BenchAnimation>> replacements;
+    for (int i = 0; i < repeats; i++)
+        replacements.push_back(make_animation(handles[i % handles.size()], i, 1.f));
+
+    auto const start = std::chrono::steady_clock::now();
+    for (auto const& replacement : replacements)
+        animator.append(replacement);
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / repeats;
+}
+}
+
+int main(int argc, char const** argv)
+{
+    int ticks = 2000;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc)
+            ticks = atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--ticks N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (ticks <= 0)
+    {
+        fprintf(stderr, "--ticks must be positive\n");
+        return 1;
+    }
+
+    printf("%20s %14s %14s %14s\n", "ease function", "scalar ns", "batched ns", "table ns");
+    for (auto const& [function, name] : functions)
+    {
+        auto const result = run_ease(function, 1000, ticks);
+        printf("%20s %14.2f %14.2f %14.2f\n", name, result.scalar_ns, result.batched_ns, result.table_ns);
+    }
+
+    printf("\n%10s %14s %14s %8s\n", "animations", "objects us", "batched us", "speedup");
+    for (int const count : { 1, 30, 100, 1000 })
+    {
+        auto const objects = run({ AnimatorStorage::objects, count }, ticks);
+        auto const batched = run({ AnimatorStorage::batched, count }, ticks);
+        printf("%10d %14.2f %14.2f %7.2fx\n", count, objects, batched, objects / batched);
+    }
+
+    printf("\n%10s %14s %14s\n", "animations", "objects ns", "batched ns");
+    for (int const count : { 1, 30, 100, 1000 })
+    {
+        auto const objects = run_supersede({ AnimatorStorage::objects, count }, ticks);
+        auto const batched = run_supersede({ AnimatorStorage::batched, count }, ticks);
+        printf("%10d %14.2f %14.2f\n", count, objects, batched);
+    }
+
+    return 0;
+}
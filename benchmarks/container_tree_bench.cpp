@@ -0,0 +1,267 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "compositor_state.h"
+#include "container_tree.h"
+#include "leaf_container.h"
+#include "mock_output.h"
+#include "parent_container.h"
+#include "stub_configuration.h"
+#include "stub_session.h"
+#include "stub_surface.h"
+#include "stub_window_controller.h"
+#include "workspace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace geom = mir::geometry;
+using namespace miracle;
+
+namespace
+{
+struct Shape
+{
+    /// The number of lanes in each lane above the bottom level.
+    int fanout;
+
+    /// The number of levels of lanes beneath the root.
+    int depth;
+
+    /// The number of windows in each lane at the bottom level.
+    int leaves;
+};
+
+struct Result
+{
+    size_t nodes;
+    double pointer_walk_us;
+    double for_each_window_us;
+    double rebuild_us;
+};
+
+geom::Rectangle const output_area { { 0, 0 }, { 1920, 1080 } };
+std::vector<std::shared_ptr<WorkspaceInterface>> no_workspaces;
+std::vector<miral::Zone> no_app_zones;
+
+/// Finds containers through an ordered map of windows, as miral finds the
+/// window info that holds them, rather than by searching every window.
+class MapWindowController : public StubWindowController
+{
+public:
+    explicit MapWindowController(std::vector<StubWindowData>& pairs) :
+        StubWindowController(pairs)
+    {
+    }
+
+    std::shared_ptr<Container> get_container(miral::Window const& window) override
+    {
+        auto const it = containers.find(window);
+        return it == containers.end() ? nullptr : it->second;
+    }
+
+    std::map<miral::Window, std::shared_ptr<Container>> containers;
+};
+
+/// Owns a workspace and the windows in it.
+struct Fixture
+{
+    Fixture() :
+        state { std::make_shared<CompositorState>() },
+        window_controller { std::make_shared<MapWindowController>(pairs) },
+        config { std::make_shared<test::StubConfiguration>() },
+        output { std::make_unique<testing::NiceMock<test::MockOutput>>() }
+    {
+        ON_CALL(*output, get_area()).WillByDefault(testing::ReturnRef(output_area));
+        ON_CALL(*output, get_workspaces()).WillByDefault(testing::ReturnRef(no_workspaces));
+        ON_CALL(*output, get_app_zones()).WillByDefault(testing::ReturnRef(no_app_zones));
+        workspace = std::make_unique<Workspace>(output.get(), 0, 0, "0", config, window_controller, state);
+    }
+
+    std::shared_ptr<LeafContainer> add_window(std::shared_ptr<ParentContainer> const& lane)
+    {
+        miral::WindowSpecification spec;
+        miral::ApplicationInfo app_info;
+        auto const hint = workspace->allocate_position(app_info, spec, { ContainerType::leaf, lane });
+
+        auto const session = std::make_shared<test::StubSession>();
+        auto const surface = std::make_shared<test::StubSurface>();
+        sessions.push_back(session);
+        surfaces.push_back(surface);
+
+        miral::Window window(session, surface);
+        miral::WindowInfo info(window, spec);
+        auto const leaf = workspace->create_container(info, hint);
+        pairs.push_back({ window, leaf });
+        window_controller->containers[window] = leaf;
+        return Container::as_leaf(leaf);
+    }
+
+    void populate(std::shared_ptr<ParentContainer> const& lane, Shape const& shape, int depth)
+    {
+        if (depth == 0)
+        {
+            // A lane that was converted from a window already holds that window
+            for (auto i = lane->num_nodes(); i < static_cast<size_t>(shape.leaves); i++)
+                add_window(lane);
+            return;
+        }
+
+        for (int i = 0; i < shape.fanout; i++)
+        {
+            auto const leaf = add_window(lane);
+            populate(lane->convert_to_parent(leaf), shape, depth - 1);
+        }
+    }
+
+    std::shared_ptr<CompositorState> state;
+    std::vector<std::shared_ptr<test::StubSession>> sessions;
+    std::vector<std::shared_ptr<test::StubSurface>> surfaces;
+    std::vector<StubWindowData> pairs;
+    std::shared_ptr<MapWindowController> window_controller;
+    std::shared_ptr<test::StubConfiguration> config;
+    std::unique_ptr<test::MockOutput> output;
+    std::unique_ptr<Workspace> workspace;
+};
+
+/// The walk that Workspace::for_each_window used to do over the shared pointers
+/// of the tree itself, finding each window's container in the same way.
+bool pointer_walk(
+    std::function<bool(std::shared_ptr<Container>)> const& f,
+    std::shared_ptr<Container> const& node,
+    WindowController& window_controller)
+{
+    if (auto const leaf = Container::as_leaf(node))
+    {
+        if (!leaf->window())
+            return false;
+
+        auto const container = window_controller.get_container(leaf->window().value());
+        return container && f(container);
+    }
+
+    for (auto const& child : Container::as_parent(node)->get_sub_nodes())
+    {
+        if (pointer_walk(f, child, window_controller))
+            return true;
+    }
+
+    return false;
+}
+
+Result run(Shape const& shape, int walks)
+{
+    Fixture fixture;
+    auto const root = fixture.workspace->get_root();
+    fixture.populate(root, shape, shape.depth);
+
+    size_t pointer_leaves = 0;
+    std::function<bool(std::shared_ptr<Container>)> const count_pointer_leaf = [&](std::shared_ptr<Container> const&)
+    {
+        pointer_leaves++;
+        return false;
+    };
+
+    size_t walked_leaves = 0;
+    std::function<bool(std::shared_ptr<Container>)> const count_walked_leaf = [&](std::shared_ptr<Container> const&)
+    {
+        walked_leaves++;
+        return false;
+    };
+
+    // The first walk builds the workspace's copy of the tree, which later walks reuse
+    fixture.workspace->for_each_window(count_walked_leaf);
+    walked_leaves = 0;
+
+    auto const start = std::chrono::steady_clock::now();
+    for (int i = 0; i < walks; i++)
+        pointer_walk(count_pointer_leaf, root, *fixture.window_controller);
+    auto const after_pointer_walk = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < walks; i++)
+        fixture.workspace->for_each_window(count_walked_leaf);
+    auto const after_for_each_window = std::chrono::steady_clock::now();
+
+    ContainerTree tree;
+    for (int i = 0; i < walks; i++)
+        tree.rebuild({ root });
+    auto const end = std::chrono::steady_clock::now();
+
+    if (pointer_leaves != walked_leaves || pointer_leaves == 0)
+    {
+        fprintf(stderr, "The walks disagree: %zu windows against %zu\n", pointer_leaves, walked_leaves);
+        exit(1);
+    }
+
+    auto const per_walk = [&](auto elapsed)
+    {
+        return std::chrono::duration<double, std::micro>(elapsed).count() / walks;
+    };
+    return {
+        tree.size(),
+        per_walk(after_pointer_walk - start),
+        per_walk(after_for_each_window - after_pointer_walk),
+        per_walk(end - after_for_each_window)
+    };
+}
+}
+
+int main(int argc, char const** argv)
+{
+    int walks = 2000;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--walks") == 0 && i + 1 < argc)
+            walks = atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--walks N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (walks <= 0)
+    {
+        fprintf(stderr, "--walks must be positive\n");
+        return 1;
+    }
+
+    printf("%8s %8s %16s %20s %12s %8s\n", "shape", "nodes", "pointer walk us", "for_each_window us", "rebuild us", "speedup");
+    for (auto const& [shape, name] : {
+             std::pair { Shape { 0, 0, 1000 }, "flat" },
+             std::pair { Shape { 10, 2, 9 },  "bushy" },
+             std::pair { Shape { 4, 4, 3 },   "nested" }
+    })
+    {
+        auto const result = run(shape, walks);
+        printf("%8s %8zu %16.2f %20.2f %12.2f %7.2fx\n",
+            name,
+            result.nodes,
+            result.pointer_walk_us,
+            result.for_each_window_us,
+            result.rebuild_us,
+            result.pointer_walk_us / result.for_each_window_us);
+    }
+
+    return 0;
+}
@@ -0,0 +1,267 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "recording_gl.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+namespace
+{
+uint64_t call_count = 0;
+GLuint next_name = 1;
+
+void record()
+{
+    call_count++;
+}
+
+GLint location_of(GLuint program, GLchar const* name)
+{
+    // Hand out a stable location per program and name, as a driver would
+    static std::unordered_map<std::string, GLint> locations;
+    auto const key = std::to_string(program) + ":" + name;
+    auto const it = locations.find(key);
+    if (it != locations.end())
+        return it->second;
+
+    auto const location = static_cast<GLint>(locations.size() % 32);
+    locations.emplace(key, location);
+    return location;
+}
+}
+
+uint64_t miracle::bench::gl_call_count()
+{
+    return call_count;
+}
+
+extern "C"
+{
+GL_APICALL void GL_APIENTRY glActiveTexture(GLenum) { record(); }
+GL_APICALL void GL_APIENTRY glAttachShader(GLuint, GLuint) { record(); }
+GL_APICALL void GL_APIENTRY glBindBuffer(GLenum, GLuint) { record(); }
+GL_APICALL void GL_APIENTRY glBindFramebuffer(GLenum, GLuint) { record(); }
+GL_APICALL void GL_APIENTRY glBindTexture(GLenum, GLuint) { record(); }
+GL_APICALL void GL_APIENTRY glBlendColor(GLfloat, GLfloat, GLfloat, GLfloat) { record(); }
+GL_APICALL void GL_APIENTRY glBlendFuncSeparate(GLenum, GLenum, GLenum, GLenum) { record(); }
+GL_APICALL void GL_APIENTRY glBufferData(GLenum, GLsizeiptr, void const*, GLenum) { record(); }
+GL_APICALL void GL_APIENTRY glBufferSubData(GLenum, GLintptr, GLsizeiptr, void const*) { record(); }
+GL_APICALL void GL_APIENTRY glClear(GLbitfield) { record(); }
+GL_APICALL void GL_APIENTRY glClearColor(GLfloat, GLfloat, GLfloat, GLfloat) { record(); }
+GL_APICALL void GL_APIENTRY glClearStencil(GLint) { record(); }
+GL_APICALL void GL_APIENTRY glColorMask(GLboolean, GLboolean, GLboolean, GLboolean) { record(); }
+GL_APICALL void GL_APIENTRY glCompileShader(GLuint) { record(); }
+GL_APICALL void GL_APIENTRY glDeleteBuffers(GLsizei, GLuint const*) { record(); }
+GL_APICALL void GL_APIENTRY glDeleteFramebuffers(GLsizei, GLuint const*) { record(); }
+GL_APICALL void GL_APIENTRY glDeleteProgram(GLuint) { record(); }
+GL_APICALL void GL_APIENTRY glDeleteShader(GLuint) { record(); }
+GL_APICALL void GL_APIENTRY glDeleteTextures(GLsizei, GLuint const*) { record(); }
+GL_APICALL void GL_APIENTRY glDisable(GLenum) { record(); }
+GL_APICALL void GL_APIENTRY glDisableVertexAttribArray(GLuint) { record(); }
+GL_APICALL void GL_APIENTRY glDrawArrays(GLenum, GLint, GLsizei) { record(); }
+GL_APICALL void GL_APIENTRY glEnable(GLenum) { record(); }
+GL_APICALL void GL_APIENTRY glEnableVertexAttribArray(GLuint) { record(); }
+GL_APICALL void GL_APIENTRY glFramebufferTexture2D(GLenum, GLenum, GLenum, GLuint, GLint) { record(); }
+GL_APICALL void GL_APIENTRY glLinkProgram(GLuint) { record(); }
+GL_APICALL void GL_APIENTRY glScissor(GLint, GLint, GLsizei, GLsizei) { record(); }
+GL_APICALL void GL_APIENTRY glShaderSource(GLuint, GLsizei, GLchar const* const*, GLint const*) { record(); }
+GL_APICALL void GL_APIENTRY glStencilFunc(GLenum, GLint, GLuint) { record(); }
+GL_APICALL void GL_APIENTRY glStencilMask(GLuint) { record(); }
+GL_APICALL void GL_APIENTRY glStencilOp(GLenum, GLenum, GLenum) { record(); }
+GL_APICALL void GL_APIENTRY glTexImage2D(GLenum, GLint, GLint, GLsizei, GLsizei, GLint, GLenum, GLenum, void const*) { record(); }
+GL_APICALL void GL_APIENTRY glTexParameteri(GLenum, GLenum, GLint) { record(); }
+GL_APICALL void GL_APIENTRY glUniform1f(GLint, GLfloat) { record(); }
+GL_APICALL void GL_APIENTRY glUniform1i(GLint, GLint) { record(); }
+GL_APICALL void GL_APIENTRY glUniform2f(GLint, GLfloat, GLfloat) { record(); }
+GL_APICALL void GL_APIENTRY glUniform4fv(GLint, GLsizei, GLfloat const*) { record(); }
+GL_APICALL void GL_APIENTRY glUniformMatrix4fv(GLint, GLsizei, GLboolean, GLfloat const*) { record(); }
+GL_APICALL void GL_APIENTRY glUseProgram(GLuint) { record(); }
+GL_APICALL void GL_APIENTRY glVertexAttribPointer(GLuint, GLint, GLenum, GLboolean, GLsizei, void const*) { record(); }
+GL_APICALL void GL_APIENTRY glViewport(GLint, GLint, GLsizei, GLsizei) { record(); }
+
+GL_APICALL GLuint GL_APIENTRY glCreateProgram()
+{
+    record();
+    return next_name++;
+}
+
+GL_APICALL GLuint GL_APIENTRY glCreateShader(GLenum)
+{
+    record();
+    return next_name++;
+}
+
+GL_APICALL void GL_APIENTRY glGenBuffers(GLsizei n, GLuint* buffers)
+{
+    record();
+    for (GLsizei i = 0; i < n; i++)
+        buffers[i] = next_name++;
+}
+
+GL_APICALL void GL_APIENTRY glGenFramebuffers(GLsizei n, GLuint* framebuffers)
+{
+    record();
+    for (GLsizei i = 0; i < n; i++)
+        framebuffers[i] = next_name++;
+}
+
+GL_APICALL void GL_APIENTRY glGenTextures(GLsizei n, GLuint* textures)
+{
+    record();
+    for (GLsizei i = 0; i < n; i++)
+        textures[i] = next_name++;
+}
+
+GL_APICALL GLenum GL_APIENTRY glCheckFramebufferStatus(GLenum)
+{
+    record();
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+GL_APICALL GLenum GL_APIENTRY glGetError()
+{
+    record();
+    return GL_NO_ERROR;
+}
+
+GL_APICALL void GL_APIENTRY glGetIntegerv(GLenum pname, GLint* data)
+{
+    record();
+    switch (pname)
+    {
+    case GL_RED_BITS:
+    case GL_GREEN_BITS:
+    case GL_BLUE_BITS:
+    case GL_ALPHA_BITS:
+    case GL_STENCIL_BITS:
+        *data = 8;
+        break;
+    case GL_DEPTH_BITS:
+        *data = 24;
+        break;
+    case GL_MAX_TEXTURE_SIZE:
+        *data = 16384;
+        break;
+    default:
+        *data = 0;
+        break;
+    }
+}
+
+GL_APICALL GLubyte const* GL_APIENTRY glGetString(GLenum name)
+{
+    record();
+    switch (name)
+    {
+    case GL_VENDOR:
+        return reinterpret_cast<GLubyte const*>("miracle-wm");
+    case GL_RENDERER:
+        return reinterpret_cast<GLubyte const*>("recording");
+    case GL_VERSION:
+        return reinterpret_cast<GLubyte const*>("OpenGL ES 2.0 recording");
+    case GL_SHADING_LANGUAGE_VERSION:
+        return reinterpret_cast<GLubyte const*>("OpenGL ES GLSL ES 1.00");
+    default:
+        return reinterpret_cast<GLubyte const*>("");
+    }
+}
+
+GL_APICALL void GL_APIENTRY glGetShaderiv(GLuint, GLenum pname, GLint* params)
+{
+    record();
+    *params = pname == GL_COMPILE_STATUS ? GL_TRUE : 0;
+}
+
+GL_APICALL void GL_APIENTRY glGetProgramiv(GLuint, GLenum pname, GLint* params)
+{
+    record();
+    *params = pname == GL_LINK_STATUS ? GL_TRUE : 0;
+}
+
+GL_APICALL void GL_APIENTRY glGetShaderInfoLog(GLuint, GLsizei size, GLsizei* length, GLchar* log)
+{
+    record();
+    if (length)
+        *length = 0;
+    if (size > 0)
+        log[0] = '\0';
+}
+
+GL_APICALL void GL_APIENTRY glGetProgramInfoLog(GLuint, GLsizei size, GLsizei* length, GLchar* log)
+{
+    record();
+    if (length)
+        *length = 0;
+    if (size > 0)
+        log[0] = '\0';
+}
+
+GL_APICALL GLint GL_APIENTRY glGetUniformLocation(GLuint program, GLchar const* name)
+{
+    record();
+    return location_of(program, name);
+}
+
+GL_APICALL GLint GL_APIENTRY glGetAttribLocation(GLuint, GLchar const* name)
+{
+    record();
+    return strcmp(name, "position") == 0 ? 0 : 1;
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglBindAPI(EGLenum)
+{
+    record();
+    return EGL_TRUE;
+}
+
+EGLAPI __eglMustCastToProperFunctionPointerType EGLAPIENTRY eglGetProcAddress(char const*)
+{
+    record();
+    return nullptr;
+}
+
+EGLAPI EGLDisplay EGLAPIENTRY eglGetCurrentDisplay()
+{
+    record();
+    return EGL_NO_DISPLAY;
+}
+
+EGLAPI EGLSurface EGLAPIENTRY eglGetCurrentSurface(EGLint)
+{
+    record();
+    return EGL_NO_SURFACE;
+}
+
+EGLAPI char const* EGLAPIENTRY eglQueryString(EGLDisplay, EGLint)
+{
+    record();
+    return "";
+}
+
+EGLAPI EGLBoolean EGLAPIENTRY eglQuerySurface(EGLDisplay, EGLSurface, EGLint, EGLint* value)
+{
+    record();
+    *value = 0;
+    return EGL_FALSE;
+}
+}
@@ -0,0 +1,37 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLE_WM_RECORDING_GL_H
+#define MIRACLE_WM_RECORDING_GL_H
+
+#include <cstdint>
+
+namespace miracle::bench
+{
+
+/// The benchmarks link against a recording implementation of the GLES2 and EGL
+/// entry points used by the renderer instead of a real driver. Every call is
+/// counted and does nothing else, apart from returning plausible values for
+/// queries so that shader compilation and capability checks succeed.
+///
+/// This lets us measure the CPU cost of the renderer and the number of GL calls
+/// that it makes without a GPU or display.
+uint64_t gl_call_count();
+
+} // miracle::bench
+
+#endif // MIRACLE_WM_RECORDING_GL_H
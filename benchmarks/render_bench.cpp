@@ -0,0 +1,391 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "compositor_state.h"
+#include "recording_gl.h"
+#include "renderer.h"
+#include "stub_configuration.h"
+#include "stub_container.h"
+#include "stub_session.h"
+#include "stub_surface.h"
+
+#include <GLES2/gl2.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mir/graphics/buffer.h>
+#include <mir/graphics/platform.h>
+#include <mir/graphics/program_factory.h>
+#include <mir/graphics/renderable.h>
+#include <mir/graphics/texture.h>
+#include <miral/window.h>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+using namespace miracle;
+
+namespace
+{
+std::atomic<uint64_t> allocation_count = 0;
+}
+
+void* operator new(size_t size)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (auto const p = malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    free(p);
+}
+
+namespace
+{
+geom::Rectangle const output_area {
+    { 0, 0 },
+    { 1920, 1080 }
+};
+
+class BenchTexture : public mg::gl::Texture
+{
+public:
+    explicit BenchTexture(GLuint id) :
+        id { id }
+    {
+    }
+
+    auto shader(mg::gl::ProgramFactory& factory) const -> mg::gl::Program const& override
+    {
+        static int const shader_id = 0;
+        return factory.compile_fragment_shader(
+            &shader_id,
+            "",
+            "uniform sampler2D tex;\n"
+            "vec4 sample_to_rgba(in vec2 texcoord)\n"
+            "{\n"
+            "    return texture2D(tex, texcoord);\n"
+            "}\n");
+    }
+
+    auto layout() const -> Layout override { return Layout::GL; }
+    void bind() override { glBindTexture(GL_TEXTURE_2D, id); }
+    auto tex_id() const -> GLuint override { return id; }
+    void add_syncpoint() override { }
+
+private:
+    GLuint id;
+};
+
+class BenchBuffer : public mg::Buffer
+{
+public:
+    BenchBuffer(uint32_t id, geom::Size size) :
+        id_ { id },
+        size_ { size }
+    {
+    }
+
+    mg::BufferID id() const override { return id_; }
+    geom::Size size() const override { return size_; }
+    MirPixelFormat pixel_format() const override { return mir_pixel_format_argb_8888; }
+    mg::NativeBufferBase* native_buffer_base() override { return nullptr; }
+
+private:
+    mg::BufferID id_;
+    geom::Size size_;
+};
+
+class BenchRenderingProvider : public mg::GLRenderingProvider
+{
+public:
+    auto as_texture(std::shared_ptr<mg::Buffer> buffer) -> std::shared_ptr<mg::gl::Texture> override
+    {
+        auto& texture = textures[buffer->id().as_value()];
+        if (!texture)
+            texture = std::make_shared<BenchTexture>(buffer->id().as_value());
+        return texture;
+    }
+
+    auto suitability_for_allocator(std::shared_ptr<mg::GraphicBufferAllocator> const&) -> mg::probe::Result override
+    {
+        return mg::probe::unsupported;
+    }
+
+    auto suitability_for_display(mg::DisplaySink&) -> mg::probe::Result override
+    {
+        return mg::probe::unsupported;
+    }
+
+    auto surface_for_sink(mg::DisplaySink&, mg::GLConfig const&) -> std::unique_ptr<mg::gl::OutputSurface> override
+    {
+        return nullptr;
+    }
+
+    auto make_framebuffer_provider(mg::DisplaySink&) -> std::unique_ptr<mg::FramebufferProvider> override
+    {
+        return nullptr;
+    }
+
+private:
+    std::unordered_map<uint32_t, std::shared_ptr<mg::gl::Texture>> textures;
+};
+
+class BenchOutputSurface : public mg::gl::OutputSurface
+{
+public:
+    void bind() override { }
+    void make_current() override { }
+    void release_current() override { }
+    auto commit() -> std::unique_ptr<mg::Framebuffer> override { return nullptr; }
+    auto size() const -> geom::Size override { return output_area.size; }
+    auto layout() const -> Layout override { return Layout::GL; }
+};
+
+class BenchRenderable : public mg::Renderable
+{
+public:
+    BenchRenderable(
+        std::shared_ptr<mg::Buffer> buffer,
+        geom::Rectangle const& position,
+        std::optional<geom::Rectangle> const& clip,
+        bool shaped,
+        mir::scene::Surface const* surface) :
+        buffer_ { std::move(buffer) },
+        position { position },
+        clip { clip },
+        shaped_ { shaped },
+        surface { surface }
+    {
+    }
+
+    ID id() const override { return this; }
+    std::shared_ptr<mg::Buffer> buffer() const override { return buffer_; }
+    geom::Rectangle screen_position() const override { return position; }
+    geom::RectangleD src_bounds() const override
+    {
+        return {
+            { 0, 0 },
+            { position.size.width.as_int(), position.size.height.as_int() }
+        };
+    }
+    std::optional<geom::Rectangle> clip_area() const override { return clip; }
+    float alpha() const override { return 1.f; }
+    glm::mat4 transformation() const override { return glm::mat4(1.f); }
+    bool shaped() const override { return shaped_; }
+    std::optional<mir::scene::Surface const*> surface_if_any() const override { return surface; }
+
+private:
+    std::shared_ptr<mg::Buffer> buffer_;
+    geom::Rectangle position;
+    std::optional<geom::Rectangle> clip;
+    bool shaped_;
+    mir::scene::Surface const* surface;
+};
+
+/// A tiled window, which is what gets an outline.
+class BenchContainer : public test::StubContainer
+{
+public:
+    BenchContainer(miral::Window const& window, bool focused) :
+        window_ { window },
+        focused { focused }
+    {
+    }
+
+    ContainerType get_type() const override { return ContainerType::leaf; }
+    std::optional<miral::Window> window() const override { return window_; }
+    bool is_focused() const override { return focused; }
+    glm::mat4 get_workspace_transform() const override { return glm::mat4(1.f); }
+    glm::mat4 get_output_transform() const override { return glm::mat4(1.f); }
+
+private:
+    miral::Window window_;
+    bool focused;
+};
+
+class BenchConfiguration : public test::StubConfiguration
+{
+public:
+    explicit BenchConfiguration(bool outlines)
+    {
+        border_config.size = outlines ? 3 : 0;
+        border_config.color = glm::vec4(0.2f, 0.2f, 0.2f, 1.f);
+        border_config.focus_color = glm::vec4(0.5f, 0.2f, 0.8f, 1.f);
+    }
+
+    [[nodiscard]] BorderConfig const& get_border_config() const override
+    {
+        return border_config;
+    }
+
+private:
+    BorderConfig border_config;
+};
+
+struct Scenario
+{
+    int windows;
+    bool outlines;
+    bool clip;
+};
+
+struct Result
+{
+    double cpu_us_per_frame;
+    double gl_calls_per_frame;
+    double allocations_per_frame;
+};
+
+Result run(Scenario const& scenario, int frames)
+{
+    auto const config = std::make_shared<BenchConfiguration>(scenario.outlines);
+    auto const compositor_state = std::make_shared<CompositorState>();
+    auto const session = std::make_shared<test::StubSession>();
+
+    // Lay the windows out in a grid that covers the output, as tiling would
+    int columns = 1;
+    while (columns * columns < scenario.windows)
+        columns++;
+    int const rows = (scenario.windows + columns - 1) / columns;
+    int const width = output_area.size.width.as_int() / columns;
+    int const height = output_area.size.height.as_int() / rows;
+
+    std::vector<std::shared_ptr<test::StubSurface>> surfaces;
+    std::vector<std::unique_ptr<BenchContainer>> containers;
+    mg::RenderableList renderables;
+    for (int i = 0; i < scenario.windows; i++)
+    {
+        geom::Rectangle const position {
+            { (i % columns) * width, (i / columns) * height },
+            { width, height }
+        };
+        std::optional<geom::Rectangle> clip;
+        if (scenario.clip)
+        {
+            clip = geom::Rectangle {
+                position.top_left,
+                { width, height / 2 }
+            };
+        }
+
+        auto const surface = std::make_shared<test::StubSurface>();
+        auto container = std::make_unique<BenchContainer>(miral::Window(session, surface), i == 0);
+        compositor_state->render_data_manager()->add(*container);
+
+        auto const buffer = std::make_shared<BenchBuffer>(static_cast<uint32_t>(i + 1), position.size);
+        renderables.push_back(std::make_shared<BenchRenderable>(buffer, position, clip, i % 2 == 1, surface.get()));
+        surfaces.push_back(surface);
+        containers.push_back(std::move(container));
+    }
+
+    Renderer renderer(
+        std::make_shared<BenchRenderingProvider>(),
+        std::make_unique<BenchOutputSurface>(),
+        config,
+        compositor_state);
+    renderer.set_viewport(output_area);
+
+    // The first frames compile shaders and size the renderer's buffers
+    for (int i = 0; i < 5; i++)
+        renderer.render(renderables);
+
+    auto const gl_calls_before = bench::gl_call_count();
+    auto const allocations_before = allocation_count.load();
+    auto const start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; i++)
+        renderer.render(renderables);
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+    auto const allocations = allocation_count.load() - allocations_before;
+    auto const gl_calls = bench::gl_call_count() - gl_calls_before;
+
+    return {
+        std::chrono::duration<double, std::micro>(elapsed).count() / frames,
+        static_cast<double>(gl_calls) / frames,
+        static_cast<double>(allocations) / frames
+    };
+}
+}
+
+int main(int argc, char const** argv)
+{
+    int frames = 500;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            frames = atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--frames N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (frames <= 0)
+    {
+        fprintf(stderr, "--frames must be positive\n");
+        return 1;
+    }
+
+    printf("%8s %9s %5s %14s %14s %14s\n", "windows", "outlines", "clip", "cpu us/frame", "gl calls/frame", "allocs/frame");
+    for (int const windows : { 10, 100, 500 })
+    {
+        for (bool const outlines : { false, true })
+        {
+            for (bool const clip : { false, true })
+            {
+                auto const result = run({ windows, outlines, clip }, frames);
+                printf("%8d %9s %5s %14.2f %14.1f %14.1f\n",
+                    windows,
+                    outlines ? "yes" : "no",
+                    clip ? "yes" : "no",
+                    result.cpu_us_per_frame,
+                    result.gl_calls_per_frame,
+                    result.allocations_per_frame);
+            }
+        }
+    }
+
+    return 0;
+}
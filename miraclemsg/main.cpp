@@ -21,6 +21,7 @@ See the LICENSE.Sway file for details.
 #include "ipc_client.h"
 #include <ctype.h>
 #include <getopt.h>
+#include <inttypes.h>
 #include <iostream>
 #include <json.h>
 #include <limits.h>
@@ -242,6 +243,62 @@ static void pretty_print_seat(json_object* i)
     printf("\n");
 }
 
+static void pretty_print_frame_timing(char const* label, json_object* h)
+{
+    if (!h || json_object_get_type(h) == json_type_null)
+    {
+        printf("  %s: unavailable\n", label);
+        return;
+    }
+
+    json_object *count, *mean, *p50, *p90, *p99, *max;
+    json_object_object_get_ex(h, "count", &count);
+    json_object_object_get_ex(h, "mean_us", &mean);
+    json_object_object_get_ex(h, "p50_us", &p50);
+    json_object_object_get_ex(h, "p90_us", &p90);
+    json_object_object_get_ex(h, "p99_us", &p99);
+    json_object_object_get_ex(h, "max_us", &max);
+
+    printf("  %s: %" PRId64 " frames, mean %" PRId64 "us, p50 %" PRId64 "us, p90 %" PRId64 "us, p99 %" PRId64 "us, max %" PRId64 "us\n",
+        label,
+        json_object_get_int64(count),
+        json_object_get_int64(mean),
+        json_object_get_int64(p50),
+        json_object_get_int64(p90),
+        json_object_get_int64(p99),
+        json_object_get_int64(max));
+}
+
+static void pretty_print_frame_timings(json_object* t)
+{
+    json_object *name, *rect, *cpu, *gpu, *commit_interval;
+    json_object_object_get_ex(t, "name", &name);
+    json_object_object_get_ex(t, "rect", &rect);
+    json_object_object_get_ex(t, "cpu", &cpu);
+    json_object_object_get_ex(t, "commit_interval", &commit_interval);
+    if (!json_object_object_get_ex(t, "gpu", &gpu))
+        gpu = NULL;
+
+    json_object *x, *y, *width, *height;
+    json_object_object_get_ex(rect, "x", &x);
+    json_object_object_get_ex(rect, "y", &y);
+    json_object_object_get_ex(rect, "width", &width);
+    json_object_object_get_ex(rect, "height", &height);
+
+    printf("Output %s (%dx%d at %d,%d)\n",
+        json_object_get_string(name),
+        json_object_get_int(width), json_object_get_int(height),
+        json_object_get_int(x), json_object_get_int(y));
+    pretty_print_frame_timing("CPU", cpu);
+    pretty_print_frame_timing("GPU", gpu);
+    pretty_print_frame_timing("Commit interval", commit_interval);
+
+    json_object* fullscreen_only_frames;
+    if (json_object_object_get_ex(t, "fullscreen_only_frames", &fullscreen_only_frames))
+        printf("  Fullscreen-only frames: %" PRId64 "\n", json_object_get_int64(fullscreen_only_frames));
+    printf("\n");
+}
+
 static void pretty_print_output(json_object* o)
 {
     json_object *name, *rect, *focused, *active, *power, *ws, *current_mode, *non_desktop;
@@ -462,6 +519,7 @@ static void pretty_print(int type, json_object* resp)
     case IPC_GET_INPUTS:
     case IPC_GET_OUTPUTS:
     case IPC_GET_SEATS:
+    case IPC_GET_FRAME_TIMINGS:
         break;
     default:
         printf("%s\n", json_object_to_json_string_ext(resp, JSON_C_TO_STRING_PRETTY | JSON_C_TO_STRING_SPACED));
@@ -490,6 +548,9 @@ static void pretty_print(int type, json_object* resp)
         case IPC_GET_SEATS:
             pretty_print_seat(obj);
             break;
+        case IPC_GET_FRAME_TIMINGS:
+            pretty_print_frame_timings(obj);
+            break;
         }
     }
 }
@@ -642,6 +703,14 @@ int main(int argc, char** argv)
     {
         type = IPC_SUBSCRIBE;
     }
+    else if (strcasecmp(cmdtype, "get_frame_timings") == 0)
+    {
+        type = IPC_GET_FRAME_TIMINGS;
+    }
+    else if (strcasecmp(cmdtype, "get_layout_transactions") == 0)
+    {
+        type = IPC_GET_LAYOUT_TRANSACTIONS;
+    }
     else
     {
         if (quiet)
@@ -19,7 +19,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define GLM_ENABLE_EXPERIMENTAL
 
 #include "animator.h"
+#include "easing.h"
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <glm/gtx/transform.hpp>
 #include <mir/log.h>
 #include <mir/server_action_queue.h>
@@ -48,125 +51,6 @@ inline float get_percent_complete(float target, float real)
         return percent;
 }
 
-float ease_out_bounce(AnimationDefinition const& defintion, float x)
-{
-    if (x < 1 / defintion.d1)
-    {
-        return defintion.n1 * x * x;
-    }
-    else if (x < 2 / defintion.d1)
-    {
-        return defintion.n1 * (x -= 1.5f / defintion.d1) * x + 0.75f;
-    }
-    else if (x < 2.5 / defintion.d1)
-    {
-        return defintion.n1 * (x -= 2.25f / defintion.d1) * x + 0.9375f;
-    }
-    else
-    {
-        return defintion.n1 * (x -= 2.625f / defintion.d1) * x + 0.984375f;
-    }
-}
-
-inline float ease(AnimationDefinition const& defintion, float t)
-{
-    // https://easings.net/
-    switch (defintion.function)
-    {
-    case EaseFunction::linear:
-        return t;
-    case EaseFunction::ease_in_sine:
-        return 1 - cosf((t * M_PI) / 2.f);
-    case EaseFunction::ease_in_out_sine:
-        return -(cosf(M_PI * t) - 1) / 2;
-    case EaseFunction::ease_out_sine:
-        return sinf((t * M_PI) / 2.f);
-    case EaseFunction::ease_in_quad:
-        return t * t;
-    case EaseFunction::ease_out_quad:
-        return 1 - (1 - t) * (1 - t);
-    case EaseFunction::ease_in_out_quad:
-        return t < 0.5 ? 2 * t * t : 1 - powf(-2 * t + 2, 2) / 2;
-    case EaseFunction::ease_in_cubic:
-        return t * t * t;
-    case EaseFunction::ease_out_cubic:
-        return 1 - powf(1 - t, 3);
-    case EaseFunction::ease_in_out_cubic:
-        return t < 0.5 ? 4 * t * t * t : 1 - powf(-2 * t + 2, 3) / 2;
-    case EaseFunction::ease_in_quart:
-        return t * t * t * t;
-    case EaseFunction::ease_out_quart:
-        return 1 - powf(1 - t, 4);
-    case EaseFunction::ease_in_out_quart:
-        return t < 0.5 ? 8 * t * t * t * t : 1 - powf(-2 * t + 2, 4) / 2;
-    case EaseFunction::ease_in_quint:
-        return t * t * t * t * t;
-    case EaseFunction::ease_out_quint:
-        return 1 - powf(1 - t, 5);
-    case EaseFunction::ease_in_out_quint:
-        return t < 0.5 ? 16 * t * t * t * t * t : 1 - powf(-2 * t + 2, 5) / 2;
-    case EaseFunction::ease_in_expo:
-        return t == 0 ? 0 : powf(2, 10 * t - 10);
-    case EaseFunction::ease_out_expo:
-        return t == 1 ? 1 : 1 - powf(2, -10 * t);
-    case EaseFunction::ease_in_out_expo:
-        return t == 0
-            ? 0
-            : t == 1
-            ? 1
-            : t < 0.5 ? powf(2, 20 * t - 10) / 2
-                      : (2 - powf(2, -20 * t + 10)) / 2;
-    case EaseFunction::ease_in_circ:
-        return 1 - sqrtf(1 - powf(t, 2));
-    case EaseFunction::ease_out_circ:
-        return sqrtf(1 - powf(t - 1, 2));
-    case EaseFunction::ease_in_out_circ:
-        return t < 0.5f
-            ? (1 - sqrtf(1 - powf(2 * t, 2))) / 2
-            : (sqrtf(1 - powf(-2 * t + 2, 2)) + 1) / 2;
-    case EaseFunction::ease_in_back:
-        return defintion.c3 * t * t * t - defintion.c1 * t * t;
-    case EaseFunction::ease_out_back:
-    {
-        return 1 + defintion.c3 * powf(t - 1, 3) + defintion.c1 * powf(t - 1, 2);
-    }
-    case EaseFunction::ease_in_out_back:
-        return t < 0.5
-            ? (powf(2 * t, 2) * ((defintion.c2 + 1) * 2 * t - defintion.c2)) / 2
-            : (powf(2 * t - 2, 2) * ((defintion.c2 + 1) * (t * 2 - 2) + defintion.c2) + 2) / 2;
-    case EaseFunction::ease_in_elastic:
-        return t == 0
-            ? 0
-            : t == 1
-            ? 1
-            : -powf(2, 10 * t - 10) * sinf((t * 10 - 10.75f) * defintion.c4);
-    case EaseFunction::ease_out_elastic:
-        return t == 0
-            ? 0
-            : t == 1
-            ? 1
-            : powf(2, -10 * t) * sinf((t * 10 - 0.75f) * defintion.c4) + 1;
-    case EaseFunction::ease_in_out_elastic:
-        return t == 0
-            ? 0
-            : t == 1
-            ? 1
-            : t < 0.5
-            ? -(powf(2, 20 * t - 10) * sinf((20 * t - 11.125f) * defintion.c5)) / 2
-            : (powf(2, -20 * t + 10) * sinf((20 * t - 11.125f) * defintion.c5)) / 2 + 1;
-    case EaseFunction::ease_in_bounce:
-        return 1 - ease_out_bounce(defintion, 1 - t);
-    case EaseFunction::ease_out_bounce:
-        return ease_out_bounce(defintion, t);
-    case EaseFunction::ease_in_out_bounce:
-        return t < 0.5
-            ? (1 - ease_out_bounce(defintion, 1 - 2 * t)) / 2
-            : (1 + ease_out_bounce(defintion, 2 * t - 1)) / 2;
-    default:
-        return 1.f;
-    }
-}
-
 inline float interpolate_scale(float p, float start, float end)
 {
     float diff = end - start;
@@ -263,6 +147,7 @@ Animation::Animation(
     mir::geometry::Rectangle const& current) :
     handle { handle },
     definition { std::move(definition) },
+    table { ease_table(this->definition) },
     to { to },
     from { current },
     clip_area { current },
@@ -323,9 +208,16 @@ AnimationStepResult Animation::init()
 
 AnimationStepResult Animation::step(float const dt)
 {
-    runtime_seconds += dt;
-    float const t = (runtime_seconds / definition.duration_seconds);
+    auto const runtime = runtime_seconds + dt;
+    if (runtime >= definition.duration_seconds)
+        return step_to(runtime, 1.f);
+
+    return step_to(runtime, table->ease(runtime / definition.duration_seconds));
+}
 
+AnimationStepResult Animation::step_to(float const runtime, float const p)
+{
+    runtime_seconds = runtime;
     if (runtime_seconds >= definition.duration_seconds)
     {
         return { handle, true, to, to_vec2_point(to), to_vec2_size(to), glm::mat4(1.f) };
@@ -335,7 +227,6 @@ AnimationStepResult Animation::step(float const dt)
     {
     case AnimationType::slide:
     {
-        auto const p = ease(definition, t);
         auto const result = slide(p, from, to, real_size);
         clip_area.top_left.x = geom::X { result.position.x };
         clip_area.top_left.y = geom::Y { result.position.y };
@@ -352,7 +243,6 @@ AnimationStepResult Animation::step(float const dt)
     }
     case AnimationType::grow:
     {
-        auto p = ease(definition, t);
         glm::vec3 translate(
             (float)to.size.width.as_value() / 2.f,
             (float)to.size.height.as_value() / 2.f,
@@ -367,7 +257,7 @@ AnimationStepResult Animation::step(float const dt)
     }
     case AnimationType::shrink:
     {
-        auto p = 1.f - ease(definition, t);
+        auto const remaining = 1.f - p;
         glm::vec3 translate(
             (float)to.size.width.as_value() / 2.f,
             (float)to.size.height.as_value() / 2.f,
@@ -376,7 +266,7 @@ AnimationStepResult Animation::step(float const dt)
         glm::mat4 transform = glm::translate(
             glm::scale(
                 glm::translate(translate),
-                glm::vec3(p, p, 1.f)),
+                glm::vec3(remaining, remaining, 1.f)),
             inverse_translate);
         return { handle, false, to, std::nullopt, std::nullopt, transform };
     }
@@ -391,14 +281,37 @@ void Animation::set_current_size(mir::geometry::Size const& size)
     real_size = size;
 }
 
-void Animation::mark_for_great_animator_in_the_sky()
+void Animator::EaseGroup::push_back(std::shared_ptr<Animation> const& animation)
 {
-    should_leave_this_animator_for_the_great_animator_in_the_sky = true;
+    animations.push_back(animation);
+    runtime.push_back(animation->get_runtime_seconds());
+    duration.push_back(animation->get_definition().duration_seconds);
+    progress.push_back(0.f);
+    eased.push_back(0.f);
 }
 
-bool Animation::is_going_to_great_animator_in_the_sky() const
+void Animator::EaseGroup::swap_remove(size_t index)
+{
+    auto const last = animations.size() - 1;
+    if (index != last)
+    {
+        animations[index] = std::move(animations[last]);
+        runtime[index] = runtime[last];
+        duration[index] = duration[last];
+        progress[index] = progress[last];
+        eased[index] = eased[last];
+    }
+
+    animations.pop_back();
+    runtime.pop_back();
+    duration.pop_back();
+    progress.pop_back();
+    eased.pop_back();
+}
+
+Animator::Animator(AnimatorStorage storage) :
+    storage { storage }
 {
-    return should_leave_this_animator_for_the_great_animator_in_the_sky;
 }
 
 AnimationHandle Animator::register_animateable()
@@ -406,60 +319,230 @@ AnimationHandle Animator::register_animateable()
     return next_handle++;
 }
 
-void Animator::append(std::shared_ptr<Animation> const& animation)
+uint32_t Animator::advance_generation(AnimationHandle handle)
+{
+    if (handle >= generations.size())
+        generations.resize(handle + 1, 0);
+
+    // 0 is left for results that do not come from the animator
+    if (next_generation == 0)
+        next_generation++;
+    generations[handle] = next_generation++;
+    return generations[handle];
+}
+
+bool Animator::is_current(AnimationStepResult const& result)
+{
+    if (result.generation == 0)
+        return true;
+
+    std::lock_guard lock(producer_lock);
+    return result.handle < generations.size() && generations[result.handle] == result.generation;
+}
+
+void Animator::queue(Command command)
 {
-    std::lock_guard<std::mutex> lock(processing_lock);
-    for (auto& other : active)
     {
-        if (other->get_handle() == animation->get_handle())
-            other->mark_for_great_animator_in_the_sky();
+        std::lock_guard lock(producer_lock);
+        if (command.type == Command::Type::remove)
+            advance_generation(command.handle);
+        commands.push(std::move(command));
     }
-    active.push_back(animation);
-    animation->on_tick(animation->init());
-    cv.notify_one();
+
+    notify_queued();
 }
 
-void Animator::tick(float dt)
+void Animator::notify_queued()
 {
-    std::lock_guard<std::mutex> lock(processing_lock);
+    // The ticking thread checks for commands while holding the processing lock
+    // before it waits, so taking the lock here means that it cannot miss this
+    // notification.
+    {
+        std::lock_guard lock(processing_lock);
+    }
+    cv.notify_one();
+}
 
-    for (auto& item : active)
+void Animator::apply_commands()
+{
+    while (auto command = commands.pop())
     {
-        if (item->is_going_to_great_animator_in_the_sky())
-            continue;
+        switch (command->type)
+        {
+        case Command::Type::append:
+        {
+            remove(command->handle);
+            auto const& animation = command->animation;
+            auto& slot = slot_for(command->handle);
+            if (storage == AnimatorStorage::batched)
+            {
+                auto& group = group_for(animation->get_definition());
+                slot.group = static_cast<uint32_t>(&group - groups.data());
+                slot.index = static_cast<uint32_t>(group.animations.size());
+                group.push_back(animation);
+            }
+            else
+            {
+                slot.index = static_cast<uint32_t>(active.size());
+                active.push_back(animation);
+            }
+            count++;
+            break;
+        }
+        case Command::Type::remove:
+            remove(command->handle);
+            break;
+        case Command::Type::resize:
+        {
+            auto const& slot = slot_for(command->handle);
+            if (!slot.is_active())
+                break;
+
+            if (storage == AnimatorStorage::batched)
+                groups[slot.group].animations[slot.index]->set_current_size(command->size);
+            else
+                active[slot.index]->set_current_size(command->size);
+            break;
+        }
+        }
+    }
+}
 
-        auto result = item->step(dt);
+Animator::Slot& Animator::slot_for(AnimationHandle handle)
+{
+    if (handle >= slots.size())
+        slots.resize(handle + 1);
+    return slots[handle];
+}
 
-        item->on_tick(result);
+void Animator::remove(AnimationHandle handle)
+{
+    auto& slot = slot_for(handle);
+    if (!slot.is_active())
+        return;
 
-        if (result.is_complete)
-            item->mark_for_great_animator_in_the_sky();
+    auto const index = slot.index;
+    std::shared_ptr<Animation> const* moved = nullptr;
+    if (storage == AnimatorStorage::batched)
+    {
+        auto& group = groups[slot.group];
+        group.swap_remove(index);
+        if (index < group.animations.size())
+            moved = &group.animations[index];
+    }
+    else
+    {
+        if (index != active.size() - 1)
+            active[index] = std::move(active.back());
+        active.pop_back();
+        if (index < active.size())
+            moved = &active[index];
     }
 
-    active.erase(std::remove_if(active.begin(), active.end(), [](std::shared_ptr<Animation> const& animation)
+    slot = {};
+    if (moved)
+        slots[(*moved)->get_handle()].index = index;
+    count--;
+}
+
+void Animator::append(std::shared_ptr<Animation> const& animation)
+{
+    AnimationStepResult initial;
     {
-        return animation->is_going_to_great_animator_in_the_sky();
-    }),
-        active.end());
+        // The generation is taken in the same critical section as the push, so
+        // that the last append to reach the ticking thread is the current one
+        std::lock_guard lock(producer_lock);
+        animation->generation = advance_generation(animation->get_handle());
+        initial = animation->init();
+        initial.generation = animation->generation;
+        commands.push({ Command::Type::append, animation->get_handle(), animation, {} });
+    }
+
+    notify_queued();
+    animation->on_init(initial);
 }
 
-void Animator::set_size_hack(AnimationHandle handle, mir::geometry::Size const& size)
+void Animator::tick(float dt)
 {
-    std::lock_guard<std::mutex> lock(processing_lock);
+    apply_commands();
+    if (storage == AnimatorStorage::batched)
+        tick_batched(dt);
+    else
+        tick_objects(dt);
+}
 
-    for (auto& animation : active)
+void Animator::tick_objects(float dt)
+{
+    // A finished animation is replaced by the last one, which has not been
+    // stepped yet, so the index only moves on when nothing was removed.
+    for (size_t i = 0; i < active.size();)
     {
-        if (animation->get_handle() == handle)
-            animation->set_current_size(size);
+        auto const animation = active[i];
+        auto result = animation->step(dt);
+        result.generation = animation->generation;
+        animation->on_tick(result);
+        if (result.is_complete)
+            remove(animation->get_handle());
+        else
+            i++;
     }
 }
 
-void Animator::remove_by_animation_handle(miracle::AnimationHandle handle)
+void Animator::tick_batched(float dt)
+{
+    for (auto& group : groups)
+    {
+        auto const size = group.animations.size();
+        if (size == 0)
+            continue;
+
+        auto* const runtime = group.runtime.data();
+        auto const* const duration = group.duration.data();
+        auto* const progress = group.progress.data();
+        for (size_t i = 0; i < size; i++)
+        {
+            runtime[i] += dt;
+            progress[i] = runtime[i] >= duration[i] ? 1.f : runtime[i] / duration[i];
+        }
+
+        group.table->ease_batch(progress, group.eased.data(), size);
+
+        for (size_t i = 0; i < group.animations.size();)
+        {
+            auto& animation = *group.animations[i];
+            auto result = animation.step_to(group.runtime[i], group.eased[i]);
+            result.generation = animation.generation;
+            animation.on_tick(result);
+            if (result.is_complete)
+                remove(animation.get_handle());
+            else
+                i++;
+        }
+    }
+
+    // Configuration changes may leave groups behind that nothing uses anymore
+    if (count == 0)
+        groups.clear();
+}
+
+Animator::EaseGroup& Animator::group_for(AnimationDefinition const& definition)
 {
-    std::lock_guard<std::mutex> lock(processing_lock);
-    for (auto& animation : active)
+    for (auto& group : groups)
     {
-        if (animation->get_handle() == handle)
-            animation->mark_for_great_animator_in_the_sky();
+        if (group.type == definition.type && group.table->is_curve_of(definition))
+            return group;
     }
+
+    groups.push_back({ definition.type, ease_table(definition) });
+    return groups.back();
+}
+
+void Animator::set_size_hack(AnimationHandle handle, mir::geometry::Size const& size)
+{
+    queue({ Command::Type::resize, handle, nullptr, size });
+}
+
+void Animator::remove_by_animation_handle(miracle::AnimationHandle handle)
+{
+    queue({ Command::Type::remove, handle, nullptr, {} });
 }
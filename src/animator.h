@@ -19,13 +19,18 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define MIRACLEWM_ANIMATOR_H
 
 #include "animation_defintion.h"
+#include "spsc_queue.h"
+#include <atomic>
 #include <condition_variable>
 #include <functional>
 #include <glm/glm.hpp>
+#include <limits>
+#include <memory>
 #include <mir/geometry/rectangle.h>
 #include <mutex>
 #include <optional>
 #include <thread>
+#include <vector>
 
 namespace mir
 {
@@ -34,6 +39,8 @@ class ServerActionQueue;
 
 namespace miracle
 {
+class EaseTable;
+
 /// Unique handle provided to track animators
 typedef uint32_t AnimationHandle;
 
@@ -54,6 +61,10 @@ struct AnimationStepResult
     std::optional<glm::vec2> position;
     std::optional<glm::vec2> size;
     std::optional<glm::mat4> transform;
+
+    /// The generation of the animation that produced this result, or 0 when
+    /// the result did not come from the [Animator]. See [Animator::is_current].
+    uint32_t generation = 0;
 };
 
 class Animation
@@ -66,52 +77,177 @@ public:
         mir::geometry::Rectangle const& to,
         mir::geometry::Rectangle const& current);
 
-    Animation& operator=(Animation const& other) = default;
+    virtual ~Animation() = default;
 
     AnimationStepResult init();
     AnimationStepResult step(float const dt);
+
+    /// Moves the animation to [runtime_seconds], where [eased] is the eased
+    /// progress of the animation at that time.
+    AnimationStepResult step_to(float runtime_seconds, float eased);
     [[nodiscard]] AnimationHandle get_handle() const { return handle; }
+    [[nodiscard]] uint32_t get_generation() const { return generation; }
+    [[nodiscard]] AnimationDefinition const& get_definition() const { return definition; }
     float get_runtime_seconds() const { return runtime_seconds; }
     void set_current_size(mir::geometry::Size const& size);
-    void mark_for_great_animator_in_the_sky();
-    bool is_going_to_great_animator_in_the_sky() const;
+
+    /// Called with the initial state of the animation on the thread that
+    /// appends it.
+    virtual void on_init(AnimationStepResult const& result) { on_tick(result); }
+
+    /// Called with each step of the animation on the ticking thread.
     virtual void on_tick(AnimationStepResult const&) = 0;
 
 private:
+    friend class Animator;
+
     AnimationHandle handle;
+    uint32_t generation = 0;
     AnimationDefinition definition;
+    std::shared_ptr<EaseTable const> table;
     mir::geometry::Rectangle clip_area;
     mir::geometry::Rectangle from;
     mir::geometry::Rectangle to;
     mir::geometry::Size real_size;
     float runtime_seconds = 0.f;
-    bool should_leave_this_animator_for_the_great_animator_in_the_sky = false;
 };
 
-/// Manages the animation queue. If multiple animations are queued for a window,
-/// then the latest animation may override values from previous animations.
+/// Describes how the [Animator] stores its active animations.
+enum class AnimatorStorage
+{
+    /// Each animation is stepped on its own.
+    objects,
+
+    /// Animations that share an ease curve and type are stored together in
+    /// parallel arrays. Their progress is advanced and eased in one batch before
+    /// the results are dispatched.
+    batched
+};
+
+/// Manages the animation queue. A window has at most one active animation:
+/// appending an animation replaces the active animation with the same handle.
+///
+/// The animations are owned by the thread that calls [tick]. Other threads
+/// hand it commands through a lock-free queue, so they never wait for a tick
+/// or its callbacks to finish. A replaced or removed animation may therefore
+/// still be stepped once it is gone, so whoever applies the results checks
+/// [is_current] first.
 class Animator
 {
 public:
+    explicit Animator(AnimatorStorage storage = AnimatorStorage::batched);
+
     /// Animateable components must register with the Animator before being
     /// able to be animated.
     AnimationHandle register_animateable();
 
+    /// Steps every animation by [dt] seconds. Only one thread may tick.
     void tick(float dt);
 
+    /// Starts [animation], replacing the active animation of its handle. The
+    /// initial state of the animation is passed to [Animation::on_init] before
+    /// this returns.
     void append(std::shared_ptr<Animation> const&);
     void set_size_hack(AnimationHandle handle, mir::geometry::Size const& size);
+
+    /// Removes the animation of [handle]. None of its results are current
+    /// after this returns.
     void remove_by_animation_handle(AnimationHandle handle);
-    bool has_animations() const { return !active.empty(); }
+
+    /// True unless [result] came from an animation that has since been replaced
+    /// or removed.
+    bool is_current(AnimationStepResult const& result);
+
+    /// Called from the ticking thread.
+    bool has_animations() const { return count > 0 || !commands.empty(); }
+
+    /// Guards the hand-off between threads that queue commands and the
+    /// ticking thread waiting on [get_cv]. It is never held during a tick.
     std::condition_variable& get_cv() { return cv; }
     std::mutex& get_lock() { return processing_lock; }
 
 private:
+    /// The active animations that share an ease curve and type.
+    struct EaseGroup
+    {
+        AnimationType type;
+        std::shared_ptr<EaseTable const> table;
+        std::vector<std::shared_ptr<Animation>> animations;
+        std::vector<float> runtime;
+        std::vector<float> duration;
+        std::vector<float> progress;
+        std::vector<float> eased;
+
+        void push_back(std::shared_ptr<Animation> const&);
+        void swap_remove(size_t index);
+    };
+
+    /// Where the active animation of a handle is stored. [group] is unused by
+    /// the objects storage.
+    struct Slot
+    {
+        static constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+
+        uint32_t group = none;
+        uint32_t index = none;
+
+        [[nodiscard]] bool is_active() const { return index != none; }
+    };
+
+    struct Command
+    {
+        enum class Type
+        {
+            append,
+            remove,
+            resize
+        };
+
+        Type type;
+        AnimationHandle handle;
+        std::shared_ptr<Animation> animation;
+        mir::geometry::Size size;
+    };
+
+    void queue(Command command);
+
+    /// Wakes the ticking thread once a command has been queued.
+    void notify_queued();
+    void apply_commands();
+    void tick_objects(float dt);
+    void tick_batched(float dt);
+    EaseGroup& group_for(AnimationDefinition const&);
+    Slot& slot_for(AnimationHandle);
+
+    /// Removes the active animation of [handle], if any, moving the last
+    /// animation of its storage into its place.
+    void remove(AnimationHandle handle);
+
+    AnimatorStorage storage;
+    SpscQueue<Command> commands;
+
+    /// The generation of the latest animation appended to each handle, indexed
+    /// by [AnimationHandle]. Appending or removing an animation moves the
+    /// handle on to a new generation, so the results of earlier animations are
+    /// no longer current. Guarded by [producer_lock], which also serializes
+    /// pushes to [commands].
+    std::vector<uint32_t> generations;
+    uint32_t next_generation = 1;
+    std::mutex producer_lock;
+
+    /// Moves [handle] on to a new generation. Called with [producer_lock] held.
+    uint32_t advance_generation(AnimationHandle handle);
+
     std::vector<std::shared_ptr<Animation>> active;
+    std::vector<EaseGroup> groups;
+
+    /// Indexed by [AnimationHandle].
+    std::vector<Slot> slots;
+    size_t count = 0;
     std::thread run_thread;
     std::condition_variable cv;
     std::mutex processing_lock;
-    AnimationHandle next_handle = 1;
+    std::atomic<AnimationHandle> next_handle = 1;
 };
 
 } // miracle
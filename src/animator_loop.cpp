@@ -17,43 +17,113 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "animator_loop.h"
 #include "animator.h"
+#include "config.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <mir/log.h>
 #include <mir/server_action_queue.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
 
 using namespace miracle;
-using namespace std::chrono_literals;
 
-ThreadedAnimatorLoop::ThreadedAnimatorLoop(std::shared_ptr<Animator> const& animator) :
-    animator { animator }
+namespace
 {
+/// The refresh rate that is assumed until an output reports its own.
+constexpr double default_refresh_rate = 60.0;
+
+void arm_timer(int fd, std::chrono::nanoseconds period)
+{
+    auto const seconds = std::chrono::duration_cast<std::chrono::seconds>(period);
+    timespec const interval {
+        static_cast<time_t>(seconds.count()),
+        static_cast<long>((period - seconds).count())
+    };
+
+    // A zero interval disarms the timer
+    itimerspec const spec { interval, interval };
+    if (timerfd_settime(fd, 0, &spec, nullptr) < 0)
+        mir::log_error("Unable to arm the animation timer: %s", strerror(errno));
+}
 }
 
-ThreadedAnimatorLoop::~ThreadedAnimatorLoop()
+RefreshPacedAnimatorLoop::RefreshPacedAnimatorLoop(
+    std::shared_ptr<Animator> const& animator,
+    std::shared_ptr<Config> const& config) :
+    animator { animator },
+    config { config },
+    timer_fd { timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC) }
+{
+    if (timer_fd < 0)
+        mir::log_error("Unable to create the animation timer: %s", strerror(errno));
+}
+
+RefreshPacedAnimatorLoop::~RefreshPacedAnimatorLoop()
 {
     stop();
 }
 
-void ThreadedAnimatorLoop::start()
+void RefreshPacedAnimatorLoop::start()
 {
+    running = true;
     run_thread = std::thread([this]()
     { run(); });
 }
 
-void ThreadedAnimatorLoop::stop()
+void RefreshPacedAnimatorLoop::stop()
 {
-    if (!running)
-        return;
+    {
+        std::lock_guard lock(animator->get_lock());
+        if (!running)
+            return;
 
-    running = false;
+        running = false;
+    }
+
+    animator->get_cv().notify_all();
     run_thread.join();
 }
 
-void ThreadedAnimatorLoop::run()
+void RefreshPacedAnimatorLoop::set_refresh_rate(int output_id, double refresh_rate)
 {
-    using clock = std::chrono::high_resolution_clock;
-    constexpr std::chrono::nanoseconds timestep(16ms);
+    std::lock_guard lock(refresh_rates_mutex);
+    refresh_rates[output_id] = refresh_rate;
+}
+
+void RefreshPacedAnimatorLoop::remove_output(int output_id)
+{
+    std::lock_guard lock(refresh_rates_mutex);
+    refresh_rates.erase(output_id);
+}
+
+std::chrono::nanoseconds RefreshPacedAnimatorLoop::tick_period() const
+{
+    double rate = 0;
+    {
+        std::lock_guard lock(refresh_rates_mutex);
+        for (auto const& [id, refresh_rate] : refresh_rates)
+            rate = std::max(rate, refresh_rate);
+    }
+
+    if (rate <= 0)
+        rate = default_refresh_rate;
+
+    auto const max_rate = config->rendering().max_animation_rate;
+    if (max_rate > 0)
+        rate = std::min(rate, static_cast<double>(max_rate));
+
+    return std::chrono::nanoseconds(static_cast<int64_t>(1e9 / rate));
+}
+
+void RefreshPacedAnimatorLoop::run()
+{
+    using clock = std::chrono::steady_clock;
     auto last_time = clock::now();
-    running = true;
+    auto report_time = last_time;
+    int ticks = 0;
+    std::chrono::nanoseconds armed_period { 0 };
 
     while (running)
     {
@@ -61,15 +131,53 @@ void ThreadedAnimatorLoop::run()
             std::unique_lock lock(animator->get_lock());
             if (!animator->has_animations())
             {
-                animator->get_cv().wait(lock);
+                if (timer_fd >= 0 && armed_period.count() != 0)
+                {
+                    arm_timer(timer_fd, std::chrono::nanoseconds { 0 });
+                    armed_period = std::chrono::nanoseconds { 0 };
+                }
+
+                animator->get_cv().wait(lock, [this]()
+                { return !running || animator->has_animations(); });
+                if (!running)
+                    break;
+
                 last_time = clock::now();
+                report_time = last_time;
+                ticks = 0;
             }
         }
 
-        delta_time = clock::now() - last_time;
-        last_time = clock::now();
-        animator->tick(delta_time.count());
-        std::this_thread::sleep_for(1ms);
+        // The period is checked on every tick so that outputs that are added or
+        // changed while an animation is running are taken into account.
+        auto const period = tick_period();
+        if (timer_fd < 0)
+            std::this_thread::sleep_for(period);
+        else if (period != armed_period)
+        {
+            arm_timer(timer_fd, period);
+            armed_period = period;
+        }
+
+        uint64_t expirations;
+        if (timer_fd >= 0 && read(timer_fd, &expirations, sizeof(expirations)) < 0 && errno != EINTR)
+        {
+            mir::log_error("Unable to wait on the animation timer: %s", strerror(errno));
+            break;
+        }
+
+        auto const now = clock::now();
+        animator->tick(std::chrono::duration<float>(now - last_time).count());
+        last_time = now;
+        ticks++;
+
+        auto const since_report = std::chrono::duration<double>(now - report_time);
+        if (since_report.count() >= 1.0)
+        {
+            mir::log_debug("Animator ticked %.1f times per second", ticks / since_report.count());
+            report_time = now;
+            ticks = 0;
+        }
     }
 }
 
@@ -18,9 +18,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef MIRACLEWM_ANIMATOR_LOOP_H
 #define MIRACLEWM_ANIMATOR_LOOP_H
 
+#include <atomic>
 #include <chrono>
-#include <condition_variable>
+#include <map>
 #include <memory>
+#include <mir/fd.h>
+#include <mutex>
 #include <thread>
 
 namespace mir
@@ -31,6 +34,7 @@ class ServerActionQueue;
 namespace miracle
 {
 class Animator;
+class Config;
 
 class AnimatorLoop
 {
@@ -40,21 +44,32 @@ public:
     virtual void stop() = 0;
 };
 
-class ThreadedAnimatorLoop : public AnimatorLoop
+/// Steps animations once per refresh of the fastest output, waiting on a
+/// timerfd between ticks. The rate may be capped further by
+/// [RenderingConfiguration::max_animation_rate].
+class RefreshPacedAnimatorLoop : public AnimatorLoop
 {
 public:
-    explicit ThreadedAnimatorLoop(std::shared_ptr<Animator> const&);
-    ~ThreadedAnimatorLoop() override;
+    RefreshPacedAnimatorLoop(std::shared_ptr<Animator> const&, std::shared_ptr<Config> const&);
+    ~RefreshPacedAnimatorLoop() override;
     void start() override;
     void stop() override;
 
+    /// Sets the refresh rate of the output with [output_id] in Hz.
+    void set_refresh_rate(int output_id, double refresh_rate);
+    void remove_output(int output_id);
+
 private:
     void run();
+    [[nodiscard]] std::chrono::nanoseconds tick_period() const;
 
     std::shared_ptr<Animator> animator;
+    std::shared_ptr<Config> config;
+    mir::Fd timer_fd;
     std::thread run_thread;
-    bool running = false;
-    std::chrono::duration<float> delta_time;
+    std::atomic<bool> running = false;
+    mutable std::mutex refresh_rates_mutex;
+    std::map<int, double> refresh_rates;
 };
 
 class ServerActionQueueAnimatorLoop : public AnimatorLoop
@@ -23,6 +23,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "output_manager.h"
 #include "parent_container.h"
 #include "scratchpad.h"
+#include "window_controller.h"
 #include "window_helpers.h"
 #include "workspace_manager.h"
 
@@ -53,6 +54,12 @@ CommandController::CommandController(
 {
 }
 
+CommandController::Transaction::Transaction(CommandController& controller) :
+    lock { controller.mutex },
+    layout { *controller.window_controller }
+{
+}
+
 void CommandController::try_toggle_resize_mode()
 {
     std::lock_guard lock(mutex);
@@ -1110,4 +1117,63 @@ nlohmann::json CommandController::mode_to_json() const
         return {};
     }
     }
-}
\ No newline at end of file
+}
+
+namespace
+{
+nlohmann::json histogram_to_json(DurationHistogram const& histogram)
+{
+    auto const summary = histogram.summarize();
+    return {
+        { "count",   summary.count         },
+        { "mean_us", summary.mean.count() },
+        { "p50_us",  summary.p50.count()  },
+        { "p90_us",  summary.p90.count()  },
+        { "p99_us",  summary.p99.count()  },
+        { "max_us",  summary.max.count()  }
+    };
+}
+}
+
+nlohmann::json CommandController::frame_timings_json() const
+{
+    std::lock_guard lock(mutex);
+    nlohmann::json j = nlohmann::json::array();
+    for (auto const& timings : state->frame_timings()->all())
+    {
+        // Renderers only know the area that they draw, so this is how they are matched to outputs
+        auto const area = timings->area();
+        std::string name;
+        for (auto const& output : output_manager->outputs())
+        {
+            if (!output->is_defunct() && output->get_area() == area)
+            {
+                name = output->name();
+                break;
+            }
+        }
+
+        j.push_back({
+            { "name", name },
+            { "rect", { { "x", area.top_left.x.as_int() }, { "y", area.top_left.y.as_int() }, { "width", area.size.width.as_int() }, { "height", area.size.height.as_int() } } },
+            { "cpu", histogram_to_json(timings->cpu) },
+            { "gpu", timings->has_gpu_timings ? histogram_to_json(timings->gpu) : nlohmann::json(nullptr) },
+            { "commit_interval", histogram_to_json(timings->commit_interval) },
+            { "fullscreen_only_frames", timings->fullscreen_only_frames.load() }
+        });
+    }
+    return j;
+}
+
+nlohmann::json CommandController::layout_transactions_json() const
+{
+    std::lock_guard lock(mutex);
+    auto const& transactions = state->layout_transactions;
+    return {
+        { "enabled", config->rendering().transaction_timeout_ms > 0 },
+        { "timeout_ms", config->rendering().transaction_timeout_ms },
+        { "latency", histogram_to_json(transactions.latency) },
+        { "timed_out", transactions.timed_out.load() },
+        { "superseded", transactions.superseded.load() }
+    };
+}
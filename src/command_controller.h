@@ -21,6 +21,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "compositor_state.h"
 #include "direction.h"
 #include "output_interface.h"
+#include "window_controller.h"
+#include <mutex>
 #include <nlohmann/json.hpp>
 #include <optional>
 #include <string>
@@ -64,6 +66,19 @@ public:
         std::shared_ptr<Scratchpad> const& scratchpad,
         std::shared_ptr<OutputManager> const& output_manager);
 
+    /// Holds the policy lock and a layout transaction for as long as it lives, so
+    /// that the window changes of every command issued meanwhile are applied in
+    /// one batch. Key bindings and IPC commands are each run inside one.
+    class Transaction
+    {
+    public:
+        explicit Transaction(CommandController& controller);
+
+    private:
+        std::lock_guard<std::recursive_mutex> lock;
+        LayoutTransaction layout;
+    };
+
     bool try_request_horizontal();
     bool try_request_vertical();
     bool try_toggle_layout(bool cycle_through_all);
@@ -122,6 +137,8 @@ public:
     [[nodiscard]] nlohmann::json workspaces_json() const;
     [[nodiscard]] nlohmann::json workspace_to_json(uint32_t) const;
     [[nodiscard]] nlohmann::json mode_to_json() const;
+    [[nodiscard]] nlohmann::json frame_timings_json() const;
+    [[nodiscard]] nlohmann::json layout_transactions_json() const;
 
 private:
     std::shared_ptr<Config> config;
@@ -23,7 +23,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 using namespace miracle;
 
 CompositorState::CompositorState() :
-    render_data_manager_(std::make_unique<RenderDataManager>())
+    render_data_manager_(std::make_unique<RenderDataManager>()),
+    frame_timings_(std::make_unique<FrameTimingsRegistry>())
 {
 }
 
@@ -114,4 +115,9 @@ void CompositorState::mode(WindowManagerMode next)
 RenderDataManager* CompositorState::render_data_manager() const
 {
     return render_data_manager_.get();
-}
\ No newline at end of file
+}
+
+FrameTimingsRegistry* CompositorState::frame_timings() const
+{
+    return frame_timings_.get();
+}
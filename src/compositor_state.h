@@ -19,6 +19,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define MIRACLE_WM_COMPOSITOR_STATE_H
 
 #include "container.h"
+#include "frame_timings.h"
 #include "render_data_manager.h"
 
 #include <algorithm>
@@ -46,6 +47,31 @@ enum class WindowManagerMode
     moving
 };
 
+/// Counts the work done by layout passes, so that the number of containers
+/// that each operation recomputed can be reported.
+struct LayoutCounters
+{
+    /// Parents that recomputed the areas of their children, plus leaves that
+    /// committed a new area.
+    size_t recomputed = 0;
+
+    /// Parents whose subtree was skipped because nothing in it had changed.
+    size_t skipped = 0;
+};
+
+/// How long layout transactions waited for their clients to draw at their
+/// new sizes before they were shown.
+struct LayoutTransactionTimings
+{
+    DurationHistogram latency;
+
+    /// Transactions that were shown because their clients did not draw in time.
+    std::atomic<uint64_t> timed_out = 0;
+
+    /// Transactions that were shown early because another one began.
+    std::atomic<uint64_t> superseded = 0;
+};
+
 class CompositorState
 {
 public:
@@ -53,6 +79,14 @@ public:
     mir::geometry::Point cursor_position;
     uint32_t modifiers = 0;
     bool has_clicked_floating_window = false;
+    LayoutCounters layout_counters;
+    LayoutTransactionTimings layout_transactions;
+
+    /// Incremented whenever a container is added to, removed from or moved
+    /// within any tree, so that copies of a tree's shape know to rebuild. The
+    /// copies only refer to containers weakly, so a missed increment leaves a
+    /// copy out of date but never dangling.
+    uint64_t container_tree_version = 0;
 
     [[nodiscard]] std::shared_ptr<Container> focused_container() const;
 
@@ -68,12 +102,14 @@ public:
     WindowManagerMode mode() const;
     void mode(WindowManagerMode);
     RenderDataManager* render_data_manager() const;
+    FrameTimingsRegistry* frame_timings() const;
 
 private:
     std::weak_ptr<Container> focused;
     std::vector<std::weak_ptr<Container>> focus_order;
     WindowManagerMode mode_ = WindowManagerMode::normal;
     std::unique_ptr<RenderDataManager> render_data_manager_;
+    std::unique_ptr<FrameTimingsRegistry> frame_timings_;
 };
 }
 
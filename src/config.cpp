@@ -67,6 +67,32 @@ std::optional<MirKeyboardAction> from_string_keyboard_action(std::string const&
         return std::nullopt;
 }
 
+std::optional<BorderMode> from_string_border_mode(std::string const& mode)
+{
+    if (mode == "stencil")
+        return BorderMode::stencil;
+    else if (mode == "analytic")
+        return BorderMode::analytic;
+    else
+        return std::nullopt;
+}
+
+std::optional<RenderFilter> from_string_render_filter(std::string const& filter)
+{
+    if (filter == "none")
+        return RenderFilter::none;
+    else if (filter == "grayscale")
+        return RenderFilter::grayscale;
+    else if (filter == "protanopia")
+        return RenderFilter::protanopia;
+    else if (filter == "deuteranopia")
+        return RenderFilter::deuteranopia;
+    else if (filter == "tritanopia")
+        return RenderFilter::tritanopia;
+    else
+        return std::nullopt;
+}
+
 }
 
 uint Config::process_modifier(uint modifier) const
@@ -246,6 +272,8 @@ void FilesystemConfiguration::reload()
         read_move_modifier(config["move_modifier"]);
     if (config["drag_and_drop"])
         read_drag_and_drop(config["drag_and_drop"]);
+    if (config["rendering"])
+        read_rendering(config["rendering"]);
 
     error_handler.on_complete();
 }
@@ -774,6 +802,28 @@ void FilesystemConfiguration::read_drag_and_drop(YAML::Node const& node)
     }
 }
 
+void FilesystemConfiguration::read_rendering(YAML::Node const& node)
+{
+    try_parse_value(node, "damage_tracking", options.rendering.damage_tracking, true);
+    try_parse_value(node, "occlusion_culling", options.rendering.occlusion_culling, true);
+    try_parse_value(node, "fullscreen_fast_path", options.rendering.fullscreen_fast_path, true);
+    try_parse_value(node, "workspace_snapshots", options.rendering.workspace_snapshots, true);
+    try_parse_value(node, "max_animation_rate", options.rendering.max_animation_rate, true);
+    try_parse_value(node, "transaction_timeout_ms", options.rendering.transaction_timeout_ms, true);
+    if (node["border_mode"])
+    {
+        if (auto const mode = try_parse_string_to_optional_value<std::optional<BorderMode>>(
+                node["border_mode"], from_string_border_mode))
+            options.rendering.border_mode = mode.value();
+    }
+    if (node["filter"])
+    {
+        if (auto const filter = try_parse_string_to_optional_value<std::optional<RenderFilter>>(
+                node["filter"], from_string_render_filter))
+            options.rendering.filter = filter.value();
+    }
+}
+
 void FilesystemConfiguration::_watch(miral::MirRunner& runner)
 {
     if (no_config)
@@ -1037,6 +1087,11 @@ uint FilesystemConfiguration::move_modifier() const
     return options.move_modifier;
 }
 
+RenderingConfiguration FilesystemConfiguration::rendering() const
+{
+    return options.rendering;
+}
+
 FilesystemConfiguration::ConfigDetails::ConfigDetails()
 {
     const KeyCommand default_key_commands[static_cast<int>(DefaultKeyCommand::MAX)] = {
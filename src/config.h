@@ -21,6 +21,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "animation_defintion.h"
 #include "config_error_handler.h"
 #include "container.h"
+#include "render_filter.h"
 
 #include <atomic>
 #include <functional>
@@ -145,21 +146,62 @@ struct WorkspaceConfig
     std::optional<std::string> name;
 };
 
-enum class RenderFilter : int
-{
-    none,
-    grayscale,
-    protanopia,
-    deuteranopia,
-    tritanopia
-};
-
 struct DragAndDropConfiguration
 {
     bool enabled = true;
     uint modifiers = miracle_input_event_modifier_default | mir_input_event_modifier_shift;
 };
 
+enum class BorderMode
+{
+    /// The border is drawn after the surface as an enlarged quad that is
+    /// masked by the stencil buffer.
+    stencil,
+
+    /// The border is drawn together with the surface in a single pass.
+    /// This does not require a stencil buffer.
+    analytic
+};
+
+struct RenderingConfiguration
+{
+    /// When true, only the regions of the output that changed since the
+    /// buffer was last presented are repainted.
+    bool damage_tracking = false;
+
+    /// When true, renderables that are entirely hidden behind opaque
+    /// renderables are not drawn.
+    bool occlusion_culling = true;
+
+    /// How window borders are drawn. Borders are always drawn analytically
+    /// when the output does not have a stencil buffer.
+    BorderMode border_mode = BorderMode::stencil;
+
+    /// The color filter that is applied to every output.
+    RenderFilter filter = RenderFilter::none;
+
+    /// When true, an opaque surface that covers the whole output is drawn on
+    /// its own, without clearing or drawing anything beneath it.
+    bool fullscreen_fast_path = true;
+
+    /// When true, the workspaces of a workspace switch are drawn into
+    /// textures when the switch begins, and those textures are animated in
+    /// place of their windows. A workspace is drawn live again if one of its
+    /// windows changes during the switch.
+    bool workspace_snapshots = false;
+
+    /// The most times per second that animations are stepped. Animations are
+    /// otherwise stepped once per refresh of the fastest output. A value of
+    /// zero leaves the rate up to the outputs.
+    int max_animation_rate = 0;
+
+    /// The longest time, in milliseconds, that a relayout waits for the
+    /// clients that it resizes to draw at their new size before it is shown.
+    /// Until then, resized windows stay where they were, clipped to their old
+    /// size. A value of zero shows relayouts straight away.
+    int transaction_timeout_ms = 0;
+};
+
 class Config
 {
 public:
@@ -185,6 +227,7 @@ public:
     [[nodiscard]] virtual LayoutScheme get_default_layout_scheme() const = 0;
     [[nodiscard]] virtual DragAndDropConfiguration drag_and_drop() const = 0;
     [[nodiscard]] virtual uint move_modifier() const = 0;
+    [[nodiscard]] virtual RenderingConfiguration rendering() const = 0;
 
     virtual int register_listener(std::function<void(miracle::Config&)> const&) = 0;
     /// Register a listener on configuration change. A lower "priority" number signifies that the
@@ -226,6 +269,7 @@ public:
     [[nodiscard]] LayoutScheme get_default_layout_scheme() const override;
     [[nodiscard]] DragAndDropConfiguration drag_and_drop() const override;
     [[nodiscard]] uint move_modifier() const override;
+    [[nodiscard]] RenderingConfiguration rendering() const override;
     int register_listener(std::function<void(miracle::Config&)> const&) override;
     int register_listener(std::function<void(miracle::Config&)> const&, int priority) override;
     void unregister_listener(int handle) override;
@@ -253,6 +297,7 @@ private:
         std::vector<WorkspaceConfig> workspace_configs;
         uint move_modifier = miracle_input_event_modifier_default;
         DragAndDropConfiguration drag_and_drop;
+        RenderingConfiguration rendering;
     };
 
     struct ChangeListener
@@ -280,6 +325,7 @@ private:
     void read_enable_animations(YAML::Node const&);
     void read_move_modifier(YAML::Node const&);
     void read_drag_and_drop(YAML::Node const&);
+    void read_rendering(YAML::Node const&);
 
     static std::optional<uint> try_parse_modifier(std::string const& stringified_action_key);
 
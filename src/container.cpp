@@ -39,6 +39,15 @@ ContainerType miracle::container_type_from_string(std::string const& str)
         return ContainerType::none;
 }
 
+void Container::mark_layout_dirty()
+{
+    // The whole path is walked, rather than stopping at the first dirty ancestor,
+    // because a container that is not yet in a tree starts out dirty.
+    layout_dirty = true;
+    for (auto parent = get_parent().lock(); parent; parent = parent->get_parent().lock())
+        parent->layout_dirty = true;
+}
+
 glm::mat4 Container::get_workspace_transform() const
 {
     // TODO: Cache this transform, right now this is really inefficient.
@@ -136,12 +136,20 @@ public:
     bool is_lane();
     [[nodiscard]] float get_percent_of_parent() const;
 
+    /// Marks this container and each of its ancestors as having changes that the
+    /// next layout pass must visit. Subtrees that are not marked are skipped.
+    void mark_layout_dirty();
+    [[nodiscard]] bool is_layout_dirty() const { return layout_dirty; }
+
     static std::shared_ptr<LeafContainer> as_leaf(std::shared_ptr<Container> const&);
     static std::shared_ptr<ParentContainer> as_parent(std::shared_ptr<Container> const&);
     static std::shared_ptr<ContainerGroupContainer> as_group(std::shared_ptr<Container> const&);
 
 protected:
     [[nodiscard]] std::array<bool, (size_t)Direction::MAX> get_neighbors() const;
+
+    /// Cleared once the changes of this container have been committed.
+    bool layout_dirty = true;
 };
 
 }
@@ -0,0 +1,54 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "container_tree.h"
+#include "parent_container.h"
+
+using namespace miracle;
+
+void ContainerTree::rebuild(std::vector<std::shared_ptr<ParentContainer>> const& roots)
+{
+    nodes.clear();
+    for (auto const& root : roots)
+        append(root, no_node);
+}
+
+void ContainerTree::append(std::shared_ptr<Container> const& container, NodeId parent)
+{
+    auto const id = static_cast<NodeId>(nodes.size());
+    nodes.push_back({ container, container->get_type(), parent, id + 1 });
+    if (auto const lane = dynamic_cast<ParentContainer const*>(container.get()))
+    {
+        for (auto const& node : lane->get_sub_nodes())
+            append(node, id);
+    }
+
+    nodes[id].end = static_cast<NodeId>(nodes.size());
+}
+
+ContainerTree::NodeId ContainerTree::first_child(NodeId id) const
+{
+    return nodes[id].end > id + 1 ? id + 1 : no_node;
+}
+
+ContainerTree::NodeId ContainerTree::next_sibling(NodeId id) const
+{
+    auto const next = nodes[id].end;
+    auto const parent = nodes[id].parent;
+    auto const limit = parent == no_node ? static_cast<NodeId>(nodes.size()) : nodes[parent].end;
+    return next < limit ? next : no_node;
+}
@@ -0,0 +1,86 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLE_WM_CONTAINER_TREE_H
+#define MIRACLE_WM_CONTAINER_TREE_H
+
+#include "container.h"
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace miracle
+{
+
+/// A compact copy of the shape of a workspace's container trees.
+///
+/// Nodes are stored contiguously in pre-order, so a node's children directly
+/// follow it and its subtree ends at [Node::end]. A node's id is its index in
+/// this order, which stays the same until the shape of the tree next changes.
+/// Walking the shape is a linear scan that touches no reference counts.
+///
+/// Nodes refer to their containers weakly, so a copy that has fallen behind the
+/// tree it was built from may list containers that have moved, but never ones
+/// that have been destroyed. Reaching a container from its node locks a weak
+/// pointer, so a walk that visits containers still costs an atomic reference
+/// count operation for each of them.
+class ContainerTree
+{
+public:
+    using NodeId = uint32_t;
+    static constexpr NodeId no_node = std::numeric_limits<NodeId>::max();
+
+    struct Node
+    {
+        /// Expires when the container is destroyed.
+        std::weak_ptr<Container> container;
+        ContainerType type;
+        NodeId parent;
+
+        /// One past the last node in this node's subtree.
+        NodeId end;
+    };
+
+    /// Replaces the contents with [roots] and everything beneath them, in order.
+    void rebuild(std::vector<std::shared_ptr<ParentContainer>> const& roots);
+    void clear() { nodes.clear(); }
+
+    [[nodiscard]] size_t size() const { return nodes.size(); }
+    [[nodiscard]] bool empty() const { return nodes.empty(); }
+    Node const& operator[](NodeId id) const { return nodes[id]; }
+
+    /// \returns the first child of [id], or [no_node] if it has none
+    [[nodiscard]] NodeId first_child(NodeId id) const;
+
+    /// \returns the sibling after [id], or [no_node] if it is the last child
+    [[nodiscard]] NodeId next_sibling(NodeId id) const;
+
+    /// The nodes in pre-order.
+    auto begin() const { return nodes.begin(); }
+    auto end() const { return nodes.end(); }
+
+private:
+    std::vector<Node> nodes;
+
+    void append(std::shared_ptr<Container> const& container, NodeId parent);
+};
+
+} // miracle
+
+#endif // MIRACLE_WM_CONTAINER_TREE_H
@@ -0,0 +1,211 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "damage_tracker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace geom = mir::geometry;
+using namespace miracle;
+
+namespace
+{
+bool is_empty(geom::Rectangle const& r)
+{
+    return r.size.width.as_int() <= 0 || r.size.height.as_int() <= 0;
+}
+
+geom::Rectangle expand(geom::Rectangle const& r, int amount)
+{
+    return {
+        { r.top_left.x.as_int() - amount, r.top_left.y.as_int() - amount },
+        { r.size.width.as_int() + 2 * amount, r.size.height.as_int() + 2 * amount }
+    };
+}
+
+bool is_same(DamageTracker::Element const& lhs, DamageTracker::Element const& rhs)
+{
+    return lhs.id == rhs.id
+        && lhs.buffer_id == rhs.buffer_id
+        && lhs.screen_position == rhs.screen_position
+        && lhs.src_bounds == rhs.src_bounds
+        && lhs.clip_area == rhs.clip_area
+        && lhs.alpha == rhs.alpha
+        && lhs.shaped == rhs.shaped
+        && lhs.filter == rhs.filter
+        && lhs.transform == rhs.transform
+        && lhs.workspace_transform == rhs.workspace_transform
+        && lhs.outline_size == rhs.outline_size
+        && lhs.outline_color == rhs.outline_color;
+}
+}
+
+std::optional<geom::Rectangle> miracle::transformed_bounds(
+    geom::Rectangle const& rectangle,
+    glm::mat4 const& transform,
+    glm::mat4 const& workspace_transform)
+{
+    // This mirrors the vertex shader: vertices are transformed about the top left
+    // corner of the surface and then moved by the workspace transform.
+    auto const left = (float)rectangle.top_left.x.as_int();
+    auto const top = (float)rectangle.top_left.y.as_int();
+    auto const right = left + (float)rectangle.size.width.as_int();
+    auto const bottom = top + (float)rectangle.size.height.as_int();
+    glm::vec4 const origin(left, top, 0.f, 0.f);
+
+    float min_x = std::numeric_limits<float>::max();
+    float min_y = std::numeric_limits<float>::max();
+    float max_x = std::numeric_limits<float>::lowest();
+    float max_y = std::numeric_limits<float>::lowest();
+    for (auto const& corner : { glm::vec4(left, top, 0, 1), glm::vec4(right, top, 0, 1),
+             glm::vec4(left, bottom, 0, 1), glm::vec4(right, bottom, 0, 1) })
+    {
+        auto const p = workspace_transform * ((transform * (corner - origin)) + origin);
+        if (std::abs(p.z) > 1e-3f || std::abs(p.w - 1.f) > 1e-3f)
+            return std::nullopt;
+
+        min_x = std::min(min_x, p.x);
+        min_y = std::min(min_y, p.y);
+        max_x = std::max(max_x, p.x);
+        max_y = std::max(max_y, p.y);
+    }
+
+    auto const x = (int)std::floor(min_x);
+    auto const y = (int)std::floor(min_y);
+    return geom::Rectangle {
+        { x, y },
+        { (int)std::ceil(max_x) - x, (int)std::ceil(max_y) - y }
+    };
+}
+
+geom::Rectangle miracle::bounding_union(geom::Rectangle const& a, geom::Rectangle const& b)
+{
+    if (is_empty(a))
+        return b;
+    if (is_empty(b))
+        return a;
+
+    auto const left = std::min(a.top_left.x.as_int(), b.top_left.x.as_int());
+    auto const top = std::min(a.top_left.y.as_int(), b.top_left.y.as_int());
+    auto const right = std::max(
+        a.top_left.x.as_int() + a.size.width.as_int(),
+        b.top_left.x.as_int() + b.size.width.as_int());
+    auto const bottom = std::max(
+        a.top_left.y.as_int() + a.size.height.as_int(),
+        b.top_left.y.as_int() + b.size.height.as_int());
+    return {
+        { left, top },
+        { right - left, bottom - top }
+    };
+}
+
+void DamageTracker::begin_frame(geom::Rectangle const& next_viewport)
+{
+    frame_damage = { false, {} };
+    if (next_viewport != viewport)
+    {
+        viewport = next_viewport;
+        frame_damage.full = true;
+    }
+
+    current.clear();
+    last_added = nullptr;
+}
+
+void DamageTracker::damage_all()
+{
+    frame_damage.full = true;
+}
+
+std::optional<geom::Rectangle> DamageTracker::bounds_of(Element const& element)
+{
+    auto const area = expand(element.screen_position, element.outline_size);
+    auto bounds = transformed_bounds(area, element.transform, element.workspace_transform);
+    if (bounds && element.clip_area)
+    {
+        // The renderer scissors to the clip area after applying only the workspace transform
+        auto const clip = transformed_bounds(
+            expand(element.clip_area.value(), element.outline_size),
+            glm::mat4(1.f),
+            element.workspace_transform);
+        if (clip)
+            bounds = bounds->intersection_with(clip.value());
+    }
+
+    return bounds;
+}
+
+std::optional<geom::Rectangle> DamageTracker::add(Element const& element)
+{
+    auto const bounds = bounds_of(element);
+    TrackedElement tracked { element, bounds, last_added };
+    last_added = element.id;
+
+    auto const it = previous.find(element.id);
+    if (it == previous.end())
+        damage(bounds);
+    else if (!is_same(it->second.element, element) || it->second.below != tracked.below)
+    {
+        damage(it->second.bounds);
+        damage(bounds);
+    }
+
+    current.insert_or_assign(element.id, std::move(tracked));
+    return bounds;
+}
+
+std::optional<geom::Rectangle> DamageTracker::end_frame(int buffer_age)
+{
+    // Anything that is no longer drawn leaves damage where it used to be
+    for (auto const& [id, tracked] : previous)
+    {
+        if (!current.contains(id))
+            damage(tracked.bounds);
+    }
+
+    std::swap(previous, current);
+    std::rotate(history.rbegin(), history.rbegin() + 1, history.rend());
+    history[0] = frame_damage;
+
+    if (buffer_age <= 0 || buffer_age > max_buffer_age)
+        return std::nullopt;
+
+    geom::Rectangle region;
+    for (size_t i = 0; i < static_cast<size_t>(buffer_age); i++)
+    {
+        if (history[i].full)
+            return std::nullopt;
+        region = bounding_union(region, history[i].region);
+    }
+
+    return region;
+}
+
+void DamageTracker::damage(std::optional<geom::Rectangle> const& region)
+{
+    if (!region)
+    {
+        frame_damage.full = true;
+        return;
+    }
+
+    auto const visible = region->intersection_with(viewport);
+    if (!is_empty(visible))
+        frame_damage.region = bounding_union(frame_damage.region, visible);
+}
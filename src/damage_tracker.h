@@ -0,0 +1,130 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLE_WM_DAMAGE_TRACKER_H
+#define MIRACLE_WM_DAMAGE_TRACKER_H
+
+#include "render_data_manager.h"
+#include "render_filter.h"
+
+#include <array>
+#include <glm/glm.hpp>
+#include <mir/geometry/rectangle.h>
+#include <mir/graphics/buffer_id.h>
+#include <mir/graphics/renderable.h>
+#include <optional>
+#include <unordered_map>
+
+namespace miracle
+{
+
+/// Computes the screen-space bounds of a rectangle after applying the transforms
+/// that the renderer will apply to it. Returns std::nullopt if the transformed
+/// rectangle leaves the z=0 plane, in which case its bounds cannot be trusted.
+std::optional<mir::geometry::Rectangle> transformed_bounds(
+    mir::geometry::Rectangle const& rectangle,
+    glm::mat4 const& transform,
+    glm::mat4 const& workspace_transform);
+
+/// Returns the smallest rectangle containing both [a] and [b]. Empty rectangles
+/// are ignored.
+mir::geometry::Rectangle bounding_union(mir::geometry::Rectangle const& a, mir::geometry::Rectangle const& b);
+
+/// Accumulates per-renderable damage across frames so that the renderer can
+/// repaint only the regions of an output that changed since the buffer that
+/// it is about to draw into was last presented.
+///
+/// Usage per frame is:
+///   1. begin_frame
+///   2. add for every renderable, in the order that they are drawn
+///   3. end_frame with the age of the back buffer
+class DamageTracker
+{
+public:
+    /// The number of previous frames whose damage is remembered. Buffers older
+    /// than this are repainted in full.
+    static constexpr int max_buffer_age = 4;
+
+    /// Everything about a renderable that affects the pixels that it produces.
+    struct Element
+    {
+        mir::graphics::Renderable::ID id = nullptr;
+        mir::graphics::BufferID buffer_id;
+        mir::geometry::Rectangle screen_position;
+        mir::geometry::RectangleD src_bounds;
+        std::optional<mir::geometry::Rectangle> clip_area;
+        float alpha = 1.f;
+        bool shaped = false;
+        RenderFilter filter = RenderFilter::none;
+        glm::mat4 transform = glm::mat4(1.f);
+        glm::mat4 workspace_transform = glm::mat4(1.f);
+
+        /// Size of the outline drawn around the element, or 0 if it has none.
+        int outline_size = 0;
+        glm::vec4 outline_color = glm::vec4(0);
+    };
+
+    /// Computes everything that [element] may draw to, including its outline.
+    static std::optional<mir::geometry::Rectangle> bounds_of(Element const& element);
+
+    void begin_frame(mir::geometry::Rectangle const& viewport);
+
+    /// Forces the current frame to be repainted in full.
+    void damage_all();
+
+    /// Records [element] for the current frame, damaging its old and new bounds
+    /// if anything about it has changed since the previous frame.
+    /// \returns The screen-space bounds of the element, or std::nullopt if they are unknown
+    std::optional<mir::geometry::Rectangle> add(Element const& element);
+
+    /// Completes the current frame.
+    /// \param buffer_age The age of the buffer being drawn to, as reported by EGL_EXT_buffer_age.
+    ///                   0 means that the contents of the buffer are undefined.
+    /// \returns The region of the viewport that must be repainted, or std::nullopt if
+    ///          the whole viewport must be repainted. An empty rectangle means that
+    ///          nothing needs to be drawn.
+    std::optional<mir::geometry::Rectangle> end_frame(int buffer_age);
+
+private:
+    struct TrackedElement
+    {
+        Element element;
+        std::optional<mir::geometry::Rectangle> bounds;
+        mir::graphics::Renderable::ID below = nullptr;
+    };
+
+    struct Damage
+    {
+        bool full = true;
+        mir::geometry::Rectangle region;
+    };
+
+    void damage(std::optional<mir::geometry::Rectangle> const& region);
+
+    mir::geometry::Rectangle viewport;
+    std::unordered_map<mir::graphics::Renderable::ID, TrackedElement> previous;
+    std::unordered_map<mir::graphics::Renderable::ID, TrackedElement> current;
+    mir::graphics::Renderable::ID last_added = nullptr;
+    Damage frame_damage;
+
+    /// The damage of the most recent frames, with index 0 being the newest.
+    std::array<Damage, max_buffer_age> history;
+};
+
+} // miracle
+
+#endif // MIRACLE_WM_DAMAGE_TRACKER_H
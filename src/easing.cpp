@@ -0,0 +1,380 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "easing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace miracle;
+
+namespace
+{
+inline float square(float x)
+{
+    return x * x;
+}
+
+inline float cube(float x)
+{
+    return x * x * x;
+}
+
+inline float ease_out_bounce(AnimationDefinition const& definition, float x)
+{
+    if (x < 1 / definition.d1)
+        return definition.n1 * x * x;
+    else if (x < 2 / definition.d1)
+        return definition.n1 * square(x - 1.5f / definition.d1) + 0.75f;
+    else if (x < 2.5 / definition.d1)
+        return definition.n1 * square(x - 2.25f / definition.d1) + 0.9375f;
+    else
+        return definition.n1 * square(x - 2.625f / definition.d1) + 0.984375f;
+}
+
+/// The curves themselves, one instantiation per function, so that [ease] and
+/// [ease_batch] share a single definition of each.
+/// See https://easings.net/
+template <EaseFunction F>
+inline float ease_with(AnimationDefinition const& definition, float t)
+{
+    if constexpr (F == EaseFunction::linear)
+        return t;
+    else if constexpr (F == EaseFunction::ease_in_sine)
+        return 1 - cosf((t * (float)M_PI) / 2.f);
+    else if constexpr (F == EaseFunction::ease_in_out_sine)
+        return -(cosf((float)M_PI * t) - 1) / 2;
+    else if constexpr (F == EaseFunction::ease_out_sine)
+        return sinf((t * (float)M_PI) / 2.f);
+    else if constexpr (F == EaseFunction::ease_in_quad)
+        return t * t;
+    else if constexpr (F == EaseFunction::ease_out_quad)
+        return 1 - (1 - t) * (1 - t);
+    else if constexpr (F == EaseFunction::ease_in_out_quad)
+        return t < 0.5f ? 2 * t * t : 1 - square(-2 * t + 2) / 2;
+    else if constexpr (F == EaseFunction::ease_in_cubic)
+        return t * t * t;
+    else if constexpr (F == EaseFunction::ease_out_cubic)
+        return 1 - cube(1 - t);
+    else if constexpr (F == EaseFunction::ease_in_out_cubic)
+        return t < 0.5f ? 4 * t * t * t : 1 - cube(-2 * t + 2) / 2;
+    else if constexpr (F == EaseFunction::ease_in_quart)
+        return t * t * t * t;
+    else if constexpr (F == EaseFunction::ease_out_quart)
+        return 1 - square(square(1 - t));
+    else if constexpr (F == EaseFunction::ease_in_out_quart)
+        return t < 0.5f ? 8 * t * t * t * t : 1 - square(square(-2 * t + 2)) / 2;
+    else if constexpr (F == EaseFunction::ease_in_quint)
+        return t * t * t * t * t;
+    else if constexpr (F == EaseFunction::ease_out_quint)
+        return 1 - square(square(1 - t)) * (1 - t);
+    else if constexpr (F == EaseFunction::ease_in_out_quint)
+        return t < 0.5f ? 16 * t * t * t * t * t : 1 - square(square(-2 * t + 2)) * (-2 * t + 2) / 2;
+    else if constexpr (F == EaseFunction::ease_in_expo)
+        return t == 0 ? 0 : powf(2, 10 * t - 10);
+    else if constexpr (F == EaseFunction::ease_out_expo)
+        return t == 1 ? 1 : 1 - powf(2, -10 * t);
+    else if constexpr (F == EaseFunction::ease_in_out_expo)
+        return t == 0
+            ? 0
+            : t == 1
+            ? 1
+            : t < 0.5f ? powf(2, 20 * t - 10) / 2
+                       : (2 - powf(2, -20 * t + 10)) / 2;
+    else if constexpr (F == EaseFunction::ease_in_circ)
+        return 1 - sqrtf(1 - square(t));
+    else if constexpr (F == EaseFunction::ease_out_circ)
+        return sqrtf(1 - square(t - 1));
+    else if constexpr (F == EaseFunction::ease_in_out_circ)
+        return t < 0.5f
+            ? (1 - sqrtf(1 - square(2 * t))) / 2
+            : (sqrtf(1 - square(-2 * t + 2)) + 1) / 2;
+    else if constexpr (F == EaseFunction::ease_in_back)
+        return definition.c3 * t * t * t - definition.c1 * t * t;
+    else if constexpr (F == EaseFunction::ease_out_back)
+        return 1 + definition.c3 * cube(t - 1) + definition.c1 * square(t - 1);
+    else if constexpr (F == EaseFunction::ease_in_out_back)
+        return t < 0.5f
+            ? (square(2 * t) * ((definition.c2 + 1) * 2 * t - definition.c2)) / 2
+            : (square(2 * t - 2) * ((definition.c2 + 1) * (t * 2 - 2) + definition.c2) + 2) / 2;
+    else if constexpr (F == EaseFunction::ease_in_elastic)
+        return t == 0
+            ? 0
+            : t == 1
+            ? 1
+            : -powf(2, 10 * t - 10) * sinf((t * 10 - 10.75f) * definition.c4);
+    else if constexpr (F == EaseFunction::ease_out_elastic)
+        return t == 0
+            ? 0
+            : t == 1
+            ? 1
+            : powf(2, -10 * t) * sinf((t * 10 - 0.75f) * definition.c4) + 1;
+    else if constexpr (F == EaseFunction::ease_in_out_elastic)
+        return t == 0
+            ? 0
+            : t == 1
+            ? 1
+            : t < 0.5f
+            ? -(powf(2, 20 * t - 10) * sinf((20 * t - 11.125f) * definition.c5)) / 2
+            : (powf(2, -20 * t + 10) * sinf((20 * t - 11.125f) * definition.c5)) / 2 + 1;
+    else if constexpr (F == EaseFunction::ease_in_bounce)
+        return 1 - ease_out_bounce(definition, 1 - t);
+    else if constexpr (F == EaseFunction::ease_out_bounce)
+        return ease_out_bounce(definition, t);
+    else if constexpr (F == EaseFunction::ease_in_out_bounce)
+        return t < 0.5f
+            ? (1 - ease_out_bounce(definition, 1 - 2 * t)) / 2
+            : (1 + ease_out_bounce(definition, 2 * t - 1)) / 2;
+    else
+        return 1.f;
+}
+
+template <EaseFunction F>
+void ease_all_with(AnimationDefinition const& definition, float const* t, float* out, size_t count)
+{
+    // The definition is copied so that the compiler knows that writes to [out]
+    // cannot change the constants of the curve.
+    AnimationDefinition const local = definition;
+    for (size_t i = 0; i < count; i++)
+        out[i] = ease_with<F>(local, t[i]);
+}
+
+/// Calls [f] with the ease function of [definition] as a template argument.
+template <typename Func>
+auto with_ease_function(EaseFunction function, Func&& f)
+{
+    switch (function)
+    {
+    case EaseFunction::linear:
+        return f.template operator()<EaseFunction::linear>();
+    case EaseFunction::ease_in_sine:
+        return f.template operator()<EaseFunction::ease_in_sine>();
+    case EaseFunction::ease_out_sine:
+        return f.template operator()<EaseFunction::ease_out_sine>();
+    case EaseFunction::ease_in_out_sine:
+        return f.template operator()<EaseFunction::ease_in_out_sine>();
+    case EaseFunction::ease_in_quad:
+        return f.template operator()<EaseFunction::ease_in_quad>();
+    case EaseFunction::ease_out_quad:
+        return f.template operator()<EaseFunction::ease_out_quad>();
+    case EaseFunction::ease_in_out_quad:
+        return f.template operator()<EaseFunction::ease_in_out_quad>();
+    case EaseFunction::ease_in_cubic:
+        return f.template operator()<EaseFunction::ease_in_cubic>();
+    case EaseFunction::ease_out_cubic:
+        return f.template operator()<EaseFunction::ease_out_cubic>();
+    case EaseFunction::ease_in_out_cubic:
+        return f.template operator()<EaseFunction::ease_in_out_cubic>();
+    case EaseFunction::ease_in_quart:
+        return f.template operator()<EaseFunction::ease_in_quart>();
+    case EaseFunction::ease_out_quart:
+        return f.template operator()<EaseFunction::ease_out_quart>();
+    case EaseFunction::ease_in_out_quart:
+        return f.template operator()<EaseFunction::ease_in_out_quart>();
+    case EaseFunction::ease_in_quint:
+        return f.template operator()<EaseFunction::ease_in_quint>();
+    case EaseFunction::ease_out_quint:
+        return f.template operator()<EaseFunction::ease_out_quint>();
+    case EaseFunction::ease_in_out_quint:
+        return f.template operator()<EaseFunction::ease_in_out_quint>();
+    case EaseFunction::ease_in_expo:
+        return f.template operator()<EaseFunction::ease_in_expo>();
+    case EaseFunction::ease_out_expo:
+        return f.template operator()<EaseFunction::ease_out_expo>();
+    case EaseFunction::ease_in_out_expo:
+        return f.template operator()<EaseFunction::ease_in_out_expo>();
+    case EaseFunction::ease_in_circ:
+        return f.template operator()<EaseFunction::ease_in_circ>();
+    case EaseFunction::ease_out_circ:
+        return f.template operator()<EaseFunction::ease_out_circ>();
+    case EaseFunction::ease_in_out_circ:
+        return f.template operator()<EaseFunction::ease_in_out_circ>();
+    case EaseFunction::ease_in_back:
+        return f.template operator()<EaseFunction::ease_in_back>();
+    case EaseFunction::ease_out_back:
+        return f.template operator()<EaseFunction::ease_out_back>();
+    case EaseFunction::ease_in_out_back:
+        return f.template operator()<EaseFunction::ease_in_out_back>();
+    case EaseFunction::ease_in_elastic:
+        return f.template operator()<EaseFunction::ease_in_elastic>();
+    case EaseFunction::ease_out_elastic:
+        return f.template operator()<EaseFunction::ease_out_elastic>();
+    case EaseFunction::ease_in_out_elastic:
+        return f.template operator()<EaseFunction::ease_in_out_elastic>();
+    case EaseFunction::ease_in_bounce:
+        return f.template operator()<EaseFunction::ease_in_bounce>();
+    case EaseFunction::ease_out_bounce:
+        return f.template operator()<EaseFunction::ease_out_bounce>();
+    case EaseFunction::ease_in_out_bounce:
+        return f.template operator()<EaseFunction::ease_in_out_bounce>();
+    default:
+        return f.template operator()<EaseFunction::max>();
+    }
+}
+}
+
+float miracle::ease(AnimationDefinition const& definition, float t)
+{
+    return with_ease_function(definition.function, [&]<EaseFunction F>()
+    {
+        return ease_with<F>(definition, t);
+    });
+}
+
+void miracle::ease_batch(AnimationDefinition const& definition, float const* t, float* out, size_t count)
+{
+    with_ease_function(definition.function, [&]<EaseFunction F>()
+    {
+        ease_all_with<F>(definition, t, out, count);
+    });
+}
+
+namespace
+{
+/// True for the curves that call into powf, sinf or cosf. The remaining curves
+/// are cheaper to evaluate than to interpolate. Some of them, like the circular
+/// and bounce curves, also have kinks or infinite slopes that interpolation
+/// cannot follow closely.
+bool is_sampled(EaseFunction function)
+{
+    switch (function)
+    {
+    case EaseFunction::ease_in_sine:
+    case EaseFunction::ease_out_sine:
+    case EaseFunction::ease_in_out_sine:
+    case EaseFunction::ease_in_expo:
+    case EaseFunction::ease_out_expo:
+    case EaseFunction::ease_in_out_expo:
+    case EaseFunction::ease_in_elastic:
+    case EaseFunction::ease_out_elastic:
+    case EaseFunction::ease_in_out_elastic:
+        return true;
+    default:
+        return false;
+    }
+}
+}
+
+EaseTable::EaseTable(AnimationDefinition const& definition) :
+    definition { definition },
+    sampled { is_sampled(definition.function) }
+{
+    if (!sampled)
+        return;
+
+    std::array<float, resolution + 1> t;
+    for (size_t i = 0; i <= resolution; i++)
+        t[i] = static_cast<float>(i) / static_cast<float>(resolution);
+
+    // The expo and elastic curves are defined to be exactly 0 and 1 at their
+    // ends, but approach slightly different values. The outer samples take
+    // the values that the curve approaches, and the ends are kept separately.
+    t[0] = std::nextafter(0.f, 1.f);
+    t[resolution] = std::nextafter(1.f, 0.f);
+    miracle::ease_batch(definition, t.data(), samples.data(), samples.size());
+    start = miracle::ease(definition, 0.f);
+    end = miracle::ease(definition, 1.f);
+}
+
+inline float EaseTable::interpolate(float t) const
+{
+    if (t <= 0.f)
+        return start;
+    if (t >= 1.f)
+        return end;
+
+    auto const x = t * static_cast<float>(resolution);
+    auto const i = std::min(static_cast<size_t>(x), resolution - 1);
+    auto const fraction = x - static_cast<float>(i);
+    return samples[i] + (samples[i + 1] - samples[i]) * fraction;
+}
+
+float EaseTable::ease(float t) const
+{
+    if (!sampled)
+        return miracle::ease(definition, t);
+
+    return interpolate(t);
+}
+
+void EaseTable::ease_batch(float const* t, float* out, size_t count) const
+{
+    if (!sampled)
+    {
+        miracle::ease_batch(definition, t, out, count);
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++)
+        out[i] = interpolate(t[i]);
+}
+
+bool EaseTable::is_curve_of(AnimationDefinition const& other) const
+{
+    if (definition.function != other.function)
+        return false;
+
+    switch (definition.function)
+    {
+    case EaseFunction::ease_in_back:
+    case EaseFunction::ease_out_back:
+        return definition.c1 == other.c1 && definition.c3 == other.c3;
+    case EaseFunction::ease_in_out_back:
+        return definition.c2 == other.c2;
+    case EaseFunction::ease_in_elastic:
+    case EaseFunction::ease_out_elastic:
+        return definition.c4 == other.c4;
+    case EaseFunction::ease_in_out_elastic:
+        return definition.c5 == other.c5;
+    case EaseFunction::ease_in_bounce:
+    case EaseFunction::ease_out_bounce:
+    case EaseFunction::ease_in_out_bounce:
+        return definition.n1 == other.n1 && definition.d1 == other.d1;
+    default:
+        return true;
+    }
+}
+
+std::shared_ptr<EaseTable const> miracle::ease_table(AnimationDefinition const& definition)
+{
+    static std::mutex mutex;
+    static std::vector<std::shared_ptr<EaseTable const>> tables;
+
+    std::lock_guard lock(mutex);
+    for (auto const& table : tables)
+    {
+        if (table->is_curve_of(definition))
+            return table;
+    }
+
+    // Tables are only handed out under the lock, so one that only the cache
+    // holds cannot be picked up while it is dropped. Tables that animations
+    // still use stay alive through their own references.
+    if (tables.size() >= max_cached_ease_tables)
+    {
+        std::erase_if(tables, [](std::shared_ptr<EaseTable const> const& table)
+        {
+            return table.use_count() == 1;
+        });
+    }
+
+    tables.push_back(std::make_shared<EaseTable const>(definition));
+    return tables.back();
+}
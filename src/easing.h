@@ -0,0 +1,79 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLE_WM_EASING_H
+#define MIRACLE_WM_EASING_H
+
+#include "animation_defintion.h"
+
+#include <array>
+#include <cstddef>
+#include <memory>
+
+namespace miracle
+{
+
+/// Eases the progress [t] of an animation, in the range [0, 1], along the curve
+/// described by [definition].
+float ease(AnimationDefinition const& definition, float t);
+
+/// Eases [count] values of [t] into [out] along the curve described by
+/// [definition]. The curve is selected once for the whole batch, so the loop
+/// over the values is free of branches on the ease function and can be
+/// vectorized by the compiler.
+void ease_batch(AnimationDefinition const& definition, float const* t, float* out, size_t count);
+
+/// Samples of one ease curve at evenly spaced points. Easing with the table
+/// interpolates linearly between the two nearest samples instead of evaluating
+/// the curve, and stays within 1e-3 of [ease]. Only the curves that need
+/// transcendental functions are sampled; the others are evaluated directly.
+class EaseTable
+{
+public:
+    static constexpr size_t resolution = 1024;
+
+    explicit EaseTable(AnimationDefinition const& definition);
+
+    float ease(float t) const;
+    void ease_batch(float const* t, float* out, size_t count) const;
+
+    /// True if [other] describes the same curve as this table. Only the
+    /// constants that the ease function uses are compared.
+    [[nodiscard]] bool is_curve_of(AnimationDefinition const& other) const;
+
+private:
+    float interpolate(float t) const;
+
+    AnimationDefinition definition;
+    bool sampled;
+    float start = 0.f;
+    float end = 1.f;
+    std::array<float, resolution + 1> samples {};
+};
+
+/// Returns the table for the curve described by [definition]. Tables are built
+/// on first use and shared by every definition of the same curve, so a table is
+/// only built again when a curve with different constants is configured. At
+/// most [max_cached_ease_tables] tables are kept once nothing else holds them,
+/// so reloads that change the curve constants do not grow the cache forever.
+std::shared_ptr<EaseTable const> ease_table(AnimationDefinition const& definition);
+
+constexpr size_t max_cached_ease_tables = 32;
+
+} // miracle
+
+#endif // MIRACLE_WM_EASING_H
@@ -0,0 +1,144 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "frame_timings.h"
+
+#include <algorithm>
+
+using namespace miracle;
+
+namespace
+{
+/// Bucket [i] holds durations up to 10us * 1.25^i, which covers up to ~13s with
+/// a relative error of at most 25%.
+constexpr auto bucket_bounds = []()
+{
+    std::array<int64_t, DurationHistogram::bucket_count> bounds {};
+    double bound = 10'000.0;
+    for (auto& b : bounds)
+    {
+        b = static_cast<int64_t>(bound);
+        bound *= 1.25;
+    }
+    return bounds;
+}();
+
+std::chrono::microseconds to_microseconds(std::chrono::nanoseconds duration)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration);
+}
+}
+
+std::chrono::nanoseconds DurationHistogram::upper_bound(size_t bucket)
+{
+    return std::chrono::nanoseconds(bucket_bounds[std::min(bucket, bucket_count - 1)]);
+}
+
+size_t DurationHistogram::bucket_for(std::chrono::nanoseconds duration)
+{
+    auto const it = std::lower_bound(bucket_bounds.begin(), bucket_bounds.end(), duration.count());
+    return std::min(static_cast<size_t>(it - bucket_bounds.begin()), bucket_count - 1);
+}
+
+void DurationHistogram::record(std::chrono::nanoseconds duration)
+{
+    auto const ns = static_cast<uint64_t>(std::max<int64_t>(duration.count(), 0));
+    buckets[bucket_for(duration)].fetch_add(1, std::memory_order_relaxed);
+    total_ns.fetch_add(ns, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+
+    auto previous_max = max_ns.load(std::memory_order_relaxed);
+    while (ns > previous_max && !max_ns.compare_exchange_weak(previous_max, ns, std::memory_order_relaxed))
+    {
+    }
+}
+
+DurationHistogram::Summary DurationHistogram::summarize() const
+{
+    std::array<uint64_t, bucket_count> counts;
+    uint64_t total = 0;
+    for (size_t i = 0; i < bucket_count; i++)
+    {
+        counts[i] = buckets[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+
+    Summary summary;
+    summary.count = total;
+    if (total == 0)
+        return summary;
+
+    auto const max = std::chrono::nanoseconds(max_ns.load(std::memory_order_relaxed));
+    summary.max = to_microseconds(max);
+    summary.mean = to_microseconds(std::chrono::nanoseconds(total_ns.load(std::memory_order_relaxed) / total));
+
+    // Report the upper bound of the bucket holding each percentile, but never more than the maximum
+    auto const percentile = [&](double q)
+    {
+        auto const target = static_cast<uint64_t>(q * static_cast<double>(total - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < bucket_count; i++)
+        {
+            seen += counts[i];
+            if (seen >= target)
+                return to_microseconds(std::min(upper_bound(i), max));
+        }
+        return summary.max;
+    };
+
+    summary.p50 = percentile(0.5);
+    summary.p90 = percentile(0.9);
+    summary.p99 = percentile(0.99);
+    return summary;
+}
+
+void FrameTimings::area(mir::geometry::Rectangle const& next)
+{
+    x = next.top_left.x.as_int();
+    y = next.top_left.y.as_int();
+    width = next.size.width.as_int();
+    height = next.size.height.as_int();
+}
+
+mir::geometry::Rectangle FrameTimings::area() const
+{
+    return {
+        { x.load(), y.load() },
+        { width.load(), height.load() }
+    };
+}
+
+std::shared_ptr<FrameTimings> FrameTimingsRegistry::add()
+{
+    auto result = std::make_shared<FrameTimings>();
+    std::lock_guard lock(mutex);
+    std::erase_if(timings, [](auto const& t) { return t.expired(); });
+    timings.push_back(result);
+    return result;
+}
+
+std::vector<std::shared_ptr<FrameTimings const>> FrameTimingsRegistry::all()
+{
+    std::vector<std::shared_ptr<FrameTimings const>> result;
+    std::lock_guard lock(mutex);
+    for (auto const& t : timings)
+    {
+        if (auto locked = t.lock())
+            result.push_back(std::move(locked));
+    }
+    return result;
+}
@@ -0,0 +1,110 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLE_WM_FRAME_TIMINGS_H
+#define MIRACLE_WM_FRAME_TIMINGS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mir/geometry/rectangle.h>
+#include <mutex>
+#include <vector>
+
+namespace miracle
+{
+
+/// A histogram of durations with a fixed set of exponentially sized buckets.
+///
+/// Recording is wait-free, so a renderer can record every frame while another
+/// thread reads the histogram at any time. Reads are not a consistent snapshot
+/// and may miss samples that are recorded concurrently.
+class DurationHistogram
+{
+public:
+    static constexpr size_t bucket_count = 64;
+
+    struct Summary
+    {
+        uint64_t count = 0;
+        std::chrono::microseconds mean { 0 };
+        std::chrono::microseconds p50 { 0 };
+        std::chrono::microseconds p90 { 0 };
+        std::chrono::microseconds p99 { 0 };
+        std::chrono::microseconds max { 0 };
+    };
+
+    void record(std::chrono::nanoseconds duration);
+    [[nodiscard]] Summary summarize() const;
+
+    /// The largest duration that falls into [bucket]. The last bucket is unbounded.
+    static std::chrono::nanoseconds upper_bound(size_t bucket);
+    static size_t bucket_for(std::chrono::nanoseconds duration);
+
+private:
+    std::array<std::atomic<uint64_t>, bucket_count> buckets {};
+    std::atomic<uint64_t> count { 0 };
+    std::atomic<uint64_t> total_ns { 0 };
+    std::atomic<uint64_t> max_ns { 0 };
+};
+
+/// The frame timings of a single output.
+class FrameTimings
+{
+public:
+    /// Time that the render thread spent on the CPU in Renderer::render.
+    DurationHistogram cpu;
+
+    /// Time that the GPU spent on each frame. Only recorded when timer queries are supported.
+    DurationHistogram gpu;
+
+    /// Time between consecutive commits of the output.
+    DurationHistogram commit_interval;
+
+    std::atomic<bool> has_gpu_timings = false;
+
+    /// Frames in which only a single opaque fullscreen surface was drawn.
+    std::atomic<uint64_t> fullscreen_only_frames = 0;
+
+    void area(mir::geometry::Rectangle const&);
+    [[nodiscard]] mir::geometry::Rectangle area() const;
+
+private:
+    // Stored as separate atomics, as the area is only used to find the output by
+    // and rarely changes.
+    std::atomic<int> x = 0, y = 0, width = 0, height = 0;
+};
+
+/// Holds the [FrameTimings] of every renderer that is alive.
+class FrameTimingsRegistry
+{
+public:
+    /// Creates the timings for a new renderer. They are forgotten once the
+    /// returned pointer is released.
+    std::shared_ptr<FrameTimings> add();
+    [[nodiscard]] std::vector<std::shared_ptr<FrameTimings const>> all();
+
+private:
+    std::mutex mutex;
+    std::vector<std::weak_ptr<FrameTimings>> timings;
+};
+
+} // miracle
+
+#endif // MIRACLE_WM_FRAME_TIMINGS_H
@@ -0,0 +1,289 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "gl_state_tracker.h"
+
+#include <cstring>
+#include <glm/gtc/type_ptr.hpp>
+
+using namespace miracle;
+
+bool UniformShadow::update(GLint location, void const* components, size_t count)
+{
+    if (location < 0 || count > max_components)
+        return true;
+
+    auto const index = static_cast<size_t>(location);
+    if (index >= entries.size())
+        entries.resize(index + 1);
+
+    auto& entry = entries[index];
+    auto const bytes = count * sizeof(uint32_t);
+    if (entry.valid && memcmp(entry.components.data(), components, bytes) == 0)
+        return false;
+
+    entry.valid = true;
+    memcpy(entry.components.data(), components, bytes);
+    return true;
+}
+
+void UniformShadow::clear()
+{
+    entries.clear();
+}
+
+void GLStateTracker::invalidate()
+{
+    capabilities = {};
+    program.reset();
+    array_buffer.reset();
+    scissor_box.reset();
+    blend_func.reset();
+    blend_constant.reset();
+    stencil_function.reset();
+    stencil_operation.reset();
+    stencil_write_mask.reset();
+    vertex_attribs.clear();
+}
+
+GLStateTracker::Counters GLStateTracker::take_counters()
+{
+    auto const result = counters;
+    counters = {};
+    return result;
+}
+
+bool GLStateTracker::changed(bool differs)
+{
+    if (differs)
+        counters.issued++;
+    else
+        counters.elided++;
+    return differs;
+}
+
+void GLStateTracker::set_enabled(GLenum capability, bool enabled)
+{
+    std::optional<bool>* state = nullptr;
+    switch (capability)
+    {
+    case GL_BLEND:
+        state = &capabilities.blend;
+        break;
+    case GL_SCISSOR_TEST:
+        state = &capabilities.scissor_test;
+        break;
+    case GL_STENCIL_TEST:
+        state = &capabilities.stencil_test;
+        break;
+    default:
+        break;
+    }
+
+    if (state)
+    {
+        if (!changed(*state != enabled))
+            return;
+        *state = enabled;
+    }
+    else
+    {
+        counters.issued++;
+    }
+
+    if (enabled)
+        glEnable(capability);
+    else
+        glDisable(capability);
+}
+
+void GLStateTracker::use_program(GLuint next)
+{
+    if (!changed(program != next))
+        return;
+
+    program = next;
+    glUseProgram(next);
+}
+
+void GLStateTracker::bind_array_buffer(GLuint buffer)
+{
+    if (!changed(array_buffer != buffer))
+        return;
+
+    array_buffer = buffer;
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+}
+
+void GLStateTracker::scissor(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    std::array<GLint, 4> const box { x, y, width, height };
+    if (!changed(scissor_box != box))
+        return;
+
+    scissor_box = box;
+    glScissor(x, y, width, height);
+}
+
+void GLStateTracker::blend_func_separate(GLenum src_rgb, GLenum dst_rgb, GLenum src_alpha, GLenum dst_alpha)
+{
+    std::array<GLenum, 4> const func { src_rgb, dst_rgb, src_alpha, dst_alpha };
+    if (!changed(blend_func != func))
+        return;
+
+    blend_func = func;
+    glBlendFuncSeparate(src_rgb, dst_rgb, src_alpha, dst_alpha);
+}
+
+void GLStateTracker::blend_color(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+{
+    std::array<GLfloat, 4> const color { red, green, blue, alpha };
+    if (!changed(blend_constant != color))
+        return;
+
+    blend_constant = color;
+    glBlendColor(red, green, blue, alpha);
+}
+
+void GLStateTracker::stencil_func(GLenum func, GLint ref, GLuint mask)
+{
+    std::array<GLint, 3> const value { static_cast<GLint>(func), ref, static_cast<GLint>(mask) };
+    if (!changed(stencil_function != value))
+        return;
+
+    stencil_function = value;
+    glStencilFunc(func, ref, mask);
+}
+
+void GLStateTracker::stencil_op(GLenum stencil_fail, GLenum depth_fail, GLenum depth_pass)
+{
+    std::array<GLenum, 3> const value { stencil_fail, depth_fail, depth_pass };
+    if (!changed(stencil_operation != value))
+        return;
+
+    stencil_operation = value;
+    glStencilOp(stencil_fail, depth_fail, depth_pass);
+}
+
+void GLStateTracker::stencil_mask(GLuint mask)
+{
+    if (!changed(stencil_write_mask != mask))
+        return;
+
+    stencil_write_mask = mask;
+    glStencilMask(mask);
+}
+
+void GLStateTracker::enable_vertex_attrib_array(GLint index)
+{
+    if (index < 0)
+        return;
+
+    auto const slot = static_cast<size_t>(index);
+    if (slot >= vertex_attribs.size())
+        vertex_attribs.resize(slot + 1);
+
+    auto& attrib = vertex_attribs[slot];
+    if (!changed(!attrib.enabled))
+        return;
+
+    attrib.enabled = true;
+    glEnableVertexAttribArray(static_cast<GLuint>(index));
+}
+
+void GLStateTracker::vertex_attrib_pointer(GLint index, GLint size, GLenum type, GLsizei stride, size_t offset)
+{
+    if (index < 0)
+        return;
+
+    auto const slot = static_cast<size_t>(index);
+    if (slot >= vertex_attribs.size())
+        vertex_attribs.resize(slot + 1);
+
+    // The pointer is relative to the buffer that was bound when it was set
+    auto& attrib = vertex_attribs[slot];
+    auto const buffer = array_buffer.value_or(0);
+    if (!changed(!attrib.has_pointer || attrib.size != size || attrib.type != type
+            || attrib.stride != stride || attrib.offset != offset || attrib.buffer != buffer))
+        return;
+
+    attrib.has_pointer = true;
+    attrib.size = size;
+    attrib.type = type;
+    attrib.stride = stride;
+    attrib.offset = offset;
+    attrib.buffer = buffer;
+    glVertexAttribPointer(static_cast<GLuint>(index), size, type, GL_FALSE, stride, reinterpret_cast<void const*>(offset));
+}
+
+void GLStateTracker::disable_vertex_attrib_arrays()
+{
+    for (size_t i = 0; i < vertex_attribs.size(); i++)
+    {
+        if (vertex_attribs[i].enabled)
+        {
+            vertex_attribs[i].enabled = false;
+            counters.issued++;
+            glDisableVertexAttribArray(static_cast<GLuint>(i));
+        }
+    }
+}
+
+void GLStateTracker::uniform(UniformShadow& shadow, GLint location, GLint value)
+{
+    if (location < 0)
+        return;
+
+    if (changed(shadow.update(location, &value, 1)))
+        glUniform1i(location, value);
+}
+
+void GLStateTracker::uniform(UniformShadow& shadow, GLint location, GLfloat value)
+{
+    if (location < 0)
+        return;
+
+    if (changed(shadow.update(location, &value, 1)))
+        glUniform1f(location, value);
+}
+
+void GLStateTracker::uniform(UniformShadow& shadow, GLint location, glm::vec2 const& value)
+{
+    if (location < 0)
+        return;
+
+    if (changed(shadow.update(location, glm::value_ptr(value), 2)))
+        glUniform2f(location, value.x, value.y);
+}
+
+void GLStateTracker::uniform(UniformShadow& shadow, GLint location, glm::vec4 const& value)
+{
+    if (location < 0)
+        return;
+
+    if (changed(shadow.update(location, glm::value_ptr(value), 4)))
+        glUniform4fv(location, 1, glm::value_ptr(value));
+}
+
+void GLStateTracker::uniform(UniformShadow& shadow, GLint location, glm::mat4 const& value)
+{
+    if (location < 0)
+        return;
+
+    if (changed(shadow.update(location, glm::value_ptr(value), 16)))
+        glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+}
@@ -0,0 +1,140 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLE_WM_GL_STATE_TRACKER_H
+#define MIRACLE_WM_GL_STATE_TRACKER_H
+
+#include <GLES2/gl2.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <optional>
+#include <vector>
+
+namespace miracle
+{
+
+/// Remembers the last value that was uploaded to each uniform location of a program.
+class UniformShadow
+{
+public:
+    static constexpr size_t max_components = 16;
+
+    /// Records [count] 32-bit components as the value of [location].
+    /// \returns true if the value differs from the one that was last recorded
+    bool update(GLint location, void const* components, size_t count);
+
+    /// Forgets every recorded value.
+    void clear();
+
+private:
+    struct Entry
+    {
+        bool valid = false;
+        std::array<uint32_t, max_components> components;
+    };
+
+    std::vector<Entry> entries;
+};
+
+/// Shadows the GL state that the renderer touches so that only changes reach the
+/// driver. Calls that match the shadowed state are elided and counted.
+///
+/// The shadowed state is not shared with anyone else who uses the context, so it
+/// must be invalidated whenever the context may have been changed behind our back.
+class GLStateTracker
+{
+public:
+    struct Counters
+    {
+        uint64_t issued = 0;
+        uint64_t elided = 0;
+    };
+
+    /// Forgets all shadowed context state. Uniform values are kept, as they belong
+    /// to programs that only the renderer uses.
+    void invalidate();
+
+    /// Returns the counters accumulated since the previous call and resets them.
+    Counters take_counters();
+
+    void set_enabled(GLenum capability, bool enabled);
+    void use_program(GLuint program);
+    void bind_array_buffer(GLuint buffer);
+    void scissor(GLint x, GLint y, GLsizei width, GLsizei height);
+    void blend_func_separate(GLenum src_rgb, GLenum dst_rgb, GLenum src_alpha, GLenum dst_alpha);
+    void blend_color(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+    void stencil_func(GLenum func, GLint ref, GLuint mask);
+    void stencil_op(GLenum stencil_fail, GLenum depth_fail, GLenum depth_pass);
+    void stencil_mask(GLuint mask);
+
+    void enable_vertex_attrib_array(GLint index);
+    void vertex_attrib_pointer(GLint index, GLint size, GLenum type, GLsizei stride, size_t offset);
+
+    /// Disables every vertex attribute array that was enabled through the tracker.
+    void disable_vertex_attrib_arrays();
+
+    /// The uniform setters expect the program that owns [shadow] to be in use. Writes
+    /// to location -1 are dropped without being counted, as GL ignores them anyway.
+    void uniform(UniformShadow& shadow, GLint location, GLint value);
+    void uniform(UniformShadow& shadow, GLint location, GLfloat value);
+    void uniform(UniformShadow& shadow, GLint location, glm::vec2 const& value);
+    void uniform(UniformShadow& shadow, GLint location, glm::vec4 const& value);
+    void uniform(UniformShadow& shadow, GLint location, glm::mat4 const& value);
+
+    /// Records GL calls that are made directly, such as draws and clears.
+    void count_issued(uint64_t calls = 1) { counters.issued += calls; }
+
+private:
+    /// Returns true if the call must be issued, and counts it either way.
+    bool changed(bool differs);
+
+    struct Capabilities
+    {
+        std::optional<bool> blend;
+        std::optional<bool> scissor_test;
+        std::optional<bool> stencil_test;
+    };
+
+    struct VertexAttrib
+    {
+        bool enabled = false;
+        GLint size = 0;
+        GLenum type = 0;
+        GLsizei stride = 0;
+        size_t offset = 0;
+        GLuint buffer = 0;
+        bool has_pointer = false;
+    };
+
+    Capabilities capabilities;
+    std::optional<GLuint> program;
+    std::optional<GLuint> array_buffer;
+    std::optional<std::array<GLint, 4>> scissor_box;
+    std::optional<std::array<GLenum, 4>> blend_func;
+    std::optional<std::array<GLfloat, 4>> blend_constant;
+    std::optional<std::array<GLint, 3>> stencil_function;
+    std::optional<std::array<GLenum, 3>> stencil_operation;
+    std::optional<GLuint> stencil_write_mask;
+    std::vector<VertexAttrib> vertex_attribs;
+    Counters counters;
+};
+
+} // miracle
+
+#endif // MIRACLE_WM_GL_STATE_TRACKER_H
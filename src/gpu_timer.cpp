@@ -0,0 +1,114 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#define MIR_LOG_COMPONENT "GpuTimer"
+
+#include "gpu_timer.h"
+
+#include <EGL/egl.h>
+#include <cstring>
+#include <mir/log.h>
+
+using namespace miracle;
+
+namespace
+{
+template <typename T>
+T load(char const* name)
+{
+    return reinterpret_cast<T>(eglGetProcAddress(name));
+}
+}
+
+GpuTimer::GpuTimer()
+{
+    auto const extensions = reinterpret_cast<char const*>(glGetString(GL_EXTENSIONS));
+    if (!extensions || !strstr(extensions, "GL_EXT_disjoint_timer_query"))
+    {
+        mir::log_info("GL_EXT_disjoint_timer_query is not supported, so GPU frame times will not be recorded");
+        return;
+    }
+
+    gen_queries = load<PFNGLGENQUERIESEXTPROC>("glGenQueriesEXT");
+    delete_queries = load<PFNGLDELETEQUERIESEXTPROC>("glDeleteQueriesEXT");
+    begin_query = load<PFNGLBEGINQUERYEXTPROC>("glBeginQueryEXT");
+    end_query = load<PFNGLENDQUERYEXTPROC>("glEndQueryEXT");
+    get_query_object_uiv = load<PFNGLGETQUERYOBJECTUIVEXTPROC>("glGetQueryObjectuivEXT");
+    get_query_object_ui64v = load<PFNGLGETQUERYOBJECTUI64VEXTPROC>("glGetQueryObjectui64vEXT");
+    if (!gen_queries || !delete_queries || !begin_query || !end_query || !get_query_object_uiv || !get_query_object_ui64v)
+    {
+        mir::log_warning("GL_EXT_disjoint_timer_query is advertised, but its functions could not be loaded");
+        return;
+    }
+
+    gen_queries(query_count, queries.data());
+    supported = true;
+}
+
+GpuTimer::~GpuTimer()
+{
+    if (supported)
+        delete_queries(query_count, queries.data());
+}
+
+void GpuTimer::begin_frame()
+{
+    // If every query is still waiting on the GPU, this frame goes untimed
+    if (!supported || pending == query_count)
+        return;
+
+    begin_query(GL_TIME_ELAPSED_EXT, queries[next]);
+    in_frame = true;
+}
+
+void GpuTimer::end_frame()
+{
+    if (!in_frame)
+        return;
+
+    end_query(GL_TIME_ELAPSED_EXT);
+    in_frame = false;
+    next = (next + 1) % query_count;
+    pending++;
+}
+
+std::optional<std::chrono::nanoseconds> GpuTimer::take_result()
+{
+    if (pending == 0)
+        return std::nullopt;
+
+    auto const oldest = queries[(next + query_count - pending) % query_count];
+    GLuint available = GL_FALSE;
+    get_query_object_uiv(oldest, GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+    if (!available)
+        return std::nullopt;
+
+    pending--;
+
+    // A disjoint event (e.g. a frequency change) makes every result in flight meaningless
+    GLint disjoint = GL_FALSE;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    if (disjoint)
+    {
+        pending = 0;
+        return std::nullopt;
+    }
+
+    GLuint64 elapsed = 0;
+    get_query_object_ui64v(oldest, GL_QUERY_RESULT_EXT, &elapsed);
+    return std::chrono::nanoseconds(elapsed);
+}
@@ -0,0 +1,70 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLE_WM_GPU_TIMER_H
+#define MIRACLE_WM_GPU_TIMER_H
+
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <array>
+#include <chrono>
+#include <optional>
+
+namespace miracle
+{
+
+/// Measures the time that the GPU spends on each frame with GL_EXT_disjoint_timer_query.
+///
+/// Results are read back a few frames later so that the render thread never
+/// waits on the GPU. Must only be used while the renderer's context is current.
+class GpuTimer
+{
+public:
+    GpuTimer();
+    ~GpuTimer();
+    GpuTimer(GpuTimer const&) = delete;
+    GpuTimer& operator=(GpuTimer const&) = delete;
+
+    [[nodiscard]] bool is_supported() const { return supported; }
+
+    void begin_frame();
+    void end_frame();
+
+    /// Returns the duration of the oldest timed frame if its result is available.
+    /// Frames that were disturbed by a disjoint event are dropped.
+    std::optional<std::chrono::nanoseconds> take_result();
+
+private:
+    static constexpr size_t query_count = 4;
+
+    bool supported = false;
+    std::array<GLuint, query_count> queries {};
+    size_t next = 0;
+    size_t pending = 0;
+    bool in_frame = false;
+
+    PFNGLGENQUERIESEXTPROC gen_queries = nullptr;
+    PFNGLDELETEQUERIESEXTPROC delete_queries = nullptr;
+    PFNGLBEGINQUERYEXTPROC begin_query = nullptr;
+    PFNGLENDQUERYEXTPROC end_query = nullptr;
+    PFNGLGETQUERYOBJECTUIVEXTPROC get_query_object_uiv = nullptr;
+    PFNGLGETQUERYOBJECTUI64VEXTPROC get_query_object_ui64v = nullptr;
+};
+
+} // miracle
+
+#endif // MIRACLE_WM_GPU_TIMER_H
@@ -523,6 +523,16 @@ void Ipc::handle_command(miracle::Ipc::IpcClient& client, uint32_t payload_lengt
         send_reply(client, payload_type, to_string(policy->mode_to_json()));
         break;
     }
+    case IPC_GET_FRAME_TIMINGS:
+    {
+        send_reply(client, payload_type, to_string(policy->frame_timings_json()));
+        break;
+    }
+    case IPC_GET_LAYOUT_TRANSACTIONS:
+    {
+        send_reply(client, payload_type, to_string(policy->layout_transactions_json()));
+        break;
+    }
     case IPC_SEND_TICK:
     {
         const std::string msg = "{\"success\": true}";
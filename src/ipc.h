@@ -57,6 +57,10 @@ enum IpcType
     IPC_GET_INPUTS = 100,
     IPC_GET_SEATS = 101,
 
+    // miracle-specific command types
+    IPC_GET_FRAME_TIMINGS = 200,
+    IPC_GET_LAYOUT_TRANSACTIONS = 201,
+
     // Events sent from sway to clients. Events have the highest bits set.
     IPC_EVENT_WORKSPACE = ((1 << 31) | 0),
     IPC_EVENT_OUTPUT = ((1 << 31) | 1),
@@ -120,6 +120,8 @@ IpcCommandExecutor::IpcCommandExecutor(
 
 IpcValidationResult IpcCommandExecutor::process(miracle::IpcParseResult const& command_list)
 {
+    // Every command in the list reaches the scene as one batch
+    CommandController::Transaction transaction(*policy);
     IpcValidationResult result;
     for (auto const& command : command_list.commands)
     {
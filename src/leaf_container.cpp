@@ -143,13 +143,14 @@ LeafContainer::LeafContainer(
 
 LeafContainer::~LeafContainer()
 {
-    state->render_data_manager()->remove(*this);
+    state->render_data_manager()->remove(render_data_handle_);
 }
 
 void LeafContainer::associate_to_window(miral::Window const& in_window)
 {
     window_ = in_window;
-    state->render_data_manager()->add(*this);
+    state->render_data_manager()->remove(render_data_handle_);
+    render_data_handle_ = state->render_data_manager()->add(*this);
 }
 
 geom::Rectangle LeafContainer::get_logical_area() const
@@ -161,6 +162,7 @@ void LeafContainer::set_logical_area(geom::Rectangle const& target_rect, bool wi
 {
     next_logical_area = target_rect;
     next_with_animations = with_animations;
+    mark_layout_dirty();
 }
 
 std::weak_ptr<ParentContainer> LeafContainer::get_parent() const
@@ -180,6 +182,7 @@ void LeafContainer::set_parent(std::shared_ptr<ParentContainer> const& in_parent
 void LeafContainer::set_state(MirWindowState state)
 {
     next_state = state;
+    mark_layout_dirty();
 }
 
 geom::Rectangle LeafContainer::get_visible_area() const
@@ -483,12 +486,12 @@ void LeafContainer::on_focus_gained()
 {
     if (auto sh_parent = parent.lock())
         sh_parent->on_focus_gained();
-    state->render_data_manager()->focus_change(*this);
+    state->render_data_manager()->focus_change(render_data_handle_, *this);
 }
 
 void LeafContainer::on_focus_lost()
 {
-    state->render_data_manager()->focus_change(*this);
+    state->render_data_manager()->focus_change(render_data_handle_, *this);
 }
 
 void LeafContainer::on_move_to(geom::Point const&)
@@ -502,6 +505,7 @@ bool LeafContainer::is_fullscreen() const
 
 void LeafContainer::commit_changes()
 {
+    layout_dirty = false;
     if (next_state)
     {
         window_controller->change_state(window_, next_state.value());
@@ -519,6 +523,7 @@ void LeafContainer::commit_changes()
 
     if (next_logical_area)
     {
+        state->layout_counters.recomputed++;
         auto previous = get_visible_area();
         logical_area = next_logical_area.value();
         next_logical_area.reset();
@@ -531,6 +536,9 @@ void LeafContainer::commit_changes()
             window_controller->set_rectangle(window_, previous, next_visible_area, next_with_animations);
             next_with_animations = true;
         }
+
+        if (workspace)
+            workspace->advise_area_changed(*this);
     }
 }
 
@@ -582,6 +590,7 @@ WorkspaceInterface* LeafContainer::get_workspace() const
 void LeafContainer::set_workspace(miracle::WorkspaceInterface* in)
 {
     workspace = in;
+    state->render_data_manager()->workspace_change(render_data_handle_, *this);
 }
 
 OutputInterface* LeafContainer::get_output() const
@@ -603,7 +612,7 @@ void LeafContainer::set_transform(glm::mat4 transform_)
     {
         surface->set_transformation(transform_);
         transform = transform_;
-        state->render_data_manager()->transform_change(*this);
+        state->render_data_manager()->transform_change(render_data_handle_, *this);
     }
 }
 
@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "container.h"
 #include "layout_scheme.h"
+#include "render_data_manager.h"
 #include "scratchpad_state.h"
 #include "window_controller.h"
 
@@ -110,6 +111,7 @@ public:
     void scratchpad_state(ScratchpadState) override;
     LayoutScheme get_layout() const override;
     nlohmann::json to_json(bool is_workspace_visible) const override;
+    [[nodiscard]] RenderDataHandle const& render_data_handle() const { return render_data_handle_; }
 
     static std::shared_ptr<LeafContainer> handle_select(
         Container& from,
@@ -130,6 +132,7 @@ private:
     std::optional<MirWindowState> next_state;
     std::optional<MirDepthLayer> next_depth_layer;
     glm::mat4 transform = glm::mat4(1.f);
+    RenderDataHandle render_data_handle_;
     uint32_t animation_handle_ = 0;
     bool is_dragging_ = false;
     geom::Point dragged_position;
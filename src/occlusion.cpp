@@ -0,0 +1,155 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "occlusion.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace geom = mir::geometry;
+using namespace miracle;
+
+namespace
+{
+struct Box
+{
+    int left, top, right, bottom;
+
+    [[nodiscard]] bool empty() const { return left >= right || top >= bottom; }
+};
+
+Box to_box(geom::Rectangle const& r)
+{
+    return {
+        r.top_left.x.as_int(),
+        r.top_left.y.as_int(),
+        r.top_left.x.as_int() + r.size.width.as_int(),
+        r.top_left.y.as_int() + r.size.height.as_int()
+    };
+}
+
+/// True if [m] only scales and translates in x and y.
+bool is_axis_aligned(glm::mat4 const& m)
+{
+    return m[0][1] == 0.f && m[1][0] == 0.f
+        && m[0][0] > 0.f && m[1][1] > 0.f
+        && m[0][2] == 0.f && m[1][2] == 0.f && m[3][2] == 0.f
+        && m[0][3] == 0.f && m[1][3] == 0.f && m[3][3] == 1.f;
+}
+}
+
+std::optional<geom::Rectangle> miracle::opaque_bounds(
+    geom::Rectangle const& rectangle,
+    glm::mat4 const& transform,
+    glm::mat4 const& workspace_transform)
+{
+    if (!is_axis_aligned(transform) || !is_axis_aligned(workspace_transform))
+        return std::nullopt;
+
+    // This mirrors the vertex shader: vertices are transformed about the top left
+    // corner of the surface and then moved by the workspace transform.
+    auto const left = (float)rectangle.top_left.x.as_int();
+    auto const top = (float)rectangle.top_left.y.as_int();
+    glm::vec4 const origin(left, top, 0.f, 0.f);
+    glm::vec4 const bottom_right(
+        left + (float)rectangle.size.width.as_int(),
+        top + (float)rectangle.size.height.as_int(),
+        0.f,
+        1.f);
+
+    auto const p1 = workspace_transform * ((transform * (glm::vec4(left, top, 0.f, 1.f) - origin)) + origin);
+    auto const p2 = workspace_transform * ((transform * (bottom_right - origin)) + origin);
+
+    auto const x1 = (int)std::ceil(p1.x);
+    auto const y1 = (int)std::ceil(p1.y);
+    auto const x2 = (int)std::floor(p2.x);
+    auto const y2 = (int)std::floor(p2.y);
+    if (x2 <= x1 || y2 <= y1)
+        return std::nullopt;
+
+    return geom::Rectangle {
+        { x1, y1 },
+        { x2 - x1, y2 - y1 }
+    };
+}
+
+bool miracle::is_covered(geom::Rectangle const& rectangle, std::vector<geom::Rectangle> const& region)
+{
+    auto const initial = to_box(rectangle);
+    if (initial.empty())
+        return true;
+
+    // Subtract each rectangle of the region from what is left of [rectangle]. We are
+    // covered if nothing remains.
+    std::vector<Box> remaining = { initial };
+    std::vector<Box> next;
+    for (auto const& r : region)
+    {
+        auto const cover = to_box(r);
+        next.clear();
+        for (auto const& box : remaining)
+        {
+            if (cover.right <= box.left || cover.left >= box.right
+                || cover.bottom <= box.top || cover.top >= box.bottom)
+            {
+                next.push_back(box);
+                continue;
+            }
+
+            Box const top_part { box.left, box.top, box.right, cover.top };
+            Box const bottom_part { box.left, cover.bottom, box.right, box.bottom };
+            auto const middle_top = std::max(box.top, cover.top);
+            auto const middle_bottom = std::min(box.bottom, cover.bottom);
+            Box const left_part { box.left, middle_top, cover.left, middle_bottom };
+            Box const right_part { cover.right, middle_top, box.right, middle_bottom };
+            for (auto const& part : { top_part, bottom_part, left_part, right_part })
+            {
+                if (!part.empty())
+                    next.push_back(part);
+            }
+        }
+
+        std::swap(remaining, next);
+        if (remaining.empty())
+            return true;
+    }
+
+    return remaining.empty();
+}
+
+size_t miracle::find_occluded(std::vector<Occludable> const& elements, std::vector<bool>& occluded)
+{
+    occluded.assign(elements.size(), false);
+
+    size_t count = 0;
+    std::vector<geom::Rectangle> opaque_region;
+    for (auto i = elements.size(); i-- > 0;)
+    {
+        auto const& element = elements[i];
+        if (element.bounds && is_covered(element.bounds.value(), opaque_region))
+        {
+            occluded[i] = true;
+            count++;
+            continue;
+        }
+
+        if (element.opaque_area)
+            opaque_region.push_back(element.opaque_area.value());
+    }
+
+    return count;
+}
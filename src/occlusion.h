@@ -0,0 +1,60 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLE_WM_OCCLUSION_H
+#define MIRACLE_WM_OCCLUSION_H
+
+#include <glm/glm.hpp>
+#include <mir/geometry/rectangle.h>
+#include <optional>
+#include <vector>
+
+namespace miracle
+{
+
+/// Describes a single renderable for the purposes of occlusion culling.
+struct Occludable
+{
+    /// Everything that the renderable may draw to, including its outline. If
+    /// unknown, the renderable is never culled.
+    std::optional<mir::geometry::Rectangle> bounds;
+
+    /// The area that the renderable is guaranteed to cover with fully opaque
+    /// pixels, if any.
+    std::optional<mir::geometry::Rectangle> opaque_area;
+};
+
+/// Computes the area covered by [rectangle] after the renderer's transforms have
+/// been applied, rounded inwards. Returns std::nullopt if the transforms do not
+/// keep the rectangle axis-aligned.
+std::optional<mir::geometry::Rectangle> opaque_bounds(
+    mir::geometry::Rectangle const& rectangle,
+    glm::mat4 const& transform,
+    glm::mat4 const& workspace_transform);
+
+/// Returns true if [rectangle] is entirely covered by the union of [region].
+bool is_covered(mir::geometry::Rectangle const& rectangle, std::vector<mir::geometry::Rectangle> const& region);
+
+/// Walks [elements] front-to-back, where the last element is the topmost, and
+/// marks the elements that are entirely hidden behind opaque elements above them.
+/// \param occluded Resized to match [elements] and set to true for each hidden element
+/// \returns The number of hidden elements
+size_t find_occluded(std::vector<Occludable> const& elements, std::vector<bool>& occluded);
+
+} // miracle
+
+#endif // MIRACLE_WM_OCCLUSION_H
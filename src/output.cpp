@@ -22,6 +22,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "compositor_state.h"
 #include "config.h"
 #include "leaf_container.h"
+#include "policy.h"
 #include "vector_helpers.h"
 #include "window_helpers.h"
 
@@ -30,6 +31,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <glm/gtx/transform.hpp>
 #include <memory>
 #include <mir/log.h>
+#include <mir/server_action_queue.h>
 #include <miral/toolkit_event.h>
 #include <miral/window_info.h>
 #include <miral/zone.h>
@@ -43,7 +45,9 @@ Output::Output(
     std::shared_ptr<CompositorState> const& state,
     std::shared_ptr<Config> const& config,
     std::shared_ptr<WindowController> const& window_controller,
-    std::shared_ptr<Animator> const& animator) :
+    std::shared_ptr<Animator> const& animator,
+    std::shared_ptr<mir::ServerActionQueue> const& server_action_queue,
+    Policy* policy) :
     name_ { std::move(name) },
     id_ { id },
     area { area },
@@ -51,6 +55,8 @@ Output::Output(
     config { config },
     window_controller { window_controller },
     animator { animator },
+    server_action_queue { server_action_queue },
+    policy { policy },
     handle { animator->register_animateable() }
 {
 }
@@ -58,6 +64,7 @@ Output::Output(
 Output::~Output()
 {
     animator->remove_by_animation_handle(handle);
+    end_workspace_switch();
 }
 
 WorkspaceInterface* Output::active() const
@@ -84,26 +91,8 @@ std::shared_ptr<Container> Output::intersect_leaf(float x, float y, bool ignore_
         return nullptr;
     }
 
-    auto workspace = active_workspace.lock().get();
-    std::shared_ptr<Container> result = nullptr;
-    workspace->for_each_window([&](std::shared_ptr<Container> const& container)
-    {
-        if (ignore_selected && container == state->focused_container())
-            return false;
-
-        if (container->get_type() != ContainerType::leaf)
-            return false;
-
-        if (container->get_visible_area().contains(geom::Point(x, y)))
-        {
-            result = container;
-            return true;
-        }
-
-        return false;
-    });
-
-    return result;
+    auto const ignored = ignore_selected ? state->focused_container() : nullptr;
+    return active_workspace.lock()->leaf_at(x, y, ignored.get());
 }
 
 AllocationHint Output::allocate_position(
@@ -160,6 +149,7 @@ void Output::insert_workspace_sorted(std::shared_ptr<WorkspaceInterface> const&
         else
             return false;
     });
+    publish_workspace_transforms();
 }
 
 void Output::advise_new_workspace(WorkspaceCreationData const&& data)
@@ -177,6 +167,8 @@ void Output::advise_workspace_deleted(WorkspaceManager& workspace_manager, uint3
         if (it->get()->id() == id)
         {
             workspaces.erase(it);
+            state->render_data_manager()->remove_workspace(id);
+            publish_workspace_transforms();
             return;
         }
     }
@@ -321,6 +313,9 @@ bool Output::advise_workspace_active(WorkspaceManager& workspace_manager, uint32
             workspace->show();
     }
 
+    if (config->rendering().workspace_snapshots)
+        begin_workspace_switch();
+
     return true;
 }
 
@@ -336,20 +331,33 @@ Output::WorkspaceAnimation::WorkspaceAnimation(
     Animation(handle, definition, from, to, current),
     to_workspace { to_workspace },
     from_workspace { from_workspace },
-    output { output }
+    output { output },
+    server_action_queue { output->server_action_queue },
+    policy { output->policy }
 {
 }
 
-void Output::WorkspaceAnimation::on_tick(miracle::AnimationStepResult const& asr)
+void Output::WorkspaceAnimation::on_init(miracle::AnimationStepResult const& asr)
 {
     output->on_workspace_animation(asr, to_workspace, from_workspace);
 }
 
+void Output::WorkspaceAnimation::on_tick(miracle::AnimationStepResult const& asr)
+{
+    // The output is only touched once the policy has checked that it is still there
+    server_action_queue->enqueue(policy, [policy = policy, output = output, asr, to = to_workspace, from = from_workspace]()
+    {
+        policy->handle_workspace_animation(asr, output, to, from);
+    });
+}
+
 void Output::on_workspace_animation(
     AnimationStepResult const& asr,
     std::shared_ptr<WorkspaceInterface> const& to,
     std::shared_ptr<WorkspaceInterface> const&)
 {
+    // Every workspace moves together, so the renderers should see a single change
+    RenderDataManager::Batch batch(*state->render_data_manager());
     if (asr.is_complete)
     {
         if (asr.position)
@@ -363,6 +371,7 @@ void Output::on_workspace_animation(
                 workspace->hide();
         }
 
+        end_workspace_switch();
         to->workspace_transform_change_hack();
         return;
     }
@@ -376,6 +385,42 @@ void Output::on_workspace_animation(
         workspace->workspace_transform_change_hack();
 }
 
+void Output::begin_workspace_switch()
+{
+    end_workspace_switch();
+
+    // Every workspace is shown while switching, so each one with windows becomes a layer
+    std::vector<uint32_t> layers;
+    for (auto const& workspace : workspaces)
+    {
+        if (!workspace->is_empty())
+            layers.push_back(workspace->id());
+    }
+
+    workspace_switch_serial = state->render_data_manager()->begin_workspace_switch(area, std::move(layers));
+}
+
+void Output::publish_workspace_transforms() const
+{
+    RenderDataManager::Batch batch(*state->render_data_manager());
+    for (size_t i = 0; i < workspaces.size(); i++)
+    {
+        auto const rectangle = get_workspace_rectangle(i);
+        state->render_data_manager()->set_workspace_transform(
+            workspaces[i]->id(),
+            final_transform * glm::translate(glm::vec3(rectangle.top_left.x.as_int(), rectangle.top_left.y.as_int(), 0)));
+    }
+}
+
+void Output::end_workspace_switch()
+{
+    if (!workspace_switch_serial)
+        return;
+
+    state->render_data_manager()->end_workspace_switch(workspace_switch_serial);
+    workspace_switch_serial = 0;
+}
+
 void Output::advise_application_zone_create(miral::Zone const& application_zone)
 {
     if (application_zone.extents().contains(area))
@@ -422,6 +467,7 @@ void Output::update_area(geom::Rectangle const& new_area)
     area = new_area;
     for (auto& workspace : workspaces)
         workspace->set_area(area);
+    publish_workspace_transforms();
 }
 
 std::vector<miral::Window> Output::collect_all_windows() const
@@ -491,12 +537,14 @@ void Output::set_transform(glm::mat4 const& in)
 {
     transform = in;
     final_transform = glm::translate(transform, glm::vec3(position_offset.x, position_offset.y, 0));
+    publish_workspace_transforms();
 }
 
 void Output::set_position(glm::vec2 const& v)
 {
     position_offset = v;
     final_transform = glm::translate(transform, glm::vec3(position_offset.x, position_offset.y, 0));
+    publish_workspace_transforms();
 }
 
 void Output::set_info(int next_id, std::string next_name)
@@ -20,8 +20,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "output_interface.h"
 
+namespace mir
+{
+class ServerActionQueue;
+}
+
 namespace miracle
 {
+class Policy;
+
 class Output : public OutputInterface
 {
 public:
@@ -32,7 +39,9 @@ public:
         std::shared_ptr<CompositorState> const& state,
         std::shared_ptr<Config> const& options,
         std::shared_ptr<WindowController> const&,
-        std::shared_ptr<Animator> const&);
+        std::shared_ptr<Animator> const&,
+        std::shared_ptr<mir::ServerActionQueue> const&,
+        Policy* policy);
     ~Output();
 
     std::shared_ptr<Container> intersect(float x, float y) override;
@@ -73,6 +82,13 @@ public:
     [[nodiscard]] WorkspaceInterface const* workspace(uint32_t id) const override;
     [[nodiscard]] nlohmann::json to_json(bool is_focused) const override;
 
+    /// Applies a step of the workspace switch. Called on the main loop with
+    /// the policy locked.
+    void on_workspace_animation(
+        AnimationStepResult const& result,
+        std::shared_ptr<WorkspaceInterface> const& to,
+        std::shared_ptr<WorkspaceInterface> const& from);
+
 private:
     class WorkspaceAnimation : public Animation
     {
@@ -87,20 +103,33 @@ private:
             std::shared_ptr<WorkspaceInterface> const& from_workspace,
             Output* output);
 
+        void on_init(AnimationStepResult const&) override;
+
+        /// Steps are sent to the main loop, where the policy checks that they
+        /// are current before applying them.
         void on_tick(AnimationStepResult const&) override;
 
     private:
         std::shared_ptr<WorkspaceInterface> to_workspace;
         std::shared_ptr<WorkspaceInterface> from_workspace;
         Output* output;
+
+        /// Copied from [output], which may be gone by the time of a tick.
+        std::shared_ptr<mir::ServerActionQueue> server_action_queue;
+        Policy* policy;
     };
 
-    void on_workspace_animation(
-        AnimationStepResult const& result,
-        std::shared_ptr<WorkspaceInterface> const& to,
-        std::shared_ptr<WorkspaceInterface> const& from);
     void insert_workspace_sorted(std::shared_ptr<WorkspaceInterface> const& new_workspace);
 
+    /// Tells the renderers which workspaces are moving during a switch, so that they
+    /// can draw each workspace from a snapshot.
+    void begin_workspace_switch();
+    void end_workspace_switch();
+
+    /// Shares the transform of each workspace with the renderers, which apply it to
+    /// every window on the workspace.
+    void publish_workspace_transforms() const;
+
     std::string name_;
     int id_;
     std::shared_ptr<CompositorState> state;
@@ -108,6 +137,8 @@ private:
     std::shared_ptr<Config> config;
     std::shared_ptr<WindowController> window_controller;
     std::shared_ptr<Animator> animator;
+    std::shared_ptr<mir::ServerActionQueue> server_action_queue;
+    Policy* policy;
     std::weak_ptr<WorkspaceInterface> active_workspace;
     std::vector<std::shared_ptr<WorkspaceInterface>> workspaces;
     std::vector<miral::Zone> application_zone_list;
@@ -123,6 +154,9 @@ private:
     glm::mat4 final_transform = glm::mat4(1.f);
 
     bool is_defunct_ = false;
+
+    /// The serial of the workspace switch that is being animated, or 0 if none.
+    uint64_t workspace_switch_serial = 0;
 };
 }
 
@@ -24,11 +24,15 @@ MiralOutputFactory::MiralOutputFactory(
     std::shared_ptr<CompositorState> const& state,
     std::shared_ptr<Config> const& config,
     std::shared_ptr<WindowController> const& window_controller,
-    std::shared_ptr<Animator> const& animator) :
+    std::shared_ptr<Animator> const& animator,
+    std::shared_ptr<mir::ServerActionQueue> const& server_action_queue,
+    Policy* policy) :
     state { state },
     config { config },
     window_controller { window_controller },
-    animator { animator }
+    animator { animator },
+    server_action_queue { server_action_queue },
+    policy { policy }
 {
 }
 
@@ -42,5 +46,7 @@ std::unique_ptr<OutputInterface> MiralOutputFactory::create(
         state,
         config,
         window_controller,
-        animator);
+        animator,
+        server_action_queue,
+        policy);
 }
\ No newline at end of file
@@ -20,6 +20,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "output_factory_interface.h"
 
+namespace mir
+{
+class ServerActionQueue;
+}
+
 namespace miracle
 {
 class WorkspaceManager;
@@ -27,6 +32,7 @@ class CompositorState;
 class Config;
 class WindowController;
 class Animator;
+class Policy;
 
 class MiralOutputFactory : public OutputFactoryInterface
 {
@@ -35,7 +41,9 @@ public:
         std::shared_ptr<CompositorState> const& state,
         std::shared_ptr<Config> const& options,
         std::shared_ptr<WindowController> const&,
-        std::shared_ptr<Animator> const&);
+        std::shared_ptr<Animator> const&,
+        std::shared_ptr<mir::ServerActionQueue> const&,
+        Policy* policy);
     std::unique_ptr<OutputInterface> create(
         std::string name,
         int id,
@@ -46,6 +54,8 @@ private:
     std::shared_ptr<Config> config;
     std::shared_ptr<WindowController> window_controller;
     std::shared_ptr<Animator> animator;
+    std::shared_ptr<mir::ServerActionQueue> server_action_queue;
+    Policy* policy;
 };
 
 }
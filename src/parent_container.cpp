@@ -247,6 +247,8 @@ std::shared_ptr<LeafContainer> ParentContainer::create_space_for_window(int pend
         as_parent(shared_from_this()),
         state);
     sub_nodes.insert(sub_nodes.begin() + pending_index, pending_node);
+    state->container_tree_version++;
+    mark_layout_dirty();
     return pending_node;
 }
 
@@ -272,6 +274,7 @@ void ParentContainer::graft_existing(std::shared_ptr<Container> const& node, int
     node->set_parent(as_parent(shared_from_this()));
     node->set_logical_area(rectangle);
     sub_nodes.insert(sub_nodes.begin() + index, node);
+    state->container_tree_version++;
     relayout();
     constrain();
 }
@@ -296,11 +299,23 @@ std::shared_ptr<ParentContainer> ParentContainer::convert_to_parent(std::shared_
     new_parent_node->sub_nodes.push_back(container);
     container->set_parent(new_parent_node);
     sub_nodes[index] = new_parent_node;
+    state->container_tree_version++;
+    new_parent_node->mark_layout_dirty();
     return new_parent_node;
 }
 
 void ParentContainer::set_logical_area(const geom::Rectangle& target_rect, bool with_animations)
 {
+    // Nothing beneath us can change if neither our area nor anything in our subtree has
+    if (target_rect == logical_area && !layout_dirty)
+    {
+        state->layout_counters.skipped++;
+        return;
+    }
+
+    mark_layout_dirty();
+    state->layout_counters.recomputed++;
+
     // We are setting the size of the lane, but each window might have an idea of how
     // its own height relates to the lane (e.g. I take up 300px of 900px lane while my
     // neighbor takes up the remaining 600px, horizontally).
@@ -413,8 +428,27 @@ void ParentContainer::set_logical_area(const geom::Rectangle& target_rect, bool
 
 void ParentContainer::commit_changes()
 {
+    if (!layout_dirty)
+        return;
+
+    // Cleared first so that a child that changes again while committing keeps us dirty
+    layout_dirty = false;
     for (auto& node : sub_nodes)
-        node->commit_changes();
+    {
+        if (node->is_layout_dirty())
+            node->commit_changes();
+    }
+}
+
+void ParentContainer::invalidate_layout()
+{
+    for (auto const& node : sub_nodes)
+    {
+        if (node->is_lane())
+            as_parent(node)->invalidate_layout();
+    }
+
+    mark_layout_dirty();
 }
 
 std::shared_ptr<Container> ParentContainer::at(size_t i) const
@@ -466,6 +500,7 @@ void ParentContainer::swap_nodes(std::shared_ptr<Container> const& first, std::s
     auto second_index = get_index_of_node(second);
     sub_nodes[second_index] = first;
     sub_nodes[first_index] = second;
+    state->container_tree_version++;
     relayout();
     constrain();
 }
@@ -492,6 +527,7 @@ void ParentContainer::remove(const std::shared_ptr<Container>& node)
         set_layout(dying_lane->get_direction());
     }
 
+    state->container_tree_version++;
     relayout();
 }
 
@@ -548,6 +584,7 @@ void ParentContainer::set_parent(std::shared_ptr<ParentContainer> const& in_pare
 
 void ParentContainer::relayout()
 {
+    mark_layout_dirty();
     auto placement_area = get_logical_area();
     if (scheme == LayoutScheme::horizontal)
     {
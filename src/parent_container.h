@@ -60,6 +60,11 @@ public:
     void swap_nodes(std::shared_ptr<Container> const& first, std::shared_ptr<Container> const& second);
     void remove(std::shared_ptr<Container> const& node);
     void commit_changes() override;
+
+    /// Marks every parent in this subtree as dirty, so that the next layout pass
+    /// recomputes all of it. Used when something that every container depends
+    /// on, such as the gaps, has changed.
+    void invalidate_layout();
     std::shared_ptr<Container> at(size_t i) const;
     std::shared_ptr<LeafContainer> get_nth_window(size_t i) const;
     std::shared_ptr<Container> find_where(std::function<bool(std::shared_ptr<Container> const&)> func) const;
@@ -0,0 +1,104 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#define MIR_LOG_COMPONENT "pending_window_changes"
+
+#include "pending_window_changes.h"
+
+#include <algorithm>
+#include <mir/log.h>
+
+using namespace miracle;
+
+void PendingWindowChanges::begin()
+{
+    depth++;
+}
+
+std::optional<std::vector<PendingWindowChanges::Change>> PendingWindowChanges::commit()
+{
+    if (depth == 0)
+    {
+        mir::log_error("commit: no transaction has begun");
+        return std::nullopt;
+    }
+
+    if (--depth > 0)
+        return std::nullopt;
+
+    auto result = std::move(changes);
+    changes.clear();
+    return result;
+}
+
+void PendingWindowChanges::set_state(miral::Window const& window, MirWindowState state)
+{
+    change_for(window).state = state;
+}
+
+void PendingWindowChanges::modify(miral::Window const& window, miral::WindowSpecification const& spec)
+{
+    change_for(window).modifications.push_back(spec);
+}
+
+void PendingWindowChanges::set_rectangle(
+    miral::Window const& window,
+    mir::geometry::Rectangle const& from,
+    mir::geometry::Rectangle const& to,
+    bool with_animations)
+{
+    auto& change = change_for(window);
+    if (change.rectangle)
+    {
+        change.rectangle->to = to;
+        change.rectangle->with_animations = with_animations;
+    }
+    else
+        change.rectangle = Rectangle { from, to, with_animations };
+}
+
+PendingWindowChanges::Change const* PendingWindowChanges::find(miral::Window const& window) const
+{
+    for (auto const& change : changes)
+    {
+        if (change.window == window)
+            return &change;
+    }
+
+    return nullptr;
+}
+
+void PendingWindowChanges::forget(miral::Window const& window)
+{
+    changes.erase(
+        std::remove_if(changes.begin(), changes.end(), [&](Change const& change)
+    {
+        return change.window == window;
+    }),
+        changes.end());
+}
+
+PendingWindowChanges::Change& PendingWindowChanges::change_for(miral::Window const& window)
+{
+    for (auto& change : changes)
+    {
+        if (change.window == window)
+            return change;
+    }
+
+    return changes.emplace_back(Change { window, std::nullopt, {}, std::nullopt });
+}
@@ -0,0 +1,90 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLE_WM_PENDING_WINDOW_CHANGES_H
+#define MIRACLE_WM_PENDING_WINDOW_CHANGES_H
+
+#include <mir/geometry/rectangle.h>
+#include <mir_toolkit/common.h>
+#include <miral/window.h>
+#include <miral/window_specification.h>
+#include <optional>
+#include <vector>
+
+namespace miracle
+{
+
+/// Records the changes that are made to windows while a [WindowController]
+/// transaction is open, so that they can be applied together once the
+/// outermost transaction commits.
+class PendingWindowChanges
+{
+public:
+    struct Rectangle
+    {
+        mir::geometry::Rectangle from;
+        mir::geometry::Rectangle to;
+        bool with_animations;
+    };
+
+    /// The changes recorded for a window. They are applied in the same order
+    /// that [LeafContainer] makes them: state, then modifications, then rectangle.
+    struct Change
+    {
+        miral::Window window;
+        std::optional<MirWindowState> state;
+        std::vector<miral::WindowSpecification> modifications;
+        std::optional<Rectangle> rectangle;
+    };
+
+    void begin();
+
+    /// Ends the innermost transaction.
+    /// \returns the changes of every window, in the order that each window was
+    /// first changed, when the outermost transaction ends, or std::nullopt otherwise
+    std::optional<std::vector<Change>> commit();
+
+    /// True while a transaction is open, during which changes must be recorded.
+    [[nodiscard]] bool is_recording() const { return depth > 0; }
+
+    void set_state(miral::Window const&, MirWindowState);
+    void modify(miral::Window const&, miral::WindowSpecification const&);
+
+    /// Records a move of [window] to [to]. When the window is moved several times
+    /// in one transaction, it animates from where it was before the transaction.
+    void set_rectangle(
+        miral::Window const& window,
+        mir::geometry::Rectangle const& from,
+        mir::geometry::Rectangle const& to,
+        bool with_animations);
+
+    /// \returns the changes recorded for [window], or nullptr if there are none
+    [[nodiscard]] Change const* find(miral::Window const&) const;
+
+    /// Drops the changes recorded for [window].
+    void forget(miral::Window const&);
+
+private:
+    int depth = 0;
+    std::vector<Change> changes;
+
+    Change& change_for(miral::Window const&);
+};
+
+} // miracle
+
+#endif // MIRACLE_WM_PENDING_WINDOW_CHANGES_H
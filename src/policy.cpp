@@ -112,14 +112,16 @@ Policy::Policy(
     launcher { std::make_unique<AutoRestartingLauncher>(runner, external_client_launcher) },
     animator(std::make_shared<Animator>()),
     window_controller(std::make_shared<WindowManagerToolsWindowController>(
-        tools, animator, state, config, server.the_main_loop(), this)),
-    animator_loop(std::make_unique<ThreadedAnimatorLoop>(animator)),
+        tools, animator, state, config, server.the_main_loop(), server.the_main_loop(), this)),
+    animator_loop(std::make_unique<RefreshPacedAnimatorLoop>(animator, config)),
     output_manager(std::make_shared<OutputManager>(
         std::make_unique<MiralOutputFactory>(
             state,
             config,
             window_controller,
-            animator))),
+            animator,
+            server.the_main_loop(),
+            this))),
     workspace_observer_registrar(std::make_shared<WorkspaceObserverRegistrar>()),
     workspace_manager(std::make_shared<WorkspaceManager>(workspace_observer_registrar, config, output_manager)),
     scratchpad_(std::make_shared<Scratchpad>(window_controller, output_manager)),
@@ -171,6 +173,7 @@ bool Policy::handle_keyboard_event(MirKeyboardEvent const* event)
         if (key_command == DefaultKeyCommand::MAX)
             return false;
 
+        CommandController::Transaction transaction(*command_controller);
         switch (key_command)
         {
         case DefaultKeyCommand::Terminal:
@@ -477,6 +480,7 @@ void Policy::advise_focus_lost(const miral::WindowInfo& window_info)
 void Policy::advise_delete_window(const miral::WindowInfo& window_info)
 {
     std::lock_guard lock(self->mutex);
+    window_controller->forget(window_info.window());
     auto container = window_controller->get_container(window_info.window());
     if (!container)
     {
@@ -513,18 +517,21 @@ void Policy::advise_output_create(miral::Output const& output)
 {
     std::lock_guard lock(self->mutex);
     output_manager->create(output.name(), output.id(), output.extents(), *workspace_manager);
+    animator_loop->set_refresh_rate(output.id(), output.refresh_rate());
 }
 
 void Policy::advise_output_update(miral::Output const& updated, miral::Output const& original)
 {
     std::lock_guard lock(self->mutex);
     output_manager->update(updated.id(), updated.extents());
+    animator_loop->set_refresh_rate(updated.id(), updated.refresh_rate());
 }
 
 void Policy::advise_output_delete(miral::Output const& output)
 {
     std::lock_guard lock(self->mutex);
     output_manager->remove(output.id(), *workspace_manager);
+    animator_loop->remove_output(output.id());
 }
 
 void Policy::handle_modify_window(
@@ -610,9 +617,58 @@ void Policy::handle_animation(
         return;
     }
 
+    RenderDataManager::Batch batch(*state->render_data_manager());
     window_controller->process_animation(asr, sh_container);
 }
 
+void Policy::handle_animations(std::vector<ContainerAnimationResult> const& results)
+{
+    std::lock_guard lock(self->mutex);
+    RenderDataManager::Batch batch(*state->render_data_manager());
+    for (auto const& [asr, container] : results)
+    {
+        if (!animator->is_current(asr))
+            continue;
+
+        auto const sh_container = container.lock();
+        if (!sh_container)
+        {
+            mir::log_error("handle_animations: container is invalid");
+            continue;
+        }
+
+        window_controller->process_animation(asr, sh_container);
+    }
+}
+
+void Policy::handle_workspace_animation(
+    AnimationStepResult const& asr,
+    Output* output,
+    std::shared_ptr<WorkspaceInterface> const& to,
+    std::shared_ptr<WorkspaceInterface> const& from)
+{
+    std::lock_guard lock(self->mutex);
+
+    // The output removes its animation as it is destroyed, so this is checked
+    // before the output is touched
+    if (!animator->is_current(asr))
+        return;
+
+    output->on_workspace_animation(asr, to, from);
+}
+
+void Policy::handle_client_size(uint64_t transaction, AnimationHandle handle, geom::Size const& size)
+{
+    std::lock_guard lock(self->mutex);
+    window_controller->advise_client_size(transaction, handle, size);
+}
+
+void Policy::handle_transaction_timeout(uint64_t transaction)
+{
+    std::lock_guard lock(self->mutex);
+    window_controller->expire_transaction(transaction);
+}
+
 mir::geometry::Rectangle Policy::confirm_inherited_move(
     const miral::WindowInfo& window_info,
     mir::geometry::Displacement movement)
@@ -49,7 +49,7 @@ namespace miracle
 
 class Container;
 class ContainerGroupContainer;
-class AnimatorLoop;
+class RefreshPacedAnimatorLoop;
 class OutputManager;
 
 class Policy : public miral::WindowManagementPolicy
@@ -93,6 +93,26 @@ public:
     void handle_animation(
         AnimationStepResult const& asr,
         std::weak_ptr<Container> const& container);
+
+    /// Applies the results of an animator tick together. Results of animations
+    /// that have since been replaced or removed are dropped.
+    void handle_animations(std::vector<ContainerAnimationResult> const& results);
+
+    /// Called on the main loop to apply a step of the workspace switch on
+    /// [output], unless the switch has been replaced or [output] removed since.
+    void handle_workspace_animation(
+        AnimationStepResult const& asr,
+        Output* output,
+        std::shared_ptr<WorkspaceInterface> const& to,
+        std::shared_ptr<WorkspaceInterface> const& from);
+
+    /// Called on the main loop when the client of the window animated by
+    /// [handle] has drawn at [size] for layout [transaction].
+    void handle_client_size(uint64_t transaction, AnimationHandle handle, geom::Size const& size);
+
+    /// Called on the main loop when layout [transaction] has waited on its
+    /// clients for as long as it may.
+    void handle_transaction_timeout(uint64_t transaction);
     auto confirm_inherited_move(
         const miral::WindowInfo& window_info,
         mir::geometry::Displacement movement) -> mir::geometry::Rectangle override;
@@ -119,7 +139,7 @@ private:
     std::unique_ptr<DragAndDropService> drag_and_drop_service;
     std::unique_ptr<MoveService> move_service;
     std::shared_ptr<Ipc> ipc;
-    std::unique_ptr<AnimatorLoop> animator_loop;
+    std::unique_ptr<RefreshPacedAnimatorLoop> animator_loop;
     std::shared_ptr<ContainerGroupContainer> group_selection;
 
     bool is_starting_ = true;
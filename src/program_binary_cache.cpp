@@ -0,0 +1,289 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#define MIR_LOG_COMPONENT "program_binary_cache"
+
+#include "program_binary_cache.h"
+
+#include <EGL/egl.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <mir/log.h>
+#include <unistd.h>
+
+using namespace miracle;
+
+namespace
+{
+constexpr char magic[4] = { 'M', 'W', 'P', 'B' };
+constexpr uint32_t format_version = 1;
+
+/// Precedes the program binary in every cache file.
+struct Header
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t driver_hash;
+    uint64_t source_hash;
+    uint64_t compile_ns;
+    uint32_t binary_format;
+    uint32_t binary_size;
+    uint64_t binary_hash;
+};
+
+static_assert(sizeof(Header) == 48, "Header must not contain padding");
+
+char const* gl_string(GLenum name)
+{
+    auto const value = reinterpret_cast<char const*>(glGetString(name));
+    return value ? value : "";
+}
+
+double to_milliseconds(std::chrono::nanoseconds duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+}
+
+ProgramBinaryCache::ProgramBinaryCache(std::filesystem::path directory) :
+    directory { std::move(directory) }
+{
+    if (this->directory.empty())
+        return;
+
+    if (!strstr(gl_string(GL_EXTENSIONS), "GL_OES_get_program_binary"))
+    {
+        mir::log_info("GL_OES_get_program_binary is not supported, so shaders will not be cached");
+        return;
+    }
+
+    GLint format_count = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &format_count);
+    if (format_count <= 0)
+    {
+        mir::log_info("The driver provides no program binary formats, so shaders will not be cached");
+        return;
+    }
+
+    get_program_binary = reinterpret_cast<PFNGLGETPROGRAMBINARYOESPROC>(eglGetProcAddress("glGetProgramBinaryOES"));
+    program_binary = reinterpret_cast<PFNGLPROGRAMBINARYOESPROC>(eglGetProcAddress("glProgramBinaryOES"));
+    if (!get_program_binary || !program_binary)
+    {
+        mir::log_warning("GL_OES_get_program_binary is advertised, but its functions could not be loaded");
+        return;
+    }
+
+    // Any driver update changes at least one of these, which invalidates every entry
+    std::string driver = gl_string(GL_VENDOR);
+    driver += '\n';
+    driver += gl_string(GL_RENDERER);
+    driver += '\n';
+    driver += gl_string(GL_VERSION);
+    driver_hash = hash(driver);
+    supported = true;
+}
+
+std::filesystem::path ProgramBinaryCache::default_directory()
+{
+    if (auto const cache_home = getenv("XDG_CACHE_HOME"); cache_home && cache_home[0] == '/')
+        return std::filesystem::path(cache_home) / "miracle-wm" / "shaders";
+    if (auto const home = getenv("HOME"); home && home[0] != '\0')
+        return std::filesystem::path(home) / ".cache" / "miracle-wm" / "shaders";
+    return {};
+}
+
+GLuint ProgramBinaryCache::load(std::string_view vertex_src, std::string_view fragment_src)
+{
+    if (!supported)
+        return 0;
+
+    auto const key = key_for(vertex_src, fragment_src);
+    auto const path = path_for(key);
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        stats_.misses++;
+        mir::log_debug("Cache miss for %s", path.filename().c_str());
+        return 0;
+    }
+
+    std::vector<char> const contents { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+    file.close();
+
+    auto const binary = deserialize(key, contents);
+    if (!binary)
+    {
+        mir::log_warning("Removing invalid cache entry %s", path.c_str());
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+        stats_.misses++;
+        return 0;
+    }
+
+    auto const start = std::chrono::steady_clock::now();
+    auto const program = glCreateProgram();
+    program_binary(program, binary->format, binary->data.data(), static_cast<GLint>(binary->data.size()));
+    GLint ok = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok)
+    {
+        // Drivers may reject binaries for reasons that the key does not capture
+        mir::log_info("Driver rejected cache entry %s, removing it", path.filename().c_str());
+        glDeleteProgram(program);
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+        stats_.misses++;
+        return 0;
+    }
+
+    auto const load_time = std::chrono::steady_clock::now() - start;
+    auto const saved = std::max(binary->compile_time - load_time, std::chrono::nanoseconds::zero());
+    stats_.hits++;
+    stats_.time_saved += saved;
+    mir::log_debug("Cache hit for %s, saved %.2fms", path.filename().c_str(), to_milliseconds(saved));
+    return program;
+}
+
+void ProgramBinaryCache::store(
+    GLuint program,
+    std::string_view vertex_src,
+    std::string_view fragment_src,
+    std::chrono::nanoseconds compile_time)
+{
+    if (!supported)
+        return;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH_OES, &length);
+    if (length <= 0)
+        return;
+
+    Binary binary;
+    binary.compile_time = compile_time;
+    binary.data.resize(length);
+    GLsizei written = 0;
+    get_program_binary(program, length, &written, &binary.format, binary.data.data());
+    if (written <= 0)
+        return;
+    binary.data.resize(written);
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if (ec)
+    {
+        mir::log_warning("Unable to create %s, so shaders will not be cached: %s", directory.c_str(), ec.message().c_str());
+        supported = false;
+        return;
+    }
+
+    // Write to a temporary file first so that other renderers never read a partial entry
+    auto const key = key_for(vertex_src, fragment_src);
+    auto const path = path_for(key);
+    auto temporary = path;
+    temporary += ".tmp." + std::to_string(getpid()) + "." + std::to_string(reinterpret_cast<uintptr_t>(this));
+    auto const contents = serialize(key, binary);
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+        if (!file)
+        {
+            mir::log_warning("Unable to write %s", temporary.c_str());
+            file.close();
+            std::filesystem::remove(temporary, ec);
+            return;
+        }
+    }
+
+    std::filesystem::rename(temporary, path, ec);
+    if (ec)
+    {
+        mir::log_warning("Unable to write %s: %s", path.c_str(), ec.message().c_str());
+        std::filesystem::remove(temporary, ec);
+    }
+}
+
+uint64_t ProgramBinaryCache::hash(std::string_view data, uint64_t seed)
+{
+    // 64-bit FNV-1a
+    uint64_t result = seed;
+    for (auto const c : data)
+    {
+        result ^= static_cast<unsigned char>(c);
+        result *= 0x100000001b3ull;
+    }
+    return result;
+}
+
+std::vector<char> ProgramBinaryCache::serialize(Key const& key, Binary const& binary)
+{
+    Header header {};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = format_version;
+    header.driver_hash = key.driver_hash;
+    header.source_hash = key.source_hash;
+    header.compile_ns = static_cast<uint64_t>(binary.compile_time.count());
+    header.binary_format = binary.format;
+    header.binary_size = static_cast<uint32_t>(binary.data.size());
+    header.binary_hash = hash({ binary.data.data(), binary.data.size() });
+
+    std::vector<char> result(sizeof(Header) + binary.data.size());
+    std::memcpy(result.data(), &header, sizeof(Header));
+    std::copy(binary.data.begin(), binary.data.end(), result.begin() + sizeof(Header));
+    return result;
+}
+
+std::optional<ProgramBinaryCache::Binary> ProgramBinaryCache::deserialize(Key const& key, std::span<char const> data)
+{
+    if (data.size() < sizeof(Header))
+        return std::nullopt;
+
+    Header header;
+    std::memcpy(&header, data.data(), sizeof(Header));
+    auto const payload = data.subspan(sizeof(Header));
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0
+        || header.version != format_version
+        || header.driver_hash != key.driver_hash
+        || header.source_hash != key.source_hash
+        || header.binary_size != payload.size()
+        || header.binary_hash != hash({ payload.data(), payload.size() }))
+        return std::nullopt;
+
+    return Binary {
+        header.binary_format,
+        std::vector<char>(payload.begin(), payload.end()),
+        std::chrono::nanoseconds(header.compile_ns)
+    };
+}
+
+ProgramBinaryCache::Key ProgramBinaryCache::key_for(std::string_view vertex_src, std::string_view fragment_src) const
+{
+    // The separator keeps moving text between the two sources from producing the same hash
+    return { driver_hash, hash(fragment_src, hash(std::string_view("\0", 1), hash(vertex_src))) };
+}
+
+std::filesystem::path ProgramBinaryCache::path_for(Key const& key) const
+{
+    char name[64];
+    snprintf(name, sizeof(name), "%016llx-%016llx.bin",
+        static_cast<unsigned long long>(key.driver_hash),
+        static_cast<unsigned long long>(key.source_hash));
+    return directory / name;
+}
@@ -0,0 +1,108 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLE_WM_PROGRAM_BINARY_CACHE_H
+#define MIRACLE_WM_PROGRAM_BINARY_CACHE_H
+
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace miracle
+{
+
+/// Persists linked GL programs to disk with GL_OES_get_program_binary so that
+/// they do not need to be compiled again on the next start.
+///
+/// Entries are keyed by the driver that produced them and by the source of the
+/// program, so a driver update or a change to a shader simply misses the cache.
+/// Entries that fail validation or that the driver refuses are deleted.
+class ProgramBinaryCache
+{
+public:
+    struct Key
+    {
+        /// Hash of the GL vendor, renderer and version strings.
+        uint64_t driver_hash = 0;
+        /// Hash of the vertex and fragment shader sources.
+        uint64_t source_hash = 0;
+    };
+
+    struct Binary
+    {
+        GLenum format = 0;
+        std::vector<char> data;
+        /// How long the program took to compile and link when it was cached.
+        std::chrono::nanoseconds compile_time { 0 };
+    };
+
+    struct Stats
+    {
+        uint32_t hits = 0;
+        uint32_t misses = 0;
+        std::chrono::nanoseconds time_saved { 0 };
+    };
+
+    /// Must be constructed while the GL context is current.
+    explicit ProgramBinaryCache(std::filesystem::path directory = default_directory());
+
+    /// $XDG_CACHE_HOME/miracle-wm/shaders, falling back to ~/.cache.
+    static std::filesystem::path default_directory();
+
+    [[nodiscard]] bool is_supported() const { return supported; }
+
+    /// Returns a linked program for the provided sources, or 0 on a miss.
+    GLuint load(std::string_view vertex_src, std::string_view fragment_src);
+
+    /// Stores the binary of the linked [program].
+    void store(
+        GLuint program,
+        std::string_view vertex_src,
+        std::string_view fragment_src,
+        std::chrono::nanoseconds compile_time);
+
+    [[nodiscard]] Stats const& stats() const { return stats_; }
+
+    static uint64_t hash(std::string_view data, uint64_t seed = fnv_offset_basis);
+    static std::vector<char> serialize(Key const& key, Binary const& binary);
+    /// Returns std::nullopt if [data] is not a complete entry for [key].
+    static std::optional<Binary> deserialize(Key const& key, std::span<char const> data);
+
+private:
+    static constexpr uint64_t fnv_offset_basis = 0xcbf29ce484222325ull;
+
+    [[nodiscard]] Key key_for(std::string_view vertex_src, std::string_view fragment_src) const;
+    [[nodiscard]] std::filesystem::path path_for(Key const& key) const;
+
+    std::filesystem::path const directory;
+    bool supported = false;
+    uint64_t driver_hash = 0;
+    Stats stats_;
+    PFNGLGETPROGRAMBINARYOESPROC get_program_binary = nullptr;
+    PFNGLPROGRAMBINARYOESPROC program_binary = nullptr;
+};
+
+} // miracle
+
+#endif // MIRACLE_WM_PROGRAM_BINARY_CACHE_H
@@ -44,20 +44,6 @@ void main() {
 }
 )";
 
-const GLchar* const mode_scale_integration = R"(
-uniform int mode;
-
-vec4 resolve_color(vec4 v) {
-    if (mode == 1) {
-        float color =  0.299 * v.x + 0.587 * v.y + 0.114 * v.z;
-        return vec4(color, color, color, v.w);
-    }
-    else {
-        return v;
-    }
-}
-)";
-
 }
 
 miracle::ProgramData::ProgramData(GLuint program_id)
@@ -101,31 +87,51 @@ miracle::ProgramData::ProgramData(GLuint program_id)
     if (alpha_uniform < 0)
         mir::log_warning("Program is missing alpha_uniform");
 
-    mode_uniform = glGetUniformLocation(id, "mode");
-    if (mode_uniform < 0)
-        mir::log_warning("Program is missing mode_uniform");
-
     outline_color_uniform = glGetUniformLocation(id, "outline_color");
     if (outline_color_uniform < 0)
         mir::log_warning("Program is missing outline_color_uniform");
+
+    // Only the bordered program provides these
+    content_bounds_uniform = glGetUniformLocation(id, "content_bounds");
+    shaped_uniform = glGetUniformLocation(id, "shaped");
 }
 
-miracle::Program::Program(
-    ProgramHandle&& opaque_shader, ProgramHandle&& alpha_shader, ProgramHandle&& outline_shader) :
+miracle::ProgramVariant::ProgramVariant(
+    ProgramHandle&& opaque_shader,
+    ProgramHandle&& alpha_shader,
+    ProgramHandle&& outline_shader,
+    ProgramHandle&& bordered_shader) :
     opaque_handle(std::move(opaque_shader)),
     alpha_handle(std::move(alpha_shader)),
     outline_handle(std::move(outline_shader)),
+    bordered_handle(std::move(bordered_shader)),
     opaque { opaque_handle },
     alpha { alpha_handle },
-    outline(outline_handle)
+    outline(outline_handle),
+    bordered(bordered_handle)
+{
+}
+
+miracle::Program::Program(
+    ProgramFactory& factory,
+    std::string extension_fragment,
+    std::string fragment_fragment) :
+    factory { factory },
+    extension_fragment { std::move(extension_fragment) },
+    fragment_fragment { std::move(fragment_fragment) }
 {
 }
 
-miracle::ProgramFactory::ProgramFactory() :
-    vertex_shader { compile_shader(GL_VERTEX_SHADER, vertex_shader_src) }
+miracle::ProgramVariant const& miracle::Program::variant(RenderFilter filter) const
 {
+    auto& result = variants[static_cast<size_t>(filter)];
+    if (!result)
+        result = factory.compile_variant(extension_fragment, fragment_fragment, filter);
+    return *result;
 }
 
+miracle::ProgramFactory::ProgramFactory() = default;
+
 mir::graphics::gl::Program& miracle::ProgramFactory::compile_fragment_shader(
     void const* id,
     char const* extension_fragment,
@@ -143,6 +149,21 @@ mir::graphics::gl::Program& miracle::ProgramFactory::compile_fragment_shader(
         }
     }
 
+    auto program = std::make_unique<miracle::Program>(*this, extension_fragment, fragment_fragment);
+
+    // Filters other than none are rare, so they are only compiled when first drawn
+    program->variant(RenderFilter::none);
+    programs.emplace_back(id, std::move(program));
+    return *programs.back().second;
+}
+
+std::unique_ptr<miracle::ProgramVariant> miracle::ProgramFactory::compile_variant(
+    std::string const& extension_fragment,
+    std::string const& fragment_fragment,
+    RenderFilter filter)
+{
+    auto const filter_source = filter_shader_source(filter);
+
     std::stringstream opaque_fragment;
     opaque_fragment
         << extension_fragment
@@ -153,10 +174,10 @@ mir::graphics::gl::Program& miracle::ProgramFactory::compile_fragment_shader(
         << "\n"
         << fragment_fragment
         << "\n"
-        << mode_scale_integration
+        << filter_source
         << "varying vec2 v_texcoord;\n"
            "void main() {\n"
-           "    gl_FragColor = resolve_color(sample_to_rgba(v_texcoord));\n"
+           "    gl_FragColor = apply_filter(sample_to_rgba(v_texcoord));\n"
            "}\n";
 
     std::stringstream alpha_fragment;
@@ -169,11 +190,11 @@ mir::graphics::gl::Program& miracle::ProgramFactory::compile_fragment_shader(
         << "\n"
         << fragment_fragment
         << "\n"
-        << mode_scale_integration
+        << filter_source
         << "varying vec2 v_texcoord;\n"
            "uniform float alpha;\n"
            "void main() {\n"
-           "    gl_FragColor = alpha * resolve_color(sample_to_rgba(v_texcoord));\n"
+           "    gl_FragColor = alpha * apply_filter(sample_to_rgba(v_texcoord));\n"
            "}\n";
 
     std::stringstream outline_shader_src;
@@ -183,32 +204,94 @@ mir::graphics::gl::Program& miracle::ProgramFactory::compile_fragment_shader(
            "precision mediump float;\n"
            "#endif\n"
         << "\n"
-        << mode_scale_integration
+        << filter_source
         << "uniform float alpha;\n"
         << "uniform vec4 outline_color;\n"
         << "void main() {\n"
-        << "    gl_FragColor = alpha * resolve_color(outline_color);\n"
+        << "    gl_FragColor = alpha * apply_filter(outline_color);\n"
         << "}\n";
 
+    // Texture coordinates outside of the content bounds belong to the border. The output
+    // is premultiplied so that the border and the content can be blended in one draw.
+    std::stringstream bordered_fragment;
+    bordered_fragment
+        << extension_fragment
+        << "\n"
+        << "#ifdef GL_ES\n"
+           "precision mediump float;\n"
+           "#endif\n"
+        << "\n"
+        << fragment_fragment
+        << "\n"
+        << filter_source
+        << "#if defined(GL_ES) && defined(GL_FRAGMENT_PRECISION_HIGH)\n"
+           "varying highp vec2 v_texcoord;\n"
+           "uniform highp vec4 content_bounds;\n"
+           "#else\n"
+           "varying vec2 v_texcoord;\n"
+           "uniform vec4 content_bounds;\n"
+           "#endif\n"
+           "uniform float alpha;\n"
+           "uniform vec4 outline_color;\n"
+           "uniform int shaped;\n"
+           "void main() {\n"
+           "    vec2 inside = step(content_bounds.xy, v_texcoord) * step(v_texcoord, content_bounds.zw);\n"
+           "    if (inside.x * inside.y > 0.0) {\n"
+           "        vec4 color = apply_filter(sample_to_rgba(v_texcoord));\n"
+           "        if (shaped == 0)\n"
+           "            color.a = 1.0;\n"
+           "        gl_FragColor = alpha * color;\n"
+           "    } else {\n"
+           "        vec4 color = apply_filter(outline_color);\n"
+           "        gl_FragColor = alpha * vec4(color.rgb * color.a, color.a);\n"
+           "    }\n"
+           "}\n";
+
     // GL shader compilation is *not* threadsafe, and requires external synchronisation
     std::lock_guard lock { compilation_mutex };
 
-    ShaderHandle const opaque_shader {
-        compile_shader(GL_FRAGMENT_SHADER, opaque_fragment.str().c_str())
-    };
-    ShaderHandle const alpha_shader {
-        compile_shader(GL_FRAGMENT_SHADER, alpha_fragment.str().c_str())
-    };
-    ShaderHandle const outline_shader {
-        compile_shader(GL_FRAGMENT_SHADER, outline_shader_src.str().c_str())
-    };
+    auto const stats_before = cache.stats();
+    auto variant = std::make_unique<miracle::ProgramVariant>(
+        make_program(opaque_fragment.str()),
+        make_program(alpha_fragment.str()),
+        make_program(outline_shader_src.str()),
+        make_program(bordered_fragment.str()));
 
-    programs.emplace_back(id, std::make_unique<miracle::Program>(link_shader(vertex_shader, opaque_shader), link_shader(vertex_shader, alpha_shader), link_shader(vertex_shader, outline_shader)));
+    if (cache.is_supported())
+    {
+        auto const& stats = cache.stats();
+        mir::log_info("Shader cache: %u hits, %u misses, saved %.2fms",
+            stats.hits - stats_before.hits,
+            stats.misses - stats_before.misses,
+            std::chrono::duration<double, std::milli>(stats.time_saved - stats_before.time_saved).count());
+    }
 
-    return *programs.back().second;
+    return variant;
+}
+
+miracle::ProgramHandle miracle::ProgramFactory::make_program(std::string const& fragment_src)
+{
+    if (auto const cached = cache.load(vertex_shader_src, fragment_src))
+        return ProgramHandle { cached };
 
-    // We delete opaque_shader and alpha_shader here. This is fine; it only marks them
-    // for deletion. GL will only delete them once the GL Program they're linked in is destroyed.
+    auto const& vertex = get_vertex_shader();
+    auto const start = std::chrono::steady_clock::now();
+    ShaderHandle const fragment_shader {
+        compile_shader(GL_FRAGMENT_SHADER, fragment_src.c_str())
+    };
+    auto program = link_shader(vertex, fragment_shader);
+    cache.store(program, vertex_shader_src, fragment_src, std::chrono::steady_clock::now() - start);
+    return program;
+
+    // We delete fragment_shader here. This is fine; it only marks it for deletion.
+    // GL will only delete it once the GL Program it's linked in is destroyed.
+}
+
+miracle::ShaderHandle const& miracle::ProgramFactory::get_vertex_shader()
+{
+    if (!vertex_shader)
+        vertex_shader.emplace(compile_shader(GL_VERTEX_SHADER, vertex_shader_src));
+    return vertex_shader.value();
 }
 
 GLuint miracle::ProgramFactory::compile_shader(GLenum type, GLchar const* src)
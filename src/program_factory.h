@@ -18,11 +18,18 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef MIRACLE_WM_PROGRAM_FACTORY_H
 #define MIRACLE_WM_PROGRAM_FACTORY_H
 
+#include "gl_state_tracker.h"
+#include "program_binary_cache.h"
+#include "render_filter.h"
+
 #include <GLES2/gl2.h>
 #include <array>
+#include <memory>
 #include <mir/graphics/program.h>
 #include <mir/graphics/program_factory.h>
 #include <mutex>
+#include <optional>
+#include <string>
 #include <vector>
 
 namespace miracle
@@ -81,19 +88,51 @@ struct ProgramData
     GLint transform_uniform = -1;
     GLint screen_to_gl_coords_uniform = -1;
     GLint alpha_uniform = -1;
-    GLint mode_uniform = -1;
     GLint outline_color_uniform = -1;
-    mutable long long last_used_frameno = 0;
+    GLint content_bounds_uniform = -1;
+    GLint shaped_uniform = -1;
+    /// The values last uploaded to the uniforms of this program.
+    mutable UniformShadow uniforms;
 
     ProgramData(GLuint program_id);
 };
 
+/// The programs that draw a texture with a single [RenderFilter].
+struct ProgramVariant
+{
+    ProgramVariant(
+        ProgramHandle&& opaque_shader,
+        ProgramHandle&& alpha_shader,
+        ProgramHandle&& outline_shader,
+        ProgramHandle&& bordered_shader);
+    ProgramHandle opaque_handle, alpha_handle, outline_handle, bordered_handle;
+    ProgramData opaque, alpha, outline;
+
+    /// Draws the surface and its border in a single pass. The geometry is expected
+    /// to be enlarged by the size of the border, with texture coordinates outside
+    /// of the "content_bounds" being drawn in the "outline_color".
+    ProgramData bordered;
+};
+
+class ProgramFactory;
+
 struct Program : public mir::graphics::gl::Program
 {
 public:
-    Program(ProgramHandle&& opaque_shader, ProgramHandle&& alpha_shader, ProgramHandle&& outline_shader);
-    ProgramHandle opaque_handle, alpha_handle, outline_handle;
-    ProgramData opaque, alpha, outline;
+    Program(
+        ProgramFactory& factory,
+        std::string extension_fragment,
+        std::string fragment_fragment);
+
+    /// Returns the programs that apply [filter]. Each filter is compiled into its own
+    /// programs on first use so that no fragment has to branch on the filter.
+    ProgramVariant const& variant(RenderFilter filter) const;
+
+private:
+    ProgramFactory& factory;
+    std::string const extension_fragment;
+    std::string const fragment_fragment;
+    std::array<std::unique_ptr<ProgramVariant>, render_filter_count> mutable variants;
 };
 
 class ProgramFactory : public mir::graphics::gl::ProgramFactory
@@ -105,13 +144,25 @@ public:
         char const* extension_fragment,
         char const* fragment_fragment) override;
 
+    std::unique_ptr<ProgramVariant> compile_variant(
+        std::string const& extension_fragment,
+        std::string const& fragment_fragment,
+        RenderFilter filter);
+
 private:
     static GLuint compile_shader(GLenum type, GLchar const* src);
     static ProgramHandle link_shader(
         ShaderHandle const& vertex_shader,
         ShaderHandle const& fragment_shader);
 
-    ShaderHandle const vertex_shader;
+    /// Loads the program for [fragment_src] from the cache, or compiles and caches it.
+    ProgramHandle make_program(std::string const& fragment_src);
+
+    /// The vertex shader is only compiled once a program misses the cache.
+    ShaderHandle const& get_vertex_shader();
+
+    std::optional<ShaderHandle> vertex_shader;
+    ProgramBinaryCache cache;
     std::vector<std::pair<void const*, std::unique_ptr<Program>>> programs;
     // GL requires us to synchronise multi-threaded access to the shader APIs.
     std::mutex compilation_mutex;
@@ -17,7 +17,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "render_data_manager.h"
 #include "container.h"
-#include <algorithm>
+#include "workspace_interface.h"
 #include <mir/scene/surface.h>
 
 using namespace miracle;
@@ -32,84 +32,212 @@ inline bool needs_outline(Container const& container)
         && (surface == nullptr || !surface->parent());
 }
 
-inline glm::mat4 workspace_transform(Container const& container)
+inline std::optional<uint32_t> workspace_id(Container const& container)
 {
-    return container.get_output_transform() * container.get_workspace_transform();
+    if (auto const workspace = container.get_workspace())
+        return workspace->id();
+    return std::nullopt;
 }
 }
 
-RenderDataManager::RenderDataManager()
+RenderData const* RenderDataSnapshot::find(mir::scene::Surface const* surface) const
 {
-    render_data.reserve(48);
+    auto const it = surface_index.find(surface);
+    if (it == surface_index.end())
+        return nullptr;
+
+    return data.get(it->second);
+}
+
+glm::mat4 RenderDataSnapshot::workspace_transform(RenderData const& render_data) const
+{
+    if (!render_data.workspace_id)
+        return glm::mat4(1.f);
+
+    auto const it = workspace_transforms.find(render_data.workspace_id.value());
+    if (it == workspace_transforms.end())
+        return glm::mat4(1.f);
+
+    return it->second;
+}
+
+WorkspaceSwitch const* RenderDataSnapshot::find_workspace_switch(mir::geometry::Rectangle const& output_area) const
+{
+    for (auto const& workspace_switch : workspace_switches)
+    {
+        if (workspace_switch.output_area == output_area)
+            return &workspace_switch;
+    }
+
+    return nullptr;
+}
+
+RenderData const* RenderDataSnapshot::get(RenderDataHandle const& handle) const
+{
+    return data.get(handle);
+}
+
+RenderDataManager::Batch::Batch(RenderDataManager& manager) :
+    manager { manager }
+{
+    std::lock_guard lock(manager.mutex);
+    manager.batch_depth++;
 }
 
-void RenderDataManager::add(Container const& container)
+RenderDataManager::Batch::~Batch()
+{
+    std::lock_guard lock(manager.mutex);
+    manager.batch_depth--;
+    manager.publish_locked();
+}
+
+RenderDataManager::RenderDataManager() :
+    published { std::make_shared<RenderDataSnapshot const>() }
+{
+    render_data.data.reserve(48);
+}
+
+RenderDataHandle RenderDataManager::add(Container const& container)
 {
     if (container.window() == std::nullopt)
-        return;
+        return {};
 
-    render_data.emplace_back(RenderData {
-        .surface = container.window()->operator std::shared_ptr<mir::scene::Surface>().get(),
+    auto const surface = container.window()->operator std::shared_ptr<mir::scene::Surface>().get();
+    RenderData data {
+        .surface = surface,
         .needs_outline = needs_outline(container),
         .is_focused = container.is_focused(),
         .transform = container.get_transform(),
-        .workspace_transform = workspace_transform(container) });
+        .workspace_id = workspace_id(container)
+    };
+
+    std::lock_guard lock(mutex);
+    auto const handle = render_data.data.insert(data);
+    if (surface)
+        render_data.surface_index[surface] = handle;
+
+    has_changes = true;
+    publish_locked();
+    return handle;
 }
 
-void RenderDataManager::transform_change(Container const& container)
+void RenderDataManager::transform_change(RenderDataHandle const& handle, Container const& container)
 {
-    for (auto& data : render_data)
+    auto const transform = container.get_transform();
+
+    std::lock_guard lock(mutex);
+    if (auto data = render_data.data.get(handle))
     {
-        if (data.surface == container.window()->operator std::shared_ptr<mir::scene::Surface>().get())
-        {
-            data.transform = container.get_transform();
-            return;
-        }
+        data->transform = transform;
+        has_changes = true;
+        publish_locked();
     }
 }
 
-void RenderDataManager::workspace_transform_change(Container const& container)
+void RenderDataManager::workspace_change(RenderDataHandle const& handle, Container const& container)
 {
-    for (auto& data : render_data)
+    auto const id = workspace_id(container);
+
+    std::lock_guard lock(mutex);
+    if (auto data = render_data.data.get(handle))
     {
-        if (data.surface == container.window()->operator std::shared_ptr<mir::scene::Surface>().get())
-        {
-            data.workspace_transform = workspace_transform(container);
+        if (data->workspace_id == id)
             return;
-        }
+
+        data->workspace_id = id;
+        has_changes = true;
+        publish_locked();
     }
 }
 
-void RenderDataManager::focus_change(Container const& container)
+void RenderDataManager::set_workspace_transform(uint32_t workspace_id, glm::mat4 const& transform)
 {
-    for (auto& data : render_data)
+    std::lock_guard lock(mutex);
+    auto const [it, inserted] = render_data.workspace_transforms.try_emplace(workspace_id, transform);
+    if (!inserted)
     {
-        if (data.surface == container.window()->operator std::shared_ptr<mir::scene::Surface>().get())
-        {
-            data.is_focused = container.is_focused();
+        if (it->second == transform)
             return;
-        }
+        it->second = transform;
     }
+
+    has_changes = true;
+    publish_locked();
+}
+
+void RenderDataManager::remove_workspace(uint32_t workspace_id)
+{
+    std::lock_guard lock(mutex);
+    if (render_data.workspace_transforms.erase(workspace_id) > 0)
+    {
+        has_changes = true;
+        publish_locked();
+    }
+}
+
+void RenderDataManager::focus_change(RenderDataHandle const& handle, Container const& container)
+{
+    auto const is_focused = container.is_focused();
+
+    std::lock_guard lock(mutex);
+    if (auto data = render_data.data.get(handle))
+    {
+        data->is_focused = is_focused;
+        has_changes = true;
+        publish_locked();
+    }
+}
+
+uint64_t RenderDataManager::begin_workspace_switch(
+    mir::geometry::Rectangle const& output_area,
+    std::vector<uint32_t> workspaces)
+{
+    std::lock_guard lock(mutex);
+    auto& switches = render_data.workspace_switches;
+    std::erase_if(switches, [&](WorkspaceSwitch const& s) { return s.output_area == output_area; });
+
+    auto const serial = next_workspace_switch_serial++;
+    switches.push_back({ serial, output_area, std::move(workspaces) });
+    has_changes = true;
+    publish_locked();
+    return serial;
 }
 
-void RenderDataManager::remove(Container const& container)
+void RenderDataManager::end_workspace_switch(uint64_t serial)
 {
-    render_data.erase(std::remove_if(render_data.begin(), render_data.end(), [&](RenderData const& data)
+    std::lock_guard lock(mutex);
+    if (std::erase_if(render_data.workspace_switches, [&](WorkspaceSwitch const& s) { return s.serial == serial; }) > 0)
     {
-        return data.surface == container.window()->operator std::shared_ptr<mir::scene::Surface>().get();
-    }),
-        render_data.end());
+        has_changes = true;
+        publish_locked();
+    }
 }
 
-std::vector<RenderData> const& RenderDataManager::get()
+void RenderDataManager::remove(RenderDataHandle const& handle)
 {
     std::lock_guard lock(mutex);
-    copy_for_renderer.clear();
-    if (render_data.capacity() > copy_for_renderer.capacity())
-        copy_for_renderer.reserve(render_data.capacity());
-    std::copy(
-        render_data.begin(),
-        render_data.end(),
-        std::back_inserter(copy_for_renderer));
-    return copy_for_renderer;
-}
\ No newline at end of file
+    auto const data = render_data.data.get(handle);
+    if (!data)
+        return;
+
+    if (data->surface)
+        render_data.surface_index.erase(data->surface);
+    render_data.data.erase(handle);
+
+    has_changes = true;
+    publish_locked();
+}
+
+std::shared_ptr<RenderDataSnapshot const> RenderDataManager::get() const
+{
+    return published.load(std::memory_order_acquire);
+}
+
+void RenderDataManager::publish_locked()
+{
+    if (batch_depth > 0 || !has_changes)
+        return;
+
+    published.store(std::make_shared<RenderDataSnapshot const>(render_data), std::memory_order_release);
+    has_changes = false;
+}
@@ -18,8 +18,16 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef MIRACLEWM_SURFACE_TRACKER_H
 #define MIRACLEWM_SURFACE_TRACKER_H
 
+#include "slot_map.h"
+
+#include <atomic>
 #include <glm/glm.hpp>
+#include <memory>
+#include <mir/geometry/rectangle.h>
 #include <mir/scene/surface.h>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
 #include <vector>
 
 namespace miracle
@@ -33,24 +41,98 @@ struct RenderData
     bool needs_outline = false;
     bool is_focused = false;
     glm::mat4 transform = glm::mat4(1.f);
-    glm::mat4 workspace_transform = glm::mat4(1.f);
+
+    /// The workspace of the window, whose transform is shared by all of its windows.
+    std::optional<uint32_t> workspace_id;
+};
+
+using RenderDataHandle = SlotMapHandle;
+
+/// A workspace switch that is animating on an output. While it is active, only
+/// the transforms of the workspaces change, so renderers may draw each workspace
+/// from a snapshot instead of drawing each of its windows.
+struct WorkspaceSwitch
+{
+    /// Identifies the switch, so that renderers know when to capture new snapshots.
+    uint64_t serial = 0;
+    mir::geometry::Rectangle output_area;
+
+    /// The workspaces with windows on the output, each of which is drawn as a layer.
+    std::vector<uint32_t> workspaces;
 };
 
+/// The [RenderData] of every container, indexed by surface for the renderer.
+struct RenderDataSnapshot
+{
+    SlotMap<RenderData> data;
+    std::unordered_map<mir::scene::Surface const*, RenderDataHandle> surface_index;
+
+    /// The output transform combined with the position of the workspace on its output.
+    std::unordered_map<uint32_t, glm::mat4> workspace_transforms;
+    std::vector<WorkspaceSwitch> workspace_switches;
+
+    [[nodiscard]] RenderData const* find(mir::scene::Surface const* surface) const;
+    [[nodiscard]] glm::mat4 workspace_transform(RenderData const& data) const;
+    [[nodiscard]] WorkspaceSwitch const* find_workspace_switch(mir::geometry::Rectangle const& output_area) const;
+    [[nodiscard]] RenderData const* get(RenderDataHandle const& handle) const;
+    [[nodiscard]] size_t size() const { return data.size(); }
+};
+
+/// Tracks the [RenderData] of every container on behalf of the renderers.
+///
+/// Changes are made to a working copy under a lock. Whenever something changes, an
+/// immutable [RenderDataSnapshot] is built from the working copy and published
+/// atomically, so that each renderer can read the latest snapshot once per frame
+/// without locking or copying.
 class RenderDataManager
 {
 public:
+    /// Defers publication of a new snapshot until the outermost [Batch] is
+    /// destroyed, so that many changes result in a single snapshot.
+    class Batch
+    {
+    public:
+        explicit Batch(RenderDataManager& manager);
+        ~Batch();
+        Batch(Batch const&) = delete;
+        Batch& operator=(Batch const&) = delete;
+
+    private:
+        RenderDataManager& manager;
+    };
+
     RenderDataManager();
-    void add(Container const&);
-    void remove(Container const&);
-    void transform_change(Container const&);
-    void workspace_transform_change(Container const&);
-    void focus_change(Container const&);
-    std::vector<RenderData> const& get();
+
+    /// Begins tracking the render data of [container]. The returned handle must
+    /// be used to update the data later on.
+    RenderDataHandle add(Container const&);
+    void remove(RenderDataHandle const&);
+    void transform_change(RenderDataHandle const&, Container const&);
+    void workspace_change(RenderDataHandle const&, Container const&);
+    void focus_change(RenderDataHandle const&, Container const&);
+
+    /// Sets the transform that is shared by every window on the workspace.
+    void set_workspace_transform(uint32_t workspace_id, glm::mat4 const& transform);
+    void remove_workspace(uint32_t workspace_id);
+
+    /// Begins a workspace switch on the output that covers [output_area].
+    /// \returns The serial that identifies the switch
+    uint64_t begin_workspace_switch(mir::geometry::Rectangle const& output_area, std::vector<uint32_t> workspaces);
+    void end_workspace_switch(uint64_t serial);
+
+    /// Returns the most recently published snapshot. This may be called from any thread.
+    [[nodiscard]] std::shared_ptr<RenderDataSnapshot const> get() const;
 
 private:
+    /// Must be called with [mutex] held.
+    void publish_locked();
+
     std::mutex mutex;
-    std::vector<RenderData> render_data;
-    std::vector<RenderData> copy_for_renderer;
+    RenderDataSnapshot render_data;
+    int batch_depth = 0;
+    bool has_changes = false;
+    uint64_t next_workspace_switch_serial = 1;
+    std::atomic<std::shared_ptr<RenderDataSnapshot const>> published;
 };
 
 } // miracle
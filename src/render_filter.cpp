@@ -0,0 +1,125 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "render_filter.h"
+
+#include <charconv>
+
+using namespace miracle;
+
+namespace
+{
+constexpr ColorMatrix identity { 1, 0, 0, 0, 1, 0, 0, 0, 1 };
+
+constexpr ColorMatrix multiply(ColorMatrix const& a, ColorMatrix const& b)
+{
+    ColorMatrix result {};
+    for (size_t row = 0; row < 3; row++)
+        for (size_t column = 0; column < 3; column++)
+            for (size_t k = 0; k < 3; k++)
+                result[row * 3 + column] += a[row * 3 + k] * b[k * 3 + column];
+    return result;
+}
+
+constexpr ColorMatrix add(ColorMatrix const& a, ColorMatrix const& b, float scale = 1.f)
+{
+    ColorMatrix result {};
+    for (size_t i = 0; i < result.size(); i++)
+        result[i] = a[i] + scale * b[i];
+    return result;
+}
+
+/// Folds daltonization into a single matrix: the colors that a user with the
+/// deficiency cannot see (original - simulated) are shifted into the channels
+/// that they can see, i.e. I + shift * (I - simulation).
+constexpr ColorMatrix daltonize(ColorMatrix const& simulation, ColorMatrix const& shift)
+{
+    return add(identity, multiply(shift, add(identity, simulation, -1.f)));
+}
+
+// Simulation matrices for full severity from Machado, Oliveira and Fernandes,
+// "A Physiologically-based Model for Simulation of Color Vision Deficiency" (2009).
+constexpr ColorMatrix protanopia_simulation {
+    0.152286f, 1.052583f, -0.204868f,
+    0.114503f, 0.786281f, 0.099216f,
+    -0.003882f, -0.048116f, 1.051998f
+};
+
+constexpr ColorMatrix deuteranopia_simulation {
+    0.367322f, 0.860646f, -0.227968f,
+    0.280085f, 0.672501f, 0.047413f,
+    -0.011820f, 0.042940f, 0.968881f
+};
+
+constexpr ColorMatrix tritanopia_simulation {
+    1.255528f, -0.076749f, -0.178779f,
+    -0.078411f, 0.930809f, 0.147602f,
+    0.004733f, 0.691367f, 0.303900f
+};
+
+/// Moves lost red into green and blue.
+constexpr ColorMatrix red_shift { 0, 0, 0, 0.7f, 1, 0, 0.7f, 0, 1 };
+
+/// Moves lost blue into red and green.
+constexpr ColorMatrix blue_shift { 1, 0, 0.7f, 0, 1, 0.7f, 0, 0, 0 };
+
+constexpr std::array<ColorMatrix, render_filter_count> color_matrices {
+    identity,
+    // Rec. 601 luma
+    ColorMatrix {
+                 0.299f, 0.587f, 0.114f,
+                 0.299f, 0.587f, 0.114f,
+                 0.299f, 0.587f, 0.114f },
+    daltonize(protanopia_simulation, red_shift),
+    daltonize(deuteranopia_simulation, red_shift),
+    daltonize(tritanopia_simulation, blue_shift)
+};
+}
+
+ColorMatrix miracle::color_matrix(RenderFilter filter)
+{
+    return color_matrices[static_cast<size_t>(filter)];
+}
+
+std::string miracle::filter_shader_source(RenderFilter filter)
+{
+    if (filter == RenderFilter::none)
+        return "vec4 apply_filter(vec4 color) {\n"
+               "    return color;\n"
+               "}\n";
+
+    // GLSL matrices are constructed column by column. std::to_chars is used as it
+    // does not depend on the locale.
+    auto const m = color_matrix(filter);
+    std::string matrix = "mat3(";
+    for (size_t column = 0; column < 3; column++)
+    {
+        for (size_t row = 0; row < 3; row++)
+        {
+            char value[32];
+            auto const result = std::to_chars(value, value + sizeof(value), m[row * 3 + column], std::chars_format::fixed, 6);
+            matrix.append(value, result.ptr);
+            matrix += column == 2 && row == 2 ? ")" : ", ";
+        }
+    }
+
+    // The alpha of opaque buffers may be undefined, so it is not used to clamp
+    return "const mat3 filter_matrix = " + matrix + ";\n"
+        + "vec4 apply_filter(vec4 color) {\n"
+          "    return vec4(clamp(filter_matrix * color.rgb, 0.0, 1.0), color.a);\n"
+          "}\n";
+}
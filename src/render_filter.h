@@ -0,0 +1,57 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLE_WM_RENDER_FILTER_H
+#define MIRACLE_WM_RENDER_FILTER_H
+
+#include <array>
+#include <cstddef>
+#include <string>
+
+namespace miracle
+{
+
+/// A color transform that is applied to everything that a renderable draws.
+enum class RenderFilter : int
+{
+    none,
+    grayscale,
+
+    /// Daltonize for users that are missing red (L) cones.
+    protanopia,
+
+    /// Daltonize for users that are missing green (M) cones.
+    deuteranopia,
+
+    /// Daltonize for users that are missing blue (S) cones.
+    tritanopia
+};
+
+constexpr size_t render_filter_count = 5;
+
+/// A 3x3 matrix in row-major order that is applied to RGB colors.
+using ColorMatrix = std::array<float, 9>;
+
+/// Returns the color transform of [filter].
+ColorMatrix color_matrix(RenderFilter filter);
+
+/// Returns GLSL that defines "vec4 apply_filter(vec4 color)" for [filter].
+std::string filter_shader_source(RenderFilter filter);
+
+} // miracle
+
+#endif // MIRACLE_WM_RENDER_FILTER_H
@@ -25,8 +25,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "tessellation_helpers.h"
 
 #include <EGL/egl.h>
+#include <EGL/eglext.h>
 #include <GLES2/gl2.h>
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <cstring>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <mir/graphics/buffer.h>
@@ -39,6 +43,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <mir/renderer/gl/gl_surface.h>
 #include <mir/scene/surface.h>
 #include <stdexcept>
+#include <time.h>
 
 namespace mg = mir::graphics;
 namespace mgl = mir::gl;
@@ -53,6 +58,14 @@ auto make_output_current(std::unique_ptr<mg::gl::OutputSurface> output) -> std::
     return output;
 }
 
+/// The CPU time consumed by the calling thread, which excludes time spent blocked.
+std::chrono::nanoseconds thread_cpu_time()
+{
+    timespec ts {};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
 class OutlineRenderable : public mir::graphics::Renderable
 {
 public:
@@ -145,6 +158,8 @@ Renderer::Renderer(
     program_factory { std::make_unique<ProgramFactory>() },
     display_transform(1),
     screen_to_gl_coords(1),
+    gpu_timer { std::make_unique<GpuTimer>() },
+    frame_timings { compositor_state->frame_timings()->add() },
     gl_interface { std::move(gl_interface) },
     config { config },
     compositor_state { compositor_state }
@@ -169,8 +184,15 @@ Renderer::Renderer(
             auto val = eglQueryString(disp, s.id);
             mir::log_info(std::string(s.label) + ": " + (val ? val : ""));
         }
+
+        auto const egl_extensions = eglQueryString(disp, EGL_EXTENSIONS);
+        has_buffer_age = egl_extensions
+            && (strstr(egl_extensions, "EGL_EXT_buffer_age") || strstr(egl_extensions, "EGL_KHR_partial_update"));
     }
 
+    if (!has_buffer_age)
+        mir::log_info("Buffer age is not supported, so damage tracking will always repaint the full output");
+
     struct
     {
         GLenum id;
@@ -204,9 +226,19 @@ Renderer::Renderer(
         rbits, gbits, bbits, abits, dbits, sbits);
 
     has_stencil_support = dbits > 0;
+    frame_timings->has_gpu_timings = gpu_timer->is_supported();
+    glGenBuffers(1, &vertex_buffer);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
+Renderer::~Renderer()
+{
+    output_surface->make_current();
+    draw_data.clear();
+    release_snapshots();
+    glDeleteBuffers(1, &vertex_buffer);
+}
+
 void Renderer::tessellate(
     std::vector<mgl::Primitive>& primitives,
     mg::Renderable const& renderable)
@@ -217,19 +249,25 @@ void Renderer::tessellate(
 
 Renderer::DrawData Renderer::get_draw_data(
     mir::graphics::Renderable const& renderable,
-    std::vector<RenderData> const& data) const
+    RenderDataSnapshot const& data,
+    WorkspaceSwitch const* workspace_switch) const
 {
     DrawData result = { true };
     auto surface = renderable.surface_if_any();
     if (surface)
     {
-        for (auto const& item : data)
+        if (auto const item = data.find(surface.value()))
         {
-            if (item.surface == surface.value())
-            {
-                result.data = item;
-                break;
-            }
+            result.data = *item;
+            result.workspace_transform = data.workspace_transform(*item);
+        }
+
+        if (workspace_switch && result.data.workspace_id)
+        {
+            auto const& workspaces = workspace_switch->workspaces;
+            auto const it = std::find(workspaces.begin(), workspaces.end(), result.data.workspace_id.value());
+            if (it != workspaces.end())
+                result.workspace_layer = (int)(it - workspaces.begin());
         }
     }
 
@@ -238,37 +276,216 @@ Renderer::DrawData Renderer::get_draw_data(
 
 auto Renderer::render(mg::RenderableList const& renderables) const -> std::unique_ptr<mg::Framebuffer>
 {
+    auto const cpu_start = thread_cpu_time();
     output_surface->make_current();
     output_surface->bind();
 
+    ++frameno;
+
+    // Mir shares this context, so nothing is known about its state at the start of a frame
+    gl_state.invalidate();
+
+    auto const render_data = compositor_state->render_data_manager()->get();
+    auto const rendering = config->rendering();
+    auto const border_config = config->get_border_config();
+    auto const selecting = compositor_state->mode() == WindowManagerMode::selecting;
+    auto const workspace_switch = rendering.workspace_snapshots
+        ? render_data->find_workspace_switch(viewport)
+        : nullptr;
+    analytic_borders = rendering.border_mode == BorderMode::analytic || !has_stencil_support;
+    draw_data.clear();
+    elements.clear();
+    if (!workspace_switch && !snapshots.empty())
+        release_snapshots();
+
+    for (auto const& r : renderables)
+    {
+        auto& data = draw_data.emplace_back(get_draw_data(*r, *render_data, workspace_switch));
+        auto const& element = elements.emplace_back(make_element(*r, data, border_config, selecting, rendering.filter));
+        data.filter = element.filter;
+        if (analytic_borders && element.outline_size > 0)
+            data.border = { true, element.outline_color, element.outline_size };
+    }
+
+    // The renderables that are drawn this frame
+    auto frame = &renderables;
+    if (workspace_switch)
+    {
+        if (workspace_switch->serial != snapshot_serial)
+            capture_snapshots(*workspace_switch, renderables);
+        else if (!snapshots_failed && !are_snapshots_current(renderables))
+        {
+            mir::log_debug("A window changed during a workspace switch, so the switch is drawn live");
+            snapshots_failed = true;
+            release_snapshots();
+        }
+
+        if (!snapshots_failed)
+        {
+            substitute_snapshots(renderables);
+            frame = &snapshot_frame;
+        }
+    }
+
+    if (rendering.fullscreen_fast_path && can_draw_fullscreen_only())
+    {
+        if (!drawing_fullscreen_only)
+            mir::log_debug("Drawing only the fullscreen surface");
+        drawing_fullscreen_only = true;
+        return render_fullscreen_only(*frame, cpu_start);
+    }
+    else if (drawing_fullscreen_only)
+    {
+        mir::log_debug("Drawing every surface again");
+        drawing_fullscreen_only = false;
+    }
+
+    occluded.assign(frame->size(), false);
+    if (rendering.occlusion_culling)
+        cull_occluded(*frame);
+
+    frame_scissor.reset();
+    std::optional<geom::Rectangle> damage;
+    if (rendering.damage_tracking)
+    {
+        damage = track_damage();
+        if (damage)
+            frame_scissor = to_gl_window_coordinates(damage.value());
+    }
+    else
+    {
+        was_tracking_damage = false;
+    }
+
+    if (frame_scissor && (damage->size.width.as_int() <= 0 || damage->size.height.as_int() <= 0))
+    {
+        // Nothing has changed since this buffer was last drawn
+        return commit(cpu_start);
+    }
+
+    gpu_timer->begin_frame();
+
+    if (frame_scissor)
+    {
+        gl_state.set_enabled(GL_SCISSOR_TEST, true);
+        gl_state.scissor(
+            frame_scissor->top_left.x.as_int(),
+            frame_scissor->top_left.y.as_int(),
+            frame_scissor->size.width.as_int(),
+            frame_scissor->size.height.as_int());
+    }
+    else
+    {
+        gl_state.set_enabled(GL_SCISSOR_TEST, false);
+    }
+
     glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
-    glClearStencil(0);
-    glStencilMask(0xFF);
     glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-    glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    gl_state.count_issued(2);
+    if (analytic_borders)
+    {
+        gl_state.set_enabled(GL_STENCIL_TEST, false);
+        glClear(GL_COLOR_BUFFER_BIT);
+        gl_state.count_issued();
+    }
+    else
+    {
+        glClearStencil(0);
+        gl_state.stencil_mask(0xFF);
+        glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+        gl_state.count_issued(2);
+    }
 
-    ++frameno;
+    draw_list.clear();
+    for (size_t i = 0; i < frame->size(); i++)
+    {
+        if (occluded[i])
+            continue;
 
-    auto const& render_data = compositor_state->render_data_manager()->get();
-    for (auto const& r : renderables)
+        if (frame_scissor && draw_bounds[i] && !draw_bounds[i]->overlaps(damage.value()))
+            continue;
+
+        draw_list.push_back(i);
+    }
+
+    upload_geometry(*frame);
+    for (auto const i : draw_list)
     {
-        auto data = draw(*r, get_draw_data(*r, render_data));
+        auto const& r = (*frame)[i];
+        auto data = draw(*r, draw_data[i]);
         if (data.enabled && data.outline_context.enabled)
         {
-            if (has_stencil_support)
-            {
-                OutlineRenderable outline(*r, data.outline_context.size, data.outline_context.color.a);
-                draw(outline, data);
-                glClear(GL_STENCIL_BUFFER_BIT);
-            }
-            else
-            {
-                mir::log_warning("Renderer::render: outlines are not supported for the provided surface");
-            }
+            OutlineRenderable outline(*r, data.outline_context.size, data.outline_context.color.a);
+            draw(outline, data);
+            glClear(GL_STENCIL_BUFFER_BIT);
+            gl_state.count_issued();
         }
     }
 
-    auto output = output_surface->commit();
+    return finish_frame(cpu_start);
+}
+
+bool Renderer::can_draw_fullscreen_only() const
+{
+    if (elements.empty())
+        return false;
+
+    // Letterboxed outputs have bars outside of the viewport that only the clear paints
+    auto const output_size = output_surface->size();
+    if (gl_viewport.top_left != mir::geometry::Point {}
+        || gl_viewport.size.width.as_int() != output_size.width.as_int()
+        || gl_viewport.size.height.as_int() != output_size.height.as_int())
+        return false;
+
+    // Any transform means that the surface is being animated
+    auto const& top = elements.back();
+    return !top.shaped
+        && top.alpha >= 1.f
+        && !top.clip_area
+        && top.outline_size == 0
+        && top.transform == glm::mat4(1.f)
+        && top.workspace_transform == glm::mat4(1.f)
+        && top.screen_position == viewport;
+}
+
+auto Renderer::render_fullscreen_only(mg::RenderableList const& renderables, std::chrono::nanoseconds cpu_start) const
+    -> std::unique_ptr<mg::Framebuffer>
+{
+    // The damage tracker does not see these frames, so the next composited frame repaints everything
+    was_tracking_damage = false;
+    frame_scissor.reset();
+    frame_timings->fullscreen_only_frames.fetch_add(1, std::memory_order_relaxed);
+
+    gpu_timer->begin_frame();
+
+    // The surface hides everything else and overwrites every pixel, so there is nothing to clear
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    gl_state.count_issued();
+    draw_list.assign(1, renderables.size() - 1);
+    upload_geometry(renderables);
+    draw(*renderables.back(), draw_data.back());
+    return finish_frame(cpu_start);
+}
+
+auto Renderer::finish_frame(std::chrono::nanoseconds cpu_start) const -> std::unique_ptr<mg::Framebuffer>
+{
+    // Leave the context as Mir expects to find it
+    gl_state.disable_vertex_attrib_arrays();
+    gl_state.bind_array_buffer(0);
+
+    gl_state.set_enabled(GL_SCISSOR_TEST, false);
+    frame_scissor.reset();
+
+    auto const counters = gl_state.take_counters();
+    if (counters.issued != gl_calls.issued || counters.elided != gl_calls.elided)
+    {
+        mir::log_debug("Frame issued %llu GL calls and elided %llu",
+            (unsigned long long)counters.issued, (unsigned long long)counters.elided);
+    }
+    gl_calls = counters;
+
+    gpu_timer->end_frame();
+    auto output = commit(cpu_start);
 
     // Report any GL errors after commit, to catch any *during* commit
     while (auto const gl_error = glGetError())
@@ -277,44 +494,467 @@ auto Renderer::render(mg::RenderableList const& renderables) const -> std::uniqu
     return output;
 }
 
+void Renderer::capture_snapshots(WorkspaceSwitch const& workspace_switch, mg::RenderableList const& renderables) const
+{
+    release_snapshots();
+    snapshot_serial = workspace_switch.serial;
+    snapshots_failed = false;
+    snapshots.resize(workspace_switch.workspaces.size());
+
+    // Windows are drawn as if their workspace were at rest. Every window is drawn with the
+    // bordered program, which writes the alpha that the snapshot is later blended with.
+    snapshot_draw_data = draw_data;
+    std::swap(draw_data, snapshot_draw_data);
+    for (size_t i = 0; i < draw_data.size(); i++)
+    {
+        auto& data = draw_data[i];
+        data.workspace_transform = glm::mat4(1.f);
+        if (!data.border.enabled)
+            data.border = { true, elements[i].outline_color, elements[i].outline_size };
+    }
+
+    auto const was_analytic = analytic_borders;
+    analytic_borders = true;
+    capturing = true;
+    frame_scissor.reset();
+    for (size_t layer = 0; layer < snapshots.size(); layer++)
+    {
+        draw_list.clear();
+        for (size_t i = 0; i < renderables.size(); i++)
+        {
+            if (draw_data[i].workspace_layer == (int)layer)
+                draw_list.push_back(i);
+        }
+
+        if (draw_list.empty())
+            continue;
+
+        auto snapshot = std::make_unique<WorkspaceSnapshot>(viewport);
+        if (!snapshot->bind())
+        {
+            mir::log_warning("Unable to draw into a workspace snapshot, so the switch is drawn live");
+            snapshots_failed = true;
+            break;
+        }
+
+        gl_state.set_enabled(GL_SCISSOR_TEST, false);
+        glClearColor(0.f, 0.f, 0.f, 0.f);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glClear(GL_COLOR_BUFFER_BIT);
+        gl_state.count_issued(3);
+
+        upload_geometry(renderables);
+        for (auto const i : draw_list)
+        {
+            draw(*renderables[i], draw_data[i]);
+            snapshot->sources.insert_or_assign(renderables[i]->surface_if_any().value(), elements[i].buffer_id);
+        }
+
+        snapshots[layer] = std::move(snapshot);
+    }
+
+    capturing = false;
+    analytic_borders = was_analytic;
+    std::swap(draw_data, snapshot_draw_data);
+    if (snapshots_failed)
+        release_snapshots();
+
+    // Mir may be drawing to a framebuffer of its own, so let the output bind it again
+    output_surface->bind();
+    glViewport(
+        gl_viewport.top_left.x.as_int(),
+        gl_viewport.top_left.y.as_int(),
+        gl_viewport.size.width.as_int(),
+        gl_viewport.size.height.as_int());
+    gl_state.count_issued();
+
+    // The damage tracker has never seen the snapshots, so begin again with a full repaint
+    was_tracking_damage = false;
+}
+
+bool Renderer::are_snapshots_current(mg::RenderableList const& renderables) const
+{
+    size_t matched = 0;
+    for (size_t i = 0; i < renderables.size(); i++)
+    {
+        auto const layer = draw_data[i].workspace_layer;
+        if (layer < 0)
+            continue;
+
+        // A window may have been opened on a workspace that was empty
+        auto const& snapshot = snapshots[layer];
+        if (!snapshot)
+            return false;
+
+        auto const it = snapshot->sources.find(renderables[i]->surface_if_any().value());
+        if (it == snapshot->sources.end() || it->second != elements[i].buffer_id)
+            return false;
+
+        matched++;
+    }
+
+    // Any window that is missing has been closed or hidden
+    size_t captured = 0;
+    for (auto const& snapshot : snapshots)
+    {
+        if (snapshot)
+            captured += snapshot->sources.size();
+    }
+
+    return matched == captured;
+}
+
+void Renderer::substitute_snapshots(mg::RenderableList const& renderables) const
+{
+    snapshot_frame.clear();
+    snapshot_draw_data.clear();
+    snapshot_elements.clear();
+    snapshot_placed.assign(snapshots.size(), false);
+    for (size_t i = 0; i < renderables.size(); i++)
+    {
+        auto const layer = draw_data[i].workspace_layer;
+        if (layer < 0)
+        {
+            snapshot_frame.push_back(renderables[i]);
+            snapshot_draw_data.push_back(draw_data[i]);
+            snapshot_elements.push_back(elements[i]);
+            continue;
+        }
+
+        // The snapshot takes the place of the lowest window of its workspace
+        if (snapshot_placed[layer])
+            continue;
+        snapshot_placed[layer] = true;
+
+        auto const& snapshot = snapshots[layer];
+        DrawData data { true };
+        data.workspace_transform = draw_data[i].workspace_transform;
+        data.workspace_layer = layer;
+        data.texture = snapshot->texture();
+        snapshot_frame.push_back(snapshot->renderable());
+        snapshot_elements.push_back(make_element(*snapshot->renderable(), data, {}, false, RenderFilter::none));
+        snapshot_draw_data.push_back(std::move(data));
+    }
+
+    std::swap(draw_data, snapshot_draw_data);
+    std::swap(elements, snapshot_elements);
+}
+
+void Renderer::release_snapshots() const
+{
+    snapshot_frame.clear();
+    snapshot_draw_data.clear();
+    snapshots.clear();
+}
+
+std::unique_ptr<mg::Framebuffer> Renderer::commit(std::chrono::nanoseconds cpu_start) const
+{
+    auto output = output_surface->commit();
+    frame_timings->cpu.record(thread_cpu_time() - cpu_start);
+
+    auto const now = std::chrono::steady_clock::now();
+    if (last_commit)
+        frame_timings->commit_interval.record(now - last_commit.value());
+    last_commit = now;
+
+    while (auto const gpu_time = gpu_timer->take_result())
+        frame_timings->gpu.record(gpu_time.value());
+
+    return output;
+}
+
+DamageTracker::Element Renderer::make_element(
+    mg::Renderable const& renderable,
+    DrawData const& data,
+    BorderConfig const& border_config,
+    bool selecting,
+    RenderFilter filter) const
+{
+    DamageTracker::Element element {
+        .id = renderable.id(),
+        .buffer_id = renderable.buffer()->id(),
+        .screen_position = renderable.screen_position(),
+        .src_bounds = renderable.src_bounds(),
+        .clip_area = renderable.clip_area(),
+        .alpha = renderable.alpha(),
+        .shaped = renderable.shaped(),
+        // While selecting, everything but the focused window is grayed out
+        .filter = selecting && !data.data.is_focused ? RenderFilter::grayscale : filter,
+        .transform = data.data.transform,
+        .workspace_transform = data.workspace_transform
+    };
+
+    if (data.data.needs_outline && border_config.size > 0)
+    {
+        element.outline_size = border_config.size;
+        element.outline_color = data.data.is_focused ? border_config.focus_color : border_config.color;
+    }
+
+    return element;
+}
+
+Renderer::Geometry Renderer::append_geometry(mg::Renderable const& renderable) const
+{
+    primitives.clear();
+    tessellate(primitives, renderable);
+
+    // tessellate() produces a single rectangle for every renderable
+    auto const& p = primitives[0];
+    Geometry geometry { p.type, (GLint)frame_vertices.size(), p.nvertices };
+    frame_vertices.insert(frame_vertices.end(), p.vertices, p.vertices + p.nvertices);
+    return geometry;
+}
+
+void Renderer::upload_geometry(mg::RenderableList const& renderables) const
+{
+    frame_vertices.clear();
+    for (auto const i : draw_list)
+    {
+        auto const& r = *renderables[i];
+        auto& data = draw_data[i];
+        data.geometry = append_geometry(r);
+        if (data.border.enabled)
+        {
+            // Sampling stops at the edge of the original rectangle, beyond which is the border
+            auto const vertices = frame_vertices.begin() + data.geometry.first;
+            data.border.content_bounds = {
+                std::min(vertices[0].texcoord[0], vertices[3].texcoord[0]),
+                std::min(vertices[0].texcoord[1], vertices[3].texcoord[1]),
+                std::max(vertices[0].texcoord[0], vertices[3].texcoord[0]),
+                std::max(vertices[0].texcoord[1], vertices[3].texcoord[1])
+            };
+
+            mgl::Primitive rectangle;
+            rectangle.nvertices = data.geometry.count;
+            std::copy_n(vertices, data.geometry.count, rectangle.vertices);
+            mgl::outset_rectangle(rectangle, data.border.size);
+            std::copy_n(rectangle.vertices, data.geometry.count, vertices);
+        }
+        else if (!analytic_borders && elements[i].outline_size > 0)
+        {
+            OutlineRenderable outline(r, elements[i].outline_size, elements[i].outline_color.a);
+            data.outline_geometry = append_geometry(outline);
+        }
+    }
+
+    // Orphan the previous contents so that the driver need not wait on the last frame
+    auto const size = (GLsizeiptr)(frame_vertices.size() * sizeof(mgl::Vertex));
+    gl_state.bind_array_buffer(vertex_buffer);
+    if (size > vertex_buffer_capacity)
+        vertex_buffer_capacity = std::max(size, 2 * vertex_buffer_capacity);
+    glBufferData(GL_ARRAY_BUFFER, vertex_buffer_capacity, nullptr, GL_STREAM_DRAW);
+    gl_state.count_issued();
+    if (size > 0)
+    {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, size, frame_vertices.data());
+        gl_state.count_issued();
+    }
+}
+
+void Renderer::cull_occluded(mg::RenderableList const& renderables) const
+{
+    occludables.clear();
+    for (size_t i = 0; i < renderables.size(); i++)
+    {
+        auto const& r = renderables[i];
+        auto const& element = elements[i];
+        Occludable occludable { DamageTracker::bounds_of(element), std::nullopt };
+
+        // Only RGBX surfaces without window translucency are drawn without blending
+        if (!r->shaped() && r->alpha() >= 1.f)
+        {
+            occludable.opaque_area = opaque_bounds(element.screen_position, element.transform, element.workspace_transform);
+            if (occludable.opaque_area && element.clip_area)
+            {
+                auto const clip = opaque_bounds(element.clip_area.value(), glm::mat4(1.f), element.workspace_transform);
+                if (clip)
+                    occludable.opaque_area = occludable.opaque_area->intersection_with(clip.value());
+                else
+                    occludable.opaque_area.reset();
+            }
+        }
+
+        occludables.push_back(occludable);
+    }
+
+    auto const count = find_occluded(occludables, occluded);
+    if (count != culled_count)
+    {
+        mir::log_debug("Occlusion culling skipped %zu of %zu renderables", count, renderables.size());
+        culled_count = count;
+    }
+}
+
+std::optional<geom::Rectangle> Renderer::track_damage() const
+{
+    damage_tracker.begin_frame(viewport);
+    if (!was_tracking_damage)
+    {
+        // The tracker knows nothing about the frames that were drawn while it was disabled
+        damage_tracker.damage_all();
+        was_tracking_damage = true;
+    }
+
+    draw_bounds.clear();
+    for (auto const& element : elements)
+        draw_bounds.push_back(damage_tracker.add(element));
+
+    return damage_tracker.end_frame(query_buffer_age());
+}
+
+int Renderer::query_buffer_age() const
+{
+    if (!has_buffer_age)
+        return 0;
+
+    // Mir may be drawing to an offscreen framebuffer, whose age EGL cannot tell us
+    GLint framebuffer = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+    if (framebuffer != 0)
+        return 0;
+
+    auto const display = eglGetCurrentDisplay();
+    auto const surface = eglGetCurrentSurface(EGL_DRAW);
+    if (display == EGL_NO_DISPLAY || surface == EGL_NO_SURFACE)
+        return 0;
+
+    EGLint age = 0;
+    if (eglQuerySurface(display, surface, EGL_BUFFER_AGE_EXT, &age) != EGL_TRUE)
+        return 0;
+
+    return age;
+}
+
+std::optional<geom::Rectangle> Renderer::to_gl_window_coordinates(geom::Rectangle const& area) const
+{
+    static glm::mat4 const flip_y = {
+        1.0, 0.0, 0.0, 0.0,
+        0.0, -1.0, 0.0, 0.0,
+        0.0, 0.0, 1.0, 0.0,
+        0.0, 0.0, 0.0, 1.0
+    };
+
+    // Rotated outputs are always repainted in full
+    bool flipped;
+    if (display_transform == glm::mat4(1.f))
+        flipped = false;
+    else if (display_transform == flip_y)
+        flipped = true;
+    else
+        return std::nullopt;
+
+    auto const viewport_width = (float)viewport.size.width.as_int();
+    auto const viewport_height = (float)viewport.size.height.as_int();
+    if (viewport_width <= 0 || viewport_height <= 0)
+        return std::nullopt;
+
+    auto const scale_x = (float)gl_viewport.size.width.as_int() / viewport_width;
+    auto const scale_y = (float)gl_viewport.size.height.as_int() / viewport_height;
+    auto const left = (float)(area.top_left.x.as_int() - viewport.top_left.x.as_int());
+    auto const top = (float)(area.top_left.y.as_int() - viewport.top_left.y.as_int());
+    auto const right = left + (float)area.size.width.as_int();
+    auto const bottom = top + (float)area.size.height.as_int();
+
+    // GL window coordinates start at the bottom of the output unless the output is flipped
+    auto const gl_bottom = flipped ? top : viewport_height - bottom;
+    auto const gl_top = flipped ? bottom : viewport_height - top;
+
+    auto const x1 = gl_viewport.top_left.x.as_int() + (int)std::floor(left * scale_x);
+    auto const y1 = gl_viewport.top_left.y.as_int() + (int)std::floor(gl_bottom * scale_y);
+    auto const x2 = gl_viewport.top_left.x.as_int() + (int)std::ceil(right * scale_x);
+    auto const y2 = gl_viewport.top_left.y.as_int() + (int)std::ceil(gl_top * scale_y);
+    return geom::Rectangle {
+        { x1, y1 },
+        { x2 - x1, y2 - y1 }
+    };
+}
+
 miracle::Renderer::DrawData Renderer::draw(
     mg::Renderable const& renderable,
     DrawData const& data) const
 {
-    auto const texture = gl_interface->as_texture(renderable.buffer());
-    auto const clip_area = renderable.clip_area();
+    static glm::mat4 const identity(1.f);
+    static glm::mat4 const flip_y = {
+        1.0, 0.0, 0.0, 0.0,
+        0.0, -1.0, 0.0, 0.0,
+        0.0, 0.0, 1.0, 0.0,
+        0.0, 0.0, 0.0, 1.0
+    };
+
+    // Snapshots are drawn without the display transform and with their top row first
+    auto const& output_transform = capturing ? identity : display_transform;
+    auto const projection = capturing ? flip_y * screen_to_gl_coords : screen_to_gl_coords;
+
+    auto const texture = data.texture ? data.texture : gl_interface->as_texture(renderable.buffer());
+    auto clip_area = renderable.clip_area();
+    if (clip_area && data.border.enabled)
+    {
+        // The border is drawn outside of the surface, so it must not be clipped away
+        clip_area->top_left = {
+            clip_area->top_left.x.as_int() - data.border.size,
+            clip_area->top_left.y.as_int() - data.border.size
+        };
+        clip_area->size = {
+            clip_area->size.width.as_int() + 2 * data.border.size,
+            clip_area->size.height.as_int() + 2 * data.border.size
+        };
+    }
+
     if (clip_area)
     {
-        glEnable(GL_SCISSOR_TEST);
-        // The Y-coordinate is always relative to the top, so we make it relative to the bottom.
-        auto clip_y = viewport.top_left.y.as_int() + viewport.size.height.as_int()
-            - clip_area.value().top_left.y.as_int() - clip_area.value().size.height.as_int();
+        gl_state.set_enabled(GL_SCISSOR_TEST, true);
+        // The Y-coordinate is always relative to the top, so we make it relative to the bottom,
+        // unless we are drawing into a snapshot.
+        auto clip_y = capturing
+            ? clip_area.value().top_left.y.as_int() - viewport.top_left.y.as_int()
+            : viewport.top_left.y.as_int() + viewport.size.height.as_int()
+                - clip_area.value().top_left.y.as_int() - clip_area.value().size.height.as_int();
         glm::vec4 clip_pos(clip_area.value().top_left.x.as_int(), clip_y, 0, 1);
-        clip_pos = display_transform * data.data.workspace_transform * clip_pos;
+        clip_pos = output_transform * data.workspace_transform * clip_pos;
 
-        glScissor(
-            (int)clip_pos.x - viewport.top_left.x.as_int(),
-            (int)clip_pos.y,
-            clip_area.value().size.width.as_int(),
-            clip_area.value().size.height.as_int());
+        geom::Rectangle scissor {
+            { (int)clip_pos.x - viewport.top_left.x.as_int(), (int)clip_pos.y },
+            clip_area.value().size
+        };
+        if (frame_scissor)
+            scissor = scissor.intersection_with(frame_scissor.value());
+
+        gl_state.scissor(
+            scissor.top_left.x.as_int(),
+            scissor.top_left.y.as_int(),
+            scissor.size.width.as_int(),
+            scissor.size.height.as_int());
+    }
+    else if (frame_scissor)
+    {
+        gl_state.set_enabled(GL_SCISSOR_TEST, true);
+        gl_state.scissor(
+            frame_scissor->top_left.x.as_int(),
+            frame_scissor->top_left.y.as_int(),
+            frame_scissor->size.width.as_int(),
+            frame_scissor->size.height.as_int());
+    }
+    else
+    {
+        gl_state.set_enabled(GL_SCISSOR_TEST, false);
     }
 
     // Resource: https://stackoverflow.com/questions/48246302/writing-to-the-opengl-stencil-buffer
     if (data.outline_context.enabled)
     {
-        glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
-        glStencilFunc(GL_NOTEQUAL, 1, 0xFF);
+        gl_state.stencil_op(GL_KEEP, GL_KEEP, GL_KEEP);
+        gl_state.stencil_func(GL_NOTEQUAL, 1, 0xFF);
     }
-    else if (data.data.needs_outline)
+    else if (data.data.needs_outline && !analytic_borders)
     {
-        glEnable(GL_STENCIL_TEST);
-        glStencilFunc(GL_ALWAYS, 1, 0xFF);
-        glStencilMask(0xFF);
-        glStencilOp(GL_REPLACE, GL_REPLACE, GL_REPLACE);
+        gl_state.set_enabled(GL_STENCIL_TEST, true);
+        gl_state.stencil_func(GL_ALWAYS, 1, 0xFF);
+        gl_state.stencil_mask(0xFF);
+        gl_state.stencil_op(GL_REPLACE, GL_REPLACE, GL_REPLACE);
     }
     else
     {
-        glDisable(GL_STENCIL_TEST);
+        gl_state.set_enabled(GL_STENCIL_TEST, false);
     }
 
     // All the programs are held by program_factory through its lifetime. Using pointers avoids
@@ -322,38 +962,34 @@ miracle::Renderer::DrawData Renderer::draw(
     auto const* const prog =
         [&](bool alpha) -> ProgramData const*
     {
-        auto const& family = dynamic_cast<Program const&>(texture->shader(*program_factory));
+        auto const& family = dynamic_cast<Program const&>(texture->shader(*program_factory)).variant(data.filter);
         if (data.outline_context.enabled)
             return &family.outline;
+        if (data.border.enabled)
+            return &family.bordered;
         if (alpha)
             return &family.alpha;
         return &family.opaque;
     }(renderable.alpha() < 1.0f);
 
-    glUseProgram(prog->id);
-    if (prog->last_used_frameno != frameno)
-    { // Avoid reloading the screen-global uniforms on every renderable
-        // TODO: We actually only need to bind these *once*, right? Not once per frame?
-        prog->last_used_frameno = frameno;
-        for (auto i = 0u; i < prog->tex_uniforms.size(); ++i)
-        {
-            if (prog->tex_uniforms[i] != -1)
-            {
-                glUniform1i(prog->tex_uniforms[i], (int)i);
-            }
-        }
-        glUniformMatrix4fv(prog->display_transform_uniform, 1, GL_FALSE,
-            glm::value_ptr(display_transform));
-        glUniformMatrix4fv(prog->screen_to_gl_coords_uniform, 1, GL_FALSE,
-            glm::value_ptr(screen_to_gl_coords));
-    }
+    // Uniforms that have not changed since the program was last used are elided by the tracker
+    auto& uniforms = prog->uniforms;
+    gl_state.use_program(prog->id);
+    for (auto i = 0u; i < prog->tex_uniforms.size(); ++i)
+        gl_state.uniform(uniforms, prog->tex_uniforms[i], (GLint)i);
+    gl_state.uniform(uniforms, prog->display_transform_uniform, output_transform);
+    gl_state.uniform(uniforms, prog->screen_to_gl_coords_uniform, projection);
 
+    // Texture binding is left to Mir, so the active unit is not tracked
     glActiveTexture(GL_TEXTURE0);
+    gl_state.count_issued();
 
+    // Bordered surfaces are transformed about the corner of their border, just
+    // like the outline drawn by the stencil path.
     auto const& rect = renderable.screen_position();
-    GLfloat const top_left_x = (float)rect.top_left.x.as_int();
-    GLfloat const top_left_y = (float)rect.top_left.y.as_int();
-    glUniform2f(prog->topleft_uniform, top_left_x, top_left_y);
+    GLfloat const top_left_x = (float)(rect.top_left.x.as_int() - data.border.size);
+    GLfloat const top_left_y = (float)(rect.top_left.y.as_int() - data.border.size);
+    gl_state.uniform(uniforms, prog->topleft_uniform, glm::vec2(top_left_x, top_left_y));
 
     glm::mat4 transform = data.data.transform;
     if (texture->layout() == mg::gl::Texture::Layout::TopRowFirst)
@@ -368,43 +1004,29 @@ miracle::Renderer::DrawData Renderer::draw(
         };
     }
 
-    glUniformMatrix4fv(prog->transform_uniform, 1, GL_FALSE,
-        glm::value_ptr(transform));
+    gl_state.uniform(uniforms, prog->transform_uniform, transform);
 
     if (prog->alpha_uniform >= 0)
-        glUniform1f(prog->alpha_uniform, renderable.alpha());
+        gl_state.uniform(uniforms, prog->alpha_uniform, renderable.alpha());
 
-    switch (compositor_state->mode())
-    {
-    case WindowManagerMode::selecting:
-        glUniform1i(prog->mode_uniform, (int)(data.data.is_focused ? RenderFilter::none : RenderFilter::grayscale));
-        break;
-    default:
-        glUniform1i(prog->mode_uniform, (int)RenderFilter::none);
-        break;
-    }
-
-    glUniformMatrix4fv(prog->workspace_transform_uniform, 1, GL_FALSE,
-        glm::value_ptr(data.data.workspace_transform));
+    gl_state.uniform(uniforms, prog->workspace_transform_uniform, data.workspace_transform);
 
     if (prog->outline_color_uniform >= 0 && data.outline_context.enabled)
+        gl_state.uniform(uniforms, prog->outline_color_uniform, data.outline_context.color);
+
+    if (data.border.enabled)
     {
-        glUniform4f(
-            prog->outline_color_uniform,
-            data.outline_context.color.r,
-            data.outline_context.color.g,
-            data.outline_context.color.b,
-            data.outline_context.color.a);
+        gl_state.uniform(uniforms, prog->outline_color_uniform, data.border.color);
+        gl_state.uniform(uniforms, prog->content_bounds_uniform, data.border.content_bounds);
+        gl_state.uniform(uniforms, prog->shaped_uniform, (GLint)(renderable.shaped() ? 1 : 0));
     }
 
-    glEnableVertexAttribArray(prog->position_attr);
+    // Vertex attribute arrays stay enabled until the end of the frame
+    gl_state.enable_vertex_attrib_array(prog->position_attr);
 
     bool has_texcoord_attr = prog->texcoord_attr >= 0;
     if (has_texcoord_attr)
-        glEnableVertexAttribArray(prog->texcoord_attr);
-
-    primitives.clear();
-    tessellate(primitives, renderable);
+        gl_state.enable_vertex_attrib_array(prog->texcoord_attr);
 
     // if we fail to load the texture, we need to carry on (part of lp:1629275)
     try
@@ -417,7 +1039,17 @@ miracle::Renderer::DrawData Renderer::draw(
         BlendSeparate client_blend;
 
         // These renderable method names could be better (see LP: #1236224)
-        if (renderable.shaped()) // Client is RGBA:
+        if (data.border.enabled)
+        {
+            // The bordered program outputs premultiplied alpha for both the border and the surface
+            if (!renderable.shaped() && renderable.alpha() == 1.0f && data.border.color.a >= 1.0f)
+                client_blend = { GL_ONE, GL_ZERO,
+                    GL_ZERO, GL_ONE };
+            else
+                client_blend = { GL_ONE, GL_ONE_MINUS_SRC_ALPHA,
+                    GL_ONE, GL_ONE_MINUS_SRC_ALPHA };
+        }
+        else if (renderable.shaped()) // Client is RGBA:
         {
             client_blend = { GL_ONE, GL_ONE_MINUS_SRC_ALPHA,
                 GL_ONE, GL_ONE_MINUS_SRC_ALPHA };
@@ -433,71 +1065,54 @@ miracle::Renderer::DrawData Renderer::draw(
             // careful and avoid using SRC_ALPHA (LP: #1423462).
             client_blend = { GL_ONE, GL_ONE_MINUS_CONSTANT_ALPHA,
                 GL_ZERO, GL_ONE };
-            glBlendColor(0.0f, 0.0f, 0.0f, renderable.alpha());
+            gl_state.blend_color(0.0f, 0.0f, 0.0f, renderable.alpha());
         }
 
-        for (auto const& p : primitives)
-        {
-            BlendSeparate blend;
-
-            blend = client_blend;
-            texture->bind();
+        BlendSeparate const blend = client_blend;
+        texture->bind();
 
-            glVertexAttribPointer(prog->position_attr, 3, GL_FLOAT,
-                GL_FALSE, sizeof(mgl::Vertex),
-                &p.vertices[0].position);
+        // The vertices of the whole frame live in vertex_buffer, so attributes are offsets into it
+        gl_state.vertex_attrib_pointer(prog->position_attr, 3, GL_FLOAT,
+            sizeof(mgl::Vertex), offsetof(mgl::Vertex, position));
 
-            if (has_texcoord_attr)
-            {
-                glVertexAttribPointer(prog->texcoord_attr, 2, GL_FLOAT,
-                    GL_FALSE, sizeof(mgl::Vertex),
-                    &p.vertices[0].texcoord);
-            }
+        if (has_texcoord_attr)
+        {
+            gl_state.vertex_attrib_pointer(prog->texcoord_attr, 2, GL_FLOAT,
+                sizeof(mgl::Vertex), offsetof(mgl::Vertex, texcoord));
+        }
 
-            if (blend.dst_rgb == GL_ZERO)
-            {
-                glDisable(GL_BLEND);
-            }
-            else
-            {
-                glEnable(GL_BLEND);
-                glBlendFuncSeparate(blend.src_rgb, blend.dst_rgb,
-                    blend.src_alpha, blend.dst_alpha);
-            }
+        if (blend.dst_rgb == GL_ZERO)
+        {
+            gl_state.set_enabled(GL_BLEND, false);
+        }
+        else
+        {
+            gl_state.set_enabled(GL_BLEND, true);
+            gl_state.blend_func_separate(blend.src_rgb, blend.dst_rgb,
+                blend.src_alpha, blend.dst_alpha);
+        }
 
-            glDrawArrays(p.type, 0, p.nvertices);
+        glDrawArrays(data.geometry.type, data.geometry.first, data.geometry.count);
+        gl_state.count_issued();
 
-            // We're done with the texture for now
-            texture->add_syncpoint();
-        }
+        // We're done with the texture for now
+        texture->add_syncpoint();
     }
     catch (std::exception const& ex)
     {
     }
 
-    if (has_texcoord_attr)
-        glDisableVertexAttribArray(prog->texcoord_attr);
-
-    glDisableVertexAttribArray(prog->position_attr);
-    if (renderable.clip_area())
-    {
-        glDisable(GL_SCISSOR_TEST);
-    }
-
     // Next, draw the outline if we have container to facilitate it
-    if (data.data.needs_outline)
+    if (data.data.needs_outline && !analytic_borders)
     {
         auto border_config = config->get_border_config();
         if (border_config.size > 0)
         {
             auto color = data.data.is_focused ? border_config.focus_color : border_config.color;
-            return DrawData {
-                true,
-                data.data,
-                { true,
-                       color,
-                       border_config.size }
-            };
+            DrawData outline { true, data.data, data.filter, data.workspace_transform };
+            outline.outline_context = { true, color, border_config.size };
+            outline.geometry = data.outline_geometry;
+            return outline;
         }
     }
 
@@ -543,6 +1158,7 @@ void Renderer::set_viewport(mir::geometry::Rectangle const& rect)
             0.0f });
 
     viewport = rect;
+    frame_timings->area(rect);
     update_gl_viewport();
 }
 
@@ -574,6 +1190,10 @@ void Renderer::update_gl_viewport()
         GLint offset_y = (output_height - reduced_height) / 2;
 
         glViewport(offset_x, offset_y, reduced_width, reduced_height);
+        gl_viewport = {
+            { offset_x, offset_y },
+            { reduced_width, reduced_height }
+        };
     }
 }
 
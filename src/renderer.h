@@ -18,16 +18,24 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef MIR_RENDERER_GL_RENDERER_H_
 #define MIR_RENDERER_GL_RENDERER_H_
 
+#include "damage_tracker.h"
+#include "frame_timings.h"
+#include "gl_state_tracker.h"
+#include "gpu_timer.h"
+#include "occlusion.h"
 #include "primitive.h"
 #include "program_factory.h"
 #include "render_data_manager.h"
+#include "workspace_snapshot.h"
 
 #include <GLES2/gl2.h>
+#include <chrono>
 #include <mir/geometry/rectangle.h>
 #include <mir/graphics/buffer_id.h>
 #include <mir/graphics/renderable.h>
 #include <mir/renderer/renderer.h>
 #include <miral/window_manager_tools.h>
+#include <optional>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -41,12 +49,14 @@ namespace graphics
 namespace graphics::gl
 {
     class OutputSurface;
+    class Texture;
 }
 }
 
 namespace miracle
 {
 class Config;
+struct BorderConfig;
 class CompositorState;
 class WindowToolsAccessor;
 class Animator;
@@ -58,7 +68,7 @@ public:
         std::unique_ptr<mir::graphics::gl::OutputSurface> output,
         std::shared_ptr<Config> const& config,
         std::shared_ptr<CompositorState> const& compositor_state);
-    ~Renderer() override = default;
+    ~Renderer() override;
 
     // These are called with a valid GL context:
     void set_viewport(mir::geometry::Rectangle const& rect) override;
@@ -88,10 +98,28 @@ private:
     static void tessellate(std::vector<mir::gl::Primitive>& primitives,
         mir::graphics::Renderable const& renderable);
 
+    /// A range of vertices in the vertex buffer of the current frame.
+    struct Geometry
+    {
+        GLenum type = GL_TRIANGLE_STRIP;
+        GLint first = 0;
+        GLsizei count = 0;
+    };
+
     struct DrawData
     {
         bool enabled = false;
         RenderData data;
+        RenderFilter filter = RenderFilter::none;
+
+        /// The transform of the workspace of the renderable, resolved once per frame.
+        glm::mat4 workspace_transform = glm::mat4(1.f);
+
+        /// The layer of the workspace switch that the renderable belongs to, or -1 if none.
+        int workspace_layer = -1;
+
+        /// Drawn instead of the buffer of the renderable when set.
+        std::shared_ptr<mir::graphics::gl::Texture> texture;
 
         struct
         {
@@ -99,22 +127,136 @@ private:
             glm::vec4 color;
             int size;
         } outline_context;
+
+        /// Set when the border is drawn in the same pass as the surface.
+        struct
+        {
+            bool enabled = false;
+            glm::vec4 color;
+            int size = 0;
+
+            /// The texture coordinates of the surface itself, as (left, top, right, bottom).
+            glm::vec4 content_bounds;
+        } border;
+
+        Geometry geometry;
+
+        /// The enlarged quad that is drawn around the surface when outlining with the stencil buffer.
+        Geometry outline_geometry;
     };
 
-    DrawData get_draw_data(mir::graphics::Renderable const&, std::vector<RenderData> const& data) const;
+    DrawData get_draw_data(
+        mir::graphics::Renderable const&,
+        RenderDataSnapshot const& data,
+        WorkspaceSwitch const* workspace_switch) const;
     /// Draws the current renderable and returns a follow-up draw if required.
     DrawData draw(mir::graphics::Renderable const& renderable, DrawData const& data) const;
     void update_gl_viewport();
 
+    DamageTracker::Element make_element(
+        mir::graphics::Renderable const& renderable,
+        DrawData const& data,
+        BorderConfig const& border_config,
+        bool selecting,
+        RenderFilter filter) const;
+
+    /// Tessellates [renderable] into the vertices of the current frame.
+    Geometry append_geometry(mir::graphics::Renderable const& renderable) const;
+
+    /// Tessellates every renderable in [draw_list] and uploads the result to [vertex_buffer]
+    /// in a single call, so that each draw only needs to reference its offset.
+    void upload_geometry(mir::graphics::RenderableList const& renderables) const;
+
+    /// Marks the renderables of this frame that are hidden behind opaque renderables.
+    void cull_occluded(mir::graphics::RenderableList const& renderables) const;
+
+    /// Feeds the elements of this frame to the damage tracker and returns the region
+    /// of the viewport that must be repainted, or std::nullopt to repaint everything.
+    std::optional<mir::geometry::Rectangle> track_damage() const;
+
+    /// Returns the age of the buffer that is about to be drawn to, or 0 if it is unknown.
+    int query_buffer_age() const;
+
+    /// Converts a rectangle in the logical coordinates of the viewport to GL window
+    /// coordinates, or returns std::nullopt if the display transform is not supported.
+    std::optional<mir::geometry::Rectangle> to_gl_window_coordinates(mir::geometry::Rectangle const&) const;
+
+    /// True if the topmost renderable is an opaque, untransformed and unclipped surface
+    /// without an outline that covers the whole viewport, which hides everything else,
+    /// and the viewport fills the output without letterboxing.
+    bool can_draw_fullscreen_only() const;
+
+    /// Draws only the topmost renderable, without clearing, culling or tracking damage.
+    /// The frame is still composited with GL; this is not direct scanout.
+    auto render_fullscreen_only(mir::graphics::RenderableList const& renderables, std::chrono::nanoseconds cpu_start) const
+        -> std::unique_ptr<mir::graphics::Framebuffer>;
+
+    /// Restores the GL state that Mir expects and commits the frame.
+    auto finish_frame(std::chrono::nanoseconds cpu_start) const -> std::unique_ptr<mir::graphics::Framebuffer>;
+
+    /// Draws the windows of each layer of [workspace_switch] into a new snapshot.
+    void capture_snapshots(WorkspaceSwitch const& workspace_switch, mir::graphics::RenderableList const& renderables) const;
+
+    /// True if every window of the workspace switch is still showing what was captured.
+    bool are_snapshots_current(mir::graphics::RenderableList const& renderables) const;
+
+    /// Replaces the windows of each layer with its snapshot in the lists of this frame.
+    void substitute_snapshots(mir::graphics::RenderableList const& renderables) const;
+
+    void release_snapshots() const;
+
+    /// Commits the frame and records its timings.
+    /// \param cpu_start The CPU time of the render thread when the frame began
+    std::unique_ptr<mir::graphics::Framebuffer> commit(std::chrono::nanoseconds cpu_start) const;
+
     std::unique_ptr<mir::graphics::gl::OutputSurface> const output_surface;
     GLfloat clear_color[4];
     bool has_stencil_support = false;
+    bool has_buffer_age = false;
+    /// True when borders are drawn analytically during this frame instead of with the stencil buffer.
+    bool mutable analytic_borders = false;
     mutable long long frameno = 0;
     std::unique_ptr<ProgramFactory> const program_factory;
     mir::geometry::Rectangle viewport;
+    mir::geometry::Rectangle gl_viewport;
     glm::mat4 screen_to_gl_coords;
     glm::mat4 display_transform;
     std::vector<mir::gl::Primitive> mutable primitives;
+    std::vector<mir::gl::Vertex> mutable frame_vertices;
+    GLuint vertex_buffer = 0;
+    GLsizeiptr mutable vertex_buffer_capacity = 0;
+    /// The indices of the renderables that are drawn during this frame.
+    std::vector<size_t> mutable draw_list;
+    GLStateTracker mutable gl_state;
+    /// The GL calls that were issued and elided during the last frame.
+    GLStateTracker::Counters mutable gl_calls;
+    std::vector<DrawData> mutable draw_data;
+    std::vector<DamageTracker::Element> mutable elements;
+    std::vector<Occludable> mutable occludables;
+    std::vector<bool> mutable occluded;
+    size_t mutable culled_count = 0;
+    std::vector<std::optional<mir::geometry::Rectangle>> mutable draw_bounds;
+    DamageTracker mutable damage_tracker;
+    bool mutable was_tracking_damage = false;
+    /// True while frames are drawn with [render_fullscreen_only].
+    bool mutable drawing_fullscreen_only = false;
+    /// The workspace switch that [snapshots] were captured for.
+    uint64_t mutable snapshot_serial = 0;
+    /// True when the snapshots are out of date, so the switch is drawn live.
+    bool mutable snapshots_failed = false;
+    /// True while windows are drawn into a snapshot.
+    bool mutable capturing = false;
+    /// The snapshot of each layer of the workspace switch, if it has windows.
+    std::vector<std::unique_ptr<WorkspaceSnapshot>> mutable snapshots;
+    mir::graphics::RenderableList mutable snapshot_frame;
+    std::vector<DrawData> mutable snapshot_draw_data;
+    std::vector<DamageTracker::Element> mutable snapshot_elements;
+    std::vector<bool> mutable snapshot_placed;
+    /// When set, drawing is restricted to this area in GL window coordinates.
+    std::optional<mir::geometry::Rectangle> mutable frame_scissor;
+    std::unique_ptr<GpuTimer> const gpu_timer;
+    std::shared_ptr<FrameTimings> const frame_timings;
+    std::optional<std::chrono::steady_clock::time_point> mutable last_commit;
     std::shared_ptr<mir::graphics::GLRenderingProvider> const gl_interface;
     std::shared_ptr<Config> config;
     std::shared_ptr<CompositorState> compositor_state;
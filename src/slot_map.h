@@ -0,0 +1,142 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLE_WM_SLOT_MAP_H
+#define MIRACLE_WM_SLOT_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace miracle
+{
+
+/// A handle to a value stored in a [SlotMap]. A handle stays valid until its value
+/// is erased, after which it will never refer to another value, even if its slot
+/// is reused.
+struct SlotMapHandle
+{
+    static constexpr uint32_t invalid_index = std::numeric_limits<uint32_t>::max();
+
+    uint32_t index = invalid_index;
+    uint32_t generation = 0;
+
+    [[nodiscard]] bool is_valid() const { return index != invalid_index; }
+    bool operator==(SlotMapHandle const&) const = default;
+};
+
+/// Stores values contiguously while providing constant time insertion, removal
+/// and lookup through generational handles.
+template <typename T>
+class SlotMap
+{
+public:
+    using Handle = SlotMapHandle;
+
+    Handle insert(T value)
+    {
+        uint32_t index;
+        if (free_head != Handle::invalid_index)
+        {
+            index = free_head;
+            free_head = slots[index].dense_index;
+        }
+        else
+        {
+            index = static_cast<uint32_t>(slots.size());
+            slots.push_back({});
+        }
+
+        slots[index].dense_index = static_cast<uint32_t>(dense.size());
+        dense.push_back(std::move(value));
+        dense_to_slot.push_back(index);
+        return { index, slots[index].generation };
+    }
+
+    /// Removes the value referred to by [handle].
+    /// \returns false if the handle is no longer valid
+    bool erase(Handle const& handle)
+    {
+        if (!contains(handle))
+            return false;
+
+        auto& slot = slots[handle.index];
+        auto const removed = slot.dense_index;
+        auto const last = static_cast<uint32_t>(dense.size() - 1);
+        if (removed != last)
+        {
+            dense[removed] = std::move(dense[last]);
+            dense_to_slot[removed] = dense_to_slot[last];
+            slots[dense_to_slot[removed]].dense_index = removed;
+        }
+        dense.pop_back();
+        dense_to_slot.pop_back();
+
+        slot.generation++;
+        slot.dense_index = free_head;
+        free_head = handle.index;
+        return true;
+    }
+
+    [[nodiscard]] bool contains(Handle const& handle) const
+    {
+        return handle.index < slots.size() && slots[handle.index].generation == handle.generation;
+    }
+
+    T* get(Handle const& handle)
+    {
+        return contains(handle) ? &dense[slots[handle.index].dense_index] : nullptr;
+    }
+
+    T const* get(Handle const& handle) const
+    {
+        return contains(handle) ? &dense[slots[handle.index].dense_index] : nullptr;
+    }
+
+    [[nodiscard]] size_t size() const { return dense.size(); }
+    [[nodiscard]] bool empty() const { return dense.empty(); }
+
+    void reserve(size_t count)
+    {
+        slots.reserve(count);
+        dense.reserve(count);
+        dense_to_slot.reserve(count);
+    }
+
+    /// The stored values in no particular order.
+    auto begin() const { return dense.begin(); }
+    auto end() const { return dense.end(); }
+
+private:
+    struct Slot
+    {
+        /// The position of the value in [dense], or the next free slot if this slot is free.
+        uint32_t dense_index = Handle::invalid_index;
+        uint32_t generation = 0;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<T> dense;
+    std::vector<uint32_t> dense_to_slot;
+    uint32_t free_head = Handle::invalid_index;
+};
+
+} // miracle
+
+#endif // MIRACLE_WM_SLOT_MAP_H
@@ -0,0 +1,195 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLE_WM_SPATIAL_INDEX_H
+#define MIRACLE_WM_SPATIAL_INDEX_H
+
+#include <algorithm>
+#include <cstdint>
+#include <mir/geometry/rectangle.h>
+#include <unordered_map>
+#include <vector>
+
+namespace miracle
+{
+
+/// Finds the rectangle under a point without testing every rectangle.
+///
+/// Space is divided into square cells, and each cell lists the rectangles that
+/// overlap it. A lookup only tests the rectangles in the cell under the point,
+/// which for tiled windows that do not overlap is a handful regardless of how
+/// many there are.
+template <typename Key>
+class SpatialIndex
+{
+public:
+    explicit SpatialIndex(int cell_size = 256) :
+        cell_size { cell_size }
+    {
+    }
+
+    void clear()
+    {
+        entries.clear();
+        index_of.clear();
+        cells.clear();
+    }
+
+    /// Adds [key] covering [area], or moves it there if it is already present.
+    /// Where rectangles overlap, lookups prefer the key with the lowest [order].
+    void insert(Key const& key, mir::geometry::Rectangle const& area, uint32_t order)
+    {
+        auto const it = index_of.find(key);
+        if (it != index_of.end())
+        {
+            entries[it->second].order = order;
+            update(key, area);
+            return;
+        }
+
+        auto const index = static_cast<uint32_t>(entries.size());
+        entries.push_back({ key, area, order });
+        index_of.emplace(key, index);
+        add_to_cells(index);
+    }
+
+    /// Moves [key] to cover [area].
+    /// \returns false if [key] is not in the index
+    bool update(Key const& key, mir::geometry::Rectangle const& area)
+    {
+        auto const it = index_of.find(key);
+        if (it == index_of.end())
+            return false;
+
+        auto& entry = entries[it->second];
+        if (entry.area == area)
+            return true;
+
+        remove_from_cells(it->second);
+        entry.area = area;
+        add_to_cells(it->second);
+        return true;
+    }
+
+    /// \returns the key with the lowest order whose area contains [point], other
+    /// than [ignored], or nullptr if there is none
+    Key const* at(mir::geometry::Point const& point, Key const* ignored = nullptr) const
+    {
+        auto const x = point.x.as_int();
+        auto const y = point.y.as_int();
+        auto const cell = cells.find(cell_key(cell_of(x), cell_of(y)));
+        if (cell == cells.end())
+            return nullptr;
+
+        Entry const* best = nullptr;
+        for (auto const index : cell->second)
+        {
+            auto const& entry = entries[index];
+            if (ignored && entry.key == *ignored)
+                continue;
+
+            if (!contains(entry.area, x, y))
+                continue;
+
+            if (!best || entry.order < best->order)
+                best = &entry;
+        }
+
+        return best ? &best->key : nullptr;
+    }
+
+    [[nodiscard]] size_t size() const { return entries.size(); }
+    [[nodiscard]] bool empty() const { return entries.empty(); }
+
+private:
+    struct Entry
+    {
+        Key key;
+        mir::geometry::Rectangle area;
+        uint32_t order;
+    };
+
+    int cell_size;
+    std::vector<Entry> entries;
+    std::unordered_map<Key, uint32_t> index_of;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> cells;
+
+    static bool contains(mir::geometry::Rectangle const& area, int x, int y)
+    {
+        auto const left = area.top_left.x.as_int();
+        auto const top = area.top_left.y.as_int();
+        return x >= left && y >= top
+            && x < left + area.size.width.as_int()
+            && y < top + area.size.height.as_int();
+    }
+
+    int cell_of(int coordinate) const
+    {
+        // Rounds towards negative infinity, as outputs can be placed at negative coordinates
+        auto const cell = coordinate / cell_size;
+        return coordinate % cell_size < 0 ? cell - 1 : cell;
+    }
+
+    static uint64_t cell_key(int column, int row)
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(column)) << 32) | static_cast<uint32_t>(row);
+    }
+
+    template <typename F>
+    void for_each_cell(mir::geometry::Rectangle const& area, F const& f)
+    {
+        auto const width = area.size.width.as_int();
+        auto const height = area.size.height.as_int();
+        if (width <= 0 || height <= 0)
+            return;
+
+        auto const left = area.top_left.x.as_int();
+        auto const top = area.top_left.y.as_int();
+        for (int row = cell_of(top); row <= cell_of(top + height - 1); row++)
+        {
+            for (int column = cell_of(left); column <= cell_of(left + width - 1); column++)
+                f(cell_key(column, row));
+        }
+    }
+
+    void add_to_cells(uint32_t index)
+    {
+        for_each_cell(entries[index].area, [&](uint64_t key)
+        {
+            cells[key].push_back(index);
+        });
+    }
+
+    void remove_from_cells(uint32_t index)
+    {
+        for_each_cell(entries[index].area, [&](uint64_t key)
+        {
+            auto const cell = cells.find(key);
+            if (cell == cells.end())
+                return;
+
+            auto& indices = cell->second;
+            indices.erase(std::remove(indices.begin(), indices.end(), index), indices.end());
+            if (indices.empty())
+                cells.erase(cell);
+        });
+    }
+};
+
+} // miracle
+
+#endif // MIRACLE_WM_SPATIAL_INDEX_H
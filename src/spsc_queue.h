@@ -0,0 +1,135 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLE_WM_SPSC_QUEUE_H
+#define MIRACLE_WM_SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <utility>
+
+namespace miracle
+{
+
+/// An unbounded, lock-free queue for one producer thread and one consumer
+/// thread. Nodes that the consumer is done with are reused by the producer,
+/// so pushing only allocates while the queue is longer than it has been
+/// before.
+///
+/// Only one thread may push at a time, and only one thread may pop at a time.
+/// Callers with several producers must serialize them among themselves; the
+/// consumer is never blocked by that.
+template <typename T>
+class SpscQueue
+{
+public:
+    SpscQueue()
+    {
+        auto* const sentinel = new Node;
+        tail.store(sentinel, std::memory_order_relaxed);
+        head = sentinel;
+        first = sentinel;
+        tail_copy = sentinel;
+    }
+
+    ~SpscQueue()
+    {
+        auto* node = first;
+        while (node)
+        {
+            auto* const next = node->next.load(std::memory_order_relaxed);
+            delete node;
+            node = next;
+        }
+    }
+
+    SpscQueue(SpscQueue const&) = delete;
+    SpscQueue& operator=(SpscQueue const&) = delete;
+
+    /// Called by the producer.
+    void push(T value)
+    {
+        auto* const node = allocate();
+        node->value.emplace(std::move(value));
+        node->next.store(nullptr, std::memory_order_relaxed);
+        head->next.store(node, std::memory_order_release);
+        head = node;
+    }
+
+    /// Called by the consumer.
+    /// \returns the oldest value, or std::nullopt if the queue is empty
+    std::optional<T> pop()
+    {
+        auto* const current = tail.load(std::memory_order_relaxed);
+        auto* const next = current->next.load(std::memory_order_acquire);
+        if (!next)
+            return std::nullopt;
+
+        std::optional<T> result = std::move(next->value);
+        next->value.reset();
+
+        // [next] becomes the sentinel. Everything before it may now be reused.
+        tail.store(next, std::memory_order_release);
+        return result;
+    }
+
+    /// Called by the consumer.
+    [[nodiscard]] bool empty() const
+    {
+        return tail.load(std::memory_order_relaxed)->next.load(std::memory_order_acquire) == nullptr;
+    }
+
+private:
+    struct Node
+    {
+        std::atomic<Node*> next = nullptr;
+        std::optional<T> value;
+    };
+
+    /// Called by the producer. Reuses a node that the consumer has moved past
+    /// when there is one.
+    Node* allocate()
+    {
+        if (first == tail_copy)
+            tail_copy = tail.load(std::memory_order_acquire);
+
+        if (first != tail_copy)
+        {
+            auto* const node = first;
+            first = first->next.load(std::memory_order_relaxed);
+            return node;
+        }
+
+        return new Node;
+    }
+
+    static constexpr size_t cache_line = 64;
+
+    /// The consumer's sentinel. Its successor is the oldest value.
+    alignas(cache_line) std::atomic<Node*> tail;
+
+    /// Owned by the producer: the newest node, the oldest reusable node, and
+    /// the last value of [tail] that the producer has seen.
+    alignas(cache_line) Node* head;
+    Node* first;
+    Node* tail_copy;
+};
+
+} // miracle
+
+#endif // MIRACLE_WM_SPSC_QUEUE_H
@@ -81,3 +81,25 @@ mgl::Primitive mgl::tessellate_renderable_into_rectangle(
     };
     return rectangle;
 }
+
+void mgl::outset_rectangle(Primitive& rectangle, int amount)
+{
+    auto& vertices = rectangle.vertices;
+    GLfloat const width = vertices[2].position[0] - vertices[0].position[0];
+    GLfloat const height = vertices[1].position[1] - vertices[0].position[1];
+    if (width == 0 || height == 0)
+        return;
+
+    GLfloat const du = amount * (vertices[2].texcoord[0] - vertices[0].texcoord[0]) / width;
+    GLfloat const dv = amount * (vertices[1].texcoord[1] - vertices[0].texcoord[1]) / height;
+    for (int i = 0; i < rectangle.nvertices; i++)
+    {
+        // Vertices 0 and 1 are on the left edge, while 0 and 2 are on the top edge
+        GLfloat const x_sign = i < 2 ? -1.f : 1.f;
+        GLfloat const y_sign = i % 2 == 0 ? -1.f : 1.f;
+        vertices[i].position[0] += x_sign * amount;
+        vertices[i].position[1] += y_sign * amount;
+        vertices[i].texcoord[0] += x_sign * du;
+        vertices[i].texcoord[1] += y_sign * dv;
+    }
+}
@@ -32,6 +32,11 @@ namespace gl
     Primitive tessellate_renderable_into_rectangle(
         graphics::Renderable const& renderable, geometry::Displacement const& offset);
 
+    /// Grows a rectangle produced by [tessellate_renderable_into_rectangle] by [amount]
+    /// on every side. Texture coordinates are extrapolated, so the new area samples
+    /// outside of the [0, 1] range.
+    void outset_rectangle(Primitive& rectangle, int amount);
+
 }
 }
 #endif /* MIR_GL_TESSELLATION_HELPERS_H_ */
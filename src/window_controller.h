@@ -58,6 +58,37 @@ public:
     virtual void set_size_hack(AnimationHandle handle, geom::Size const& size) = 0;
     virtual miral::Window window_at(float x, float y) = 0;
     virtual void process_animation(AnimationStepResult const&, std::shared_ptr<Container> const&) = 0;
+
+    /// Starts a transaction. Until the matching [commit], changes to the state,
+    /// depth layer and rectangle of windows are recorded instead of applied,
+    /// while [get_state] and [is_fullscreen] report the recorded state.
+    /// Transactions nest, and only the outermost [commit] applies the changes.
+    virtual void begin() = 0;
+
+    /// Applies everything recorded since the outermost [begin] in one batch.
+    virtual void commit() = 0;
+};
+
+/// Holds a [WindowController] transaction open for as long as it lives.
+class LayoutTransaction
+{
+public:
+    explicit LayoutTransaction(WindowController& window_controller) :
+        window_controller { window_controller }
+    {
+        window_controller.begin();
+    }
+
+    ~LayoutTransaction()
+    {
+        window_controller.commit();
+    }
+
+    LayoutTransaction(LayoutTransaction const&) = delete;
+    LayoutTransaction& operator=(LayoutTransaction const&) = delete;
+
+private:
+    WindowController& window_controller;
 };
 
 }
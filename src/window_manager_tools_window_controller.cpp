@@ -24,26 +24,82 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "leaf_container.h"
 #include "policy.h"
 #include "window_helpers.h"
+#include <algorithm>
 #include <mir/log.h>
+#include <mir/scene/null_surface_observer.h>
 #include <mir/scene/surface.h>
 #include <mir/server_action_queue.h>
+#include <mir/time/alarm.h>
+#include <mir/time/alarm_factory.h>
 
 using namespace miracle;
 
+namespace
+{
+/// Tells the policy when a client that a layout transaction is waiting on has
+/// drawn at a new size.
+class ClientSizeObserver : public mir::scene::NullSurfaceObserver
+{
+public:
+    ClientSizeObserver(
+        uint64_t serial,
+        AnimationHandle handle,
+        std::shared_ptr<mir::ServerActionQueue> const& server_action_queue,
+        Policy* policy) :
+        serial { serial },
+        handle { handle },
+        server_action_queue { server_action_queue },
+        policy { policy }
+    {
+    }
+
+    void content_resized_to(mir::scene::Surface const*, mir::geometry::Size const& size) override
+    {
+        // This is called on the thread of the client, so the policy is told on the main loop
+        server_action_queue->enqueue(policy, [policy = policy, serial = serial, handle = handle, size]()
+        {
+            policy->handle_client_size(serial, handle, size);
+        });
+    }
+
+private:
+    uint64_t serial;
+    AnimationHandle handle;
+    std::shared_ptr<mir::ServerActionQueue> server_action_queue;
+    Policy* policy;
+};
+}
+
 WindowManagerToolsWindowController::WindowManagerToolsWindowController(
     miral::WindowManagerTools const& tools,
     std::shared_ptr<Animator> const& animator,
     std::shared_ptr<CompositorState> const& state,
     std::shared_ptr<Config> const& config,
     std::shared_ptr<mir::ServerActionQueue> const& server_action_queue,
+    std::shared_ptr<mir::time::AlarmFactory> const& alarm_factory,
     Policy* policy) :
     tools { tools },
     animator { animator },
     state { state },
     config { config },
     server_action_queue { server_action_queue },
-    policy { policy }
+    policy { policy },
+    stats_start { std::chrono::steady_clock::now() },
+    alarm_factory { alarm_factory }
+{
+}
+
+WindowManagerToolsWindowController::~WindowManagerToolsWindowController()
 {
+    for (auto const& transaction : in_flight)
+    {
+        transaction.timeout->cancel();
+        for (auto const& [surface, observer] : transaction.observers)
+        {
+            if (auto const locked = surface.lock())
+                locked->unregister_interest(*observer);
+        }
+    }
 }
 
 void WindowManagerToolsWindowController::open(miral::Window const& window)
@@ -83,12 +139,25 @@ void WindowManagerToolsWindowController::open(miral::Window const& window)
 
 bool WindowManagerToolsWindowController::is_fullscreen(miral::Window const& window)
 {
-    auto& info = tools.info_for(window);
-    return window_helpers::is_window_fullscreen(info.state());
+    return window_helpers::is_window_fullscreen(get_state(window));
 }
 
 void WindowManagerToolsWindowController::set_rectangle(
     miral::Window const& window, geom::Rectangle const& from, geom::Rectangle const& to, bool with_animations)
+{
+    if (pending_changes.is_recording())
+    {
+        pending_changes.set_rectangle(window, from, to, with_animations);
+        return;
+    }
+
+    apply_rectangles({ { window, { from, to, with_animations } } });
+}
+
+void WindowManagerToolsWindowController::apply_rectangle(
+    miral::Window const& window,
+    PendingRectangle const& rectangle,
+    std::vector<ContainerAnimationResult>& immediate)
 {
     auto container = get_container(window);
     if (!container)
@@ -97,30 +166,30 @@ void WindowManagerToolsWindowController::set_rectangle(
         return;
     }
 
+    auto const& to = rectangle.to;
     auto const& info = info_for(window);
     if (info.parent())
     {
-        policy->handle_animation({ container->animation_handle(), true, to }, container);
+        immediate.push_back({ { container->animation_handle(), true, to }, container });
         return;
     }
 
-    if (!config->are_animations_enabled() || !with_animations)
+    if (!config->are_animations_enabled() || !rectangle.with_animations)
     {
-        policy->handle_animation(
-            AnimationStepResult { container->animation_handle(),
-                true,
-                to,
-                glm::vec2(to.top_left.x.as_int(), to.top_left.y.as_int()),
-                glm::vec2(to.size.width.as_int(), to.size.height.as_int()),
-                glm::mat4(1.f) },
-            container);
+        immediate.push_back({ AnimationStepResult { container->animation_handle(),
+                                  true,
+                                  to,
+                                  glm::vec2(to.top_left.x.as_int(), to.top_left.y.as_int()),
+                                  glm::vec2(to.size.width.as_int(), to.size.height.as_int()),
+                                  glm::mat4(1.f) },
+            container });
         return;
     }
 
     auto animation = std::make_shared<WindowAnimation>(
         container->animation_handle(),
         config->get_animation_definitions()[(int)AnimateableEvent::window_move],
-        from,
+        rectangle.from,
         to,
         geom::Rectangle { window.top_left(), window.size() },
         this,
@@ -131,11 +200,25 @@ void WindowManagerToolsWindowController::set_rectangle(
 
 MirWindowState WindowManagerToolsWindowController::get_state(miral::Window const& window)
 {
+    if (auto const change = pending_changes.find(window); change && change->state)
+        return change->state.value();
+
     auto& window_info = tools.info_for(window);
     return window_info.state();
 }
 
 void WindowManagerToolsWindowController::change_state(miral::Window const& window, MirWindowState state)
+{
+    if (pending_changes.is_recording())
+    {
+        pending_changes.set_state(window, state);
+        return;
+    }
+
+    apply_state(window, state);
+}
+
+void WindowManagerToolsWindowController::apply_state(miral::Window const& window, MirWindowState state)
 {
     auto& window_info = tools.info_for(window);
     miral::WindowSpecification spec;
@@ -144,6 +227,236 @@ void WindowManagerToolsWindowController::change_state(miral::Window const& windo
     tools.modify_window(window, spec);
 }
 
+void WindowManagerToolsWindowController::begin()
+{
+    pending_changes.begin();
+}
+
+void WindowManagerToolsWindowController::commit()
+{
+    // Applying a change may call back into us, so the changes are taken first
+    auto const changes = pending_changes.commit();
+    if (!changes)
+        return;
+
+    std::vector<std::pair<miral::Window, PendingRectangle>> rectangles;
+    for (auto const& change : changes.value())
+    {
+        if (change.state)
+            apply_state(change.window, change.state.value());
+
+        for (auto const& spec : change.modifications)
+            tools.modify_window(change.window, spec);
+
+        if (change.rectangle)
+            rectangles.emplace_back(change.window, change.rectangle.value());
+    }
+
+    apply_rectangles(std::move(rectangles));
+}
+
+void WindowManagerToolsWindowController::apply_rectangles(
+    std::vector<std::pair<miral::Window, PendingRectangle>> rectangles)
+{
+    supersede_transactions_of(rectangles);
+
+    std::chrono::milliseconds const timeout { config->rendering().transaction_timeout_ms };
+    InFlightTransaction transaction { next_transaction_serial++ };
+    if (timeout.count() > 0)
+    {
+        for (auto& [window, rectangle] : rectangles)
+        {
+            auto const current_size = window.size();
+            if (rectangle.to.size == current_size)
+                continue;
+
+            auto const container = get_container(window);
+            auto const& info = info_for(window);
+            if (!container || info.parent() || info.state() == mir_window_state_hidden)
+                continue;
+
+            auto const surface = window.operator std::shared_ptr<mir::scene::Surface>();
+            if (!surface)
+                continue;
+
+            // The client is asked to draw at its new size straight away, while the
+            // window stays where it was and within its old bounds until every
+            // client has caught up. The size is then already right, so only the
+            // position animates.
+            auto const observer = std::make_shared<ClientSizeObserver>(
+                transaction.serial, container->animation_handle(), server_action_queue, policy);
+            surface->register_interest(observer);
+            transaction.observers.emplace_back(surface, observer);
+
+            miral::WindowSpecification spec;
+            spec.size() = rectangle.to.size;
+            tools.modify_window(window, spec);
+            clip(window, { window.top_left(), current_size });
+
+            rectangle.from.size = rectangle.to.size;
+            transaction.awaiting.emplace_back(container->animation_handle(), rectangle.to.size);
+        }
+    }
+
+    if (transaction.awaiting.empty())
+    {
+        show_rectangles(rectangles);
+        return;
+    }
+
+    transaction.rectangles = std::move(rectangles);
+    transaction.started = std::chrono::steady_clock::now();
+    transaction.timeout = alarm_factory->create_alarm([policy = policy, serial = transaction.serial]()
+    {
+        policy->handle_transaction_timeout(serial);
+    });
+    transaction.timeout->reschedule_in(timeout);
+    in_flight.push_back(std::move(transaction));
+}
+
+void WindowManagerToolsWindowController::show_rectangles(
+    std::vector<std::pair<miral::Window, PendingRectangle>> const& rectangles)
+{
+    std::vector<ContainerAnimationResult> immediate;
+    for (auto const& [window, rectangle] : rectangles)
+        apply_rectangle(window, rectangle, immediate);
+
+    if (!immediate.empty())
+        policy->handle_animations(immediate);
+}
+
+void WindowManagerToolsWindowController::supersede_transactions_of(
+    std::vector<std::pair<miral::Window, PendingRectangle>> const& rectangles)
+{
+    auto const moves_any = [&](InFlightTransaction const& transaction)
+    {
+        return std::ranges::any_of(transaction.rectangles, [&](auto const& waiting)
+        {
+            return std::ranges::any_of(rectangles, [&](auto const& next)
+            {
+                return next.first == waiting.first;
+            });
+        });
+    };
+
+    // Showing a transaction may call back into us, so they are all taken first
+    std::vector<InFlightTransaction> superseded;
+    for (auto it = in_flight.begin(); it != in_flight.end();)
+    {
+        if (moves_any(*it))
+        {
+            superseded.push_back(std::move(*it));
+            it = in_flight.erase(it);
+        }
+        else
+            it++;
+    }
+
+    // Relayouts of the same windows are shown in the order that they were made
+    for (auto& transaction : superseded)
+        finish_transaction(std::move(transaction), TransactionEnd::superseded);
+}
+
+std::optional<WindowManagerToolsWindowController::InFlightTransaction>
+WindowManagerToolsWindowController::take_transaction(uint64_t serial)
+{
+    auto const it = std::ranges::find(in_flight, serial, &InFlightTransaction::serial);
+    if (it == in_flight.end())
+        return std::nullopt;
+
+    auto transaction = std::move(*it);
+    in_flight.erase(it);
+    return transaction;
+}
+
+void WindowManagerToolsWindowController::finish_transaction(InFlightTransaction transaction, TransactionEnd end)
+{
+    transaction.timeout->cancel();
+    for (auto const& [surface, observer] : transaction.observers)
+    {
+        if (auto const locked = surface.lock())
+            locked->unregister_interest(*observer);
+    }
+
+    auto& timings = state->layout_transactions;
+    timings.latency.record(std::chrono::steady_clock::now() - transaction.started);
+    switch (end)
+    {
+    case TransactionEnd::ready:
+        break;
+    case TransactionEnd::timed_out:
+        timings.timed_out.fetch_add(1, std::memory_order_relaxed);
+        mir::log_debug(
+            "Layout transaction timed out waiting for %zu clients", transaction.awaiting.size());
+        break;
+    case TransactionEnd::superseded:
+        timings.superseded.fetch_add(1, std::memory_order_relaxed);
+        break;
+    }
+
+    show_rectangles(transaction.rectangles);
+}
+
+void WindowManagerToolsWindowController::expire_transaction(uint64_t serial)
+{
+    // The alarm may have fired just as its transaction was shown
+    if (auto transaction = take_transaction(serial))
+        finish_transaction(std::move(transaction.value()), TransactionEnd::timed_out);
+}
+
+void WindowManagerToolsWindowController::advise_client_size(
+    uint64_t serial, AnimationHandle handle, mir::geometry::Size const& size)
+{
+    auto const it = std::ranges::find(in_flight, serial, &InFlightTransaction::serial);
+    if (it == in_flight.end())
+        return;
+
+    auto& awaiting = it->awaiting;
+    awaiting.erase(
+        std::remove(awaiting.begin(), awaiting.end(), std::make_pair(handle, size)),
+        awaiting.end());
+    if (awaiting.empty())
+        finish_transaction(take_transaction(serial).value(), TransactionEnd::ready);
+}
+
+void WindowManagerToolsWindowController::forget(miral::Window const& window)
+{
+    pending_changes.forget(window);
+
+    auto const container = get_container(window);
+    std::vector<uint64_t> ready;
+    for (auto& transaction : in_flight)
+    {
+        auto& rectangles = transaction.rectangles;
+        rectangles.erase(
+            std::remove_if(rectangles.begin(), rectangles.end(), [&](auto const& rectangle)
+        {
+            return rectangle.first == window;
+        }),
+            rectangles.end());
+
+        if (container)
+        {
+            auto& awaiting = transaction.awaiting;
+            awaiting.erase(
+                std::remove_if(awaiting.begin(), awaiting.end(), [&](auto const& size)
+            {
+                return size.first == container->animation_handle();
+            }),
+                awaiting.end());
+        }
+
+        if (transaction.awaiting.empty())
+            ready.push_back(transaction.serial);
+    }
+
+    for (auto const serial : ready)
+    {
+        if (auto transaction = take_transaction(serial))
+            finish_transaction(std::move(transaction.value()), TransactionEnd::ready);
+    }
+}
+
 void WindowManagerToolsWindowController::clip(miral::Window const& window, geom::Rectangle const& r)
 {
     auto& window_info = tools.info_for(window);
@@ -203,14 +516,59 @@ WindowManagerToolsWindowController::WindowAnimation::WindowAnimation(
 {
 }
 
+void WindowManagerToolsWindowController::WindowAnimation::on_init(AnimationStepResult const& asr)
+{
+    controller->policy->handle_animation(asr, container);
+}
+
 void WindowManagerToolsWindowController::WindowAnimation::on_tick(AnimationStepResult const& asr)
 {
-    controller->server_action_queue->enqueue(controller, [controller = controller, asr = asr, container = container]()
+    controller->queue_animation_result(asr, container);
+}
+
+void WindowManagerToolsWindowController::queue_animation_result(
+    AnimationStepResult const& asr,
+    std::weak_ptr<Container> const& container)
+{
+    pending_results.push({ asr, container });
+
+    // Only the first result since the last job started needs a new job
+    if (job_queued.exchange(true))
+        return;
+
+    server_action_queue->enqueue(this, [this]()
     {
-        controller->policy->handle_animation(asr, container);
+        apply_pending_results();
     });
 }
 
+void WindowManagerToolsWindowController::apply_pending_results()
+{
+    // Cleared before draining so that a result pushed after the drain is
+    // sure to queue another job
+    job_queued = false;
+    while (auto result = pending_results.pop())
+        applying_results.push_back(std::move(result.value()));
+
+    if (applying_results.empty())
+        return;
+
+    policy->handle_animations(applying_results);
+
+    auto const now = std::chrono::steady_clock::now();
+    stats_results += applying_results.size();
+    stats_jobs++;
+    if (now - stats_start >= std::chrono::seconds(1))
+    {
+        mir::log_debug("Applied %zu animation results in %zu jobs", stats_results, stats_jobs);
+        stats_start = now;
+        stats_results = 0;
+        stats_jobs = 0;
+    }
+
+    applying_results.clear();
+}
+
 void WindowManagerToolsWindowController::process_animation(
     AnimationStepResult const& result,
     std::shared_ptr<Container> const& container)
@@ -270,6 +628,13 @@ void WindowManagerToolsWindowController::set_user_data(
 void WindowManagerToolsWindowController::modify(
     miral::Window const& window, miral::WindowSpecification const& spec)
 {
+    // User data is looked up as soon as it is set, so it is never deferred
+    if (pending_changes.is_recording() && !spec.userdata())
+    {
+        pending_changes.modify(window, spec);
+        return;
+    }
+
     tools.modify_window(window, spec);
 }
 
@@ -301,6 +666,13 @@ void WindowManagerToolsWindowController::move_cursor_to(float x, float y)
 void WindowManagerToolsWindowController::set_size_hack(AnimationHandle handle, mir::geometry::Size const& size)
 {
     animator->set_size_hack(handle, size);
+
+    // The size is not tied to any one transaction, so each one that waits on it hears
+    std::vector<uint64_t> serials;
+    for (auto const& transaction : in_flight)
+        serials.push_back(transaction.serial);
+    for (auto const serial : serials)
+        advise_client_size(serial, handle, size);
 }
 
 miral::Window WindowManagerToolsWindowController::window_at(float x, float y)
@@ -19,12 +19,28 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define MIRACLEWM_WINDOW_MANAGER_TOOLS_TILING_INTERFACE_H
 
 #include "animator.h"
+#include "pending_window_changes.h"
+#include "spsc_queue.h"
 #include "window_controller.h"
+#include <atomic>
+#include <chrono>
 #include <miral/window_manager_tools.h>
+#include <optional>
+#include <vector>
 
 namespace mir
 {
 class ServerActionQueue;
+namespace scene
+{
+    class Surface;
+    class SurfaceObserver;
+}
+namespace time
+{
+    class Alarm;
+    class AlarmFactory;
+}
 }
 namespace miracle
 {
@@ -32,6 +48,13 @@ class CompositorState;
 class Config;
 class Policy;
 
+/// An animation result waiting to be applied to its container.
+struct ContainerAnimationResult
+{
+    AnimationStepResult result;
+    std::weak_ptr<Container> container;
+};
+
 class WindowManagerToolsWindowController : public WindowController
 {
 public:
@@ -41,7 +64,9 @@ public:
         std::shared_ptr<CompositorState> const& state,
         std::shared_ptr<Config> const& config,
         std::shared_ptr<mir::ServerActionQueue> const& server_action_queue,
+        std::shared_ptr<mir::time::AlarmFactory> const& alarm_factory,
         Policy* policy);
+    ~WindowManagerToolsWindowController() override;
     void open(miral::Window const&) override;
     bool is_fullscreen(miral::Window const&) override;
     void set_rectangle(miral::Window const&, geom::Rectangle const&, geom::Rectangle const&, bool with_animations = true) override;
@@ -63,6 +88,21 @@ public:
     void set_size_hack(AnimationHandle handle, mir::geometry::Size const& size) override;
     miral::Window window_at(float x, float y) override;
     void process_animation(AnimationStepResult const&, std::shared_ptr<Container> const&) override;
+    void begin() override;
+    void commit() override;
+
+    /// Shows the layout transaction [serial] without waiting any longer on its
+    /// clients, if it is still waiting.
+    void expire_transaction(uint64_t serial);
+
+    /// Records that the client of the window animated by [handle] has drawn at
+    /// [size] for layout transaction [serial]. Sizes reported for transactions
+    /// that have already been shown are ignored.
+    void advise_client_size(uint64_t serial, AnimationHandle handle, mir::geometry::Size const& size);
+
+    /// Drops the changes that are waiting to be applied to [window], which is
+    /// going away.
+    void forget(miral::Window const& window);
 
 private:
     miral::WindowManagerTools tools;
@@ -72,6 +112,77 @@ private:
     std::shared_ptr<mir::ServerActionQueue> server_action_queue;
     Policy* policy;
 
+    /// Results are gathered here from the animator thread, which is the only
+    /// producer. A single job on the server action queue applies everything
+    /// that gathered before it ran. [job_queued] is set by whichever result
+    /// finds no job waiting.
+    SpscQueue<ContainerAnimationResult> pending_results;
+    std::atomic<bool> job_queued = false;
+    std::vector<ContainerAnimationResult> applying_results;
+
+    /// Counts the results and queued jobs since [stats_start], so that the
+    /// saving can be reported.
+    std::chrono::steady_clock::time_point stats_start;
+    size_t stats_results = 0;
+    size_t stats_jobs = 0;
+
+    void queue_animation_result(AnimationStepResult const&, std::weak_ptr<Container> const&);
+    void apply_pending_results();
+
+    using PendingRectangle = PendingWindowChanges::Rectangle;
+    PendingWindowChanges pending_changes;
+
+    /// How a layout transaction that waited on its clients came to be shown.
+    enum class TransactionEnd
+    {
+        ready,
+        timed_out,
+        superseded
+    };
+
+    /// A relayout that has asked its resized clients to draw at their new
+    /// size, and is shown once they all have.
+    struct InFlightTransaction
+    {
+        /// Identifies the transaction to its observers and timeout alarm.
+        uint64_t serial;
+        std::vector<std::pair<miral::Window, PendingRectangle>> rectangles;
+
+        /// The size that each resized window is waiting to be drawn at.
+        std::vector<std::pair<AnimationHandle, mir::geometry::Size>> awaiting;
+        std::vector<std::pair<std::weak_ptr<mir::scene::Surface>, std::shared_ptr<mir::scene::SurfaceObserver>>> observers;
+        std::chrono::steady_clock::time_point started;
+        std::unique_ptr<mir::time::Alarm> timeout;
+    };
+
+    std::shared_ptr<mir::time::AlarmFactory> alarm_factory;
+    uint64_t next_transaction_serial = 1;
+
+    /// Relayouts of disjoint sets of windows wait on their clients independently.
+    std::vector<InFlightTransaction> in_flight;
+
+    /// Applies [rectangles], first waiting for the clients that they resize
+    /// when transactions are enabled.
+    void apply_rectangles(std::vector<std::pair<miral::Window, PendingRectangle>> rectangles);
+    void show_rectangles(std::vector<std::pair<miral::Window, PendingRectangle>> const& rectangles);
+
+    /// Shows straight away every transaction that is waiting to move any of the
+    /// windows in [rectangles], so that it cannot overwrite them later.
+    void supersede_transactions_of(std::vector<std::pair<miral::Window, PendingRectangle>> const& rectangles);
+
+    /// Removes transaction [serial] from [in_flight], if it is still there.
+    std::optional<InFlightTransaction> take_transaction(uint64_t serial);
+    void finish_transaction(InFlightTransaction transaction, TransactionEnd end);
+
+    void apply_state(miral::Window const&, MirWindowState);
+
+    /// Starts an animation to [to], or adds the final result to [immediate]
+    /// when the window should not animate.
+    void apply_rectangle(
+        miral::Window const&,
+        PendingRectangle const&,
+        std::vector<ContainerAnimationResult>& immediate);
+
     class WindowAnimation : public Animation
     {
     public:
@@ -83,6 +194,10 @@ private:
             mir::geometry::Rectangle const& current,
             WindowManagerToolsWindowController* controller,
             std::shared_ptr<Container> const& container);
+
+        /// The initial state is applied straight away, as the animation is
+        /// appended with the policy locked.
+        void on_init(AnimationStepResult const&) override;
         void on_tick(AnimationStepResult const&) override;
 
     private:
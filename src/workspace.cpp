@@ -31,6 +31,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <mir/log.h>
 #include <mir/scene/surface.h>
 #include <miral/zone.h>
+#include <set>
 
 using namespace miracle;
 
@@ -74,25 +75,6 @@ LayoutScheme from_direction(Direction direction)
     }
 }
 
-std::shared_ptr<Container> foreach_node_internal(
-    std::function<bool(std::shared_ptr<Container> const&)> const& f,
-    std::shared_ptr<Container> const& parent)
-{
-    if (f(parent))
-        return parent;
-
-    if (parent->is_leaf())
-        return nullptr;
-
-    for (auto& node : Container::as_parent(parent)->get_sub_nodes())
-    {
-        if (auto result = foreach_node_internal(f, node))
-            return result;
-    }
-
-    return nullptr;
-}
-
 geom::Rectangle get_output_area(OutputInterface const* output)
 {
     auto const& zones = output->get_app_zones();
@@ -121,8 +103,18 @@ Workspace::Workspace(
     root(std::make_shared<ParentContainer>(
         state, window_controller, config, get_output_area(output), this, nullptr, true))
 {
+    laid_out_spacing = current_spacing();
     config_handle = config->register_listener([this](auto const&)
     {
+        // Every container depends on the gaps and the border size, but nothing else
+        // in the configuration changes the layout of containers that are in place
+        auto const spacing = current_spacing();
+        if (spacing != laid_out_spacing)
+        {
+            laid_out_spacing = spacing;
+            root->invalidate_layout();
+        }
+
         recalculate_area();
     });
 }
@@ -134,14 +126,37 @@ Workspace::~Workspace()
 
 void Workspace::set_area(mir::geometry::Rectangle const& area)
 {
-    root->set_logical_area(area);
-    root->commit_changes();
+    layout(area);
 }
 
 void Workspace::recalculate_area()
 {
-    root->set_logical_area(get_output_area(output));
+    layout(get_output_area(output));
+}
+
+void Workspace::layout(mir::geometry::Rectangle const& area)
+{
+    auto const before = state->layout_counters;
+    root->set_logical_area(area);
     root->commit_changes();
+
+    auto const& after = state->layout_counters;
+    mir::log_debug(
+        "Layout of workspace %s recomputed %zu containers and skipped %zu subtrees",
+        display_name().c_str(),
+        after.recomputed - before.recomputed,
+        after.skipped - before.skipped);
+}
+
+Workspace::Spacing Workspace::current_spacing() const
+{
+    return {
+        .inner_gaps_x = config->get_inner_gaps_x(),
+        .inner_gaps_y = config->get_inner_gaps_y(),
+        .outer_gaps_x = config->get_outer_gaps_x(),
+        .outer_gaps_y = config->get_outer_gaps_y(),
+        .border_size = config->get_border_config().size
+    };
 }
 
 AllocationHint Workspace::allocate_position(
@@ -212,6 +227,7 @@ void Workspace::delete_container(std::shared_ptr<Container> const& container)
             floating_trees.erase(
                 std::remove(floating_trees.begin(), floating_trees.end(), parent),
                 floating_trees.end());
+            state->container_tree_version++;
         }
         break;
     }
@@ -242,34 +258,119 @@ void Workspace::hide()
 
 bool Workspace::for_each_window(std::function<bool(std::shared_ptr<Container>)> const& f) const
 {
-    auto _for_each_window = [&](std::shared_ptr<Container> const& node)
+    // [f] may close or move windows. When it changes the shape of a tree, the walk
+    // moves on to a fresh copy and carries on with the windows it has not visited.
+    // Each window still costs the lock of its node, the shared pointer that the
+    // window controller returns and the one that [f] takes, just as the walk over
+    // the containers' own shared pointers did.
+    std::set<std::weak_ptr<Container>, std::owner_less<>> visited;
+    auto walked = get_tree();
+    auto version = state->container_tree_version;
+    size_t i = 0;
+    while (i < walked->size())
     {
-        if (auto leaf = Container::as_leaf(node))
+        auto const& node = (*walked)[i++];
+        if (node.type != ContainerType::leaf)
+            continue;
+
+        auto const leaf = node.container.lock();
+        if (!leaf || visited.contains(node.container))
+            continue;
+
+        auto const window = leaf->window();
+        if (!window)
+        {
+            mir::log_error("MiralWorkspace::for_each_window: tiled window has no window");
+            continue;
+        }
+
+        auto container = window_controller->get_container(window.value());
+        if (container && f(container))
+            return true;
+
+        if (state->container_tree_version != version)
         {
-            if (!leaf->window())
+            for (size_t j = 0; j < i; j++)
             {
-                mir::log_error("MiralWorkspace::for_each_window: tiled window has no window");
-                return false;
+                if ((*walked)[j].type == ContainerType::leaf)
+                    visited.insert((*walked)[j].container);
             }
 
-            auto container = window_controller->get_container(leaf->window().value());
-            if (container && f(container))
-                return true;
+            walked = get_tree();
+            version = state->container_tree_version;
+            i = 0;
         }
+    }
 
-        return false;
-    };
+    return false;
+}
 
-    for (auto const& other_root : floating_trees)
+std::shared_ptr<ContainerTree const> Workspace::get_tree() const
+{
+    if (!tree || tree_version != state->container_tree_version)
     {
-        if (foreach_node_internal(_for_each_window, other_root))
-            return true;
+        // Floating trees come first to match the order that windows have always been visited in
+        std::vector<std::shared_ptr<ParentContainer>> roots = floating_trees;
+        roots.push_back(root);
+        auto next = std::make_shared<ContainerTree>();
+        next->rebuild(roots);
+        tree = std::move(next);
+        tree_version = state->container_tree_version;
     }
 
-    if (foreach_node_internal(_for_each_window, root))
-        return true;
+    return tree;
+}
 
-    return false;
+std::shared_ptr<Container> Workspace::leaf_at(float x, float y, Container* ignored) const
+{
+    auto const hit = get_leaf_index().at(geom::Point(x, y), ignored ? &ignored : nullptr);
+    if (!hit)
+        return nullptr;
+
+    auto const it = leaf_index_containers.find(*hit);
+    if (it == leaf_index_containers.end())
+        return nullptr;
+
+    auto leaf = it->second.lock();
+    if (!leaf || !leaf->window())
+        return nullptr;
+
+    return leaf;
+}
+
+void Workspace::advise_area_changed(Container& container)
+{
+    // An index that is out of date is rebuilt in full the next time that it is used
+    if (leaf_index_version == state->container_tree_version)
+        leaf_index.update(&container, container.get_visible_area());
+}
+
+SpatialIndex<Container*> const& Workspace::get_leaf_index() const
+{
+    auto const nodes = get_tree();
+    if (leaf_index_version != state->container_tree_version)
+    {
+        leaf_index.clear();
+        leaf_index_containers.clear();
+        for (ContainerTree::NodeId id = 0; id < nodes->size(); id++)
+        {
+            auto const& node = (*nodes)[id];
+            if (node.type != ContainerType::leaf)
+                continue;
+
+            auto const leaf = node.container.lock();
+            if (!leaf)
+                continue;
+
+            // Windows are preferred in the order that for_each_window visits them
+            leaf_index.insert(leaf.get(), leaf->get_visible_area(), id);
+            leaf_index_containers.emplace(leaf.get(), leaf);
+        }
+
+        leaf_index_version = state->container_tree_version;
+    }
+
+    return leaf_index;
 }
 
 void Workspace::transfer_pinned_windows_to(std::shared_ptr<WorkspaceInterface> const& other)
@@ -280,6 +381,7 @@ void Workspace::transfer_pinned_windows_to(std::shared_ptr<WorkspaceInterface> c
         {
             other->graft(*it);
             it = floating_trees.erase(it);
+            state->container_tree_version++;
         }
         else
             it++;
@@ -291,6 +393,7 @@ std::shared_ptr<ParentContainer> Workspace::create_floating_tree(mir::geometry::
     auto floating = std::make_shared<ParentContainer>(
         state, window_controller, config, area, this, nullptr, false);
     floating_trees.push_back(floating);
+    state->container_tree_version++;
     return floating;
 }
 
@@ -372,6 +475,7 @@ Workspace::MoveResult Workspace::handle_move(Container& from, Direction directio
         after_root_lane->set_layout(new_layout_direction);
         after_root_lane->graft_existing(root, 0);
         root = after_root_lane;
+        state->container_tree_version++;
         recalculate_area();
     }
 
@@ -433,14 +537,12 @@ void Workspace::set_output(OutputInterface* new_output)
 
 void Workspace::workspace_transform_change_hack()
 {
-    // TODO: This is extra extra slow, especially for animation purposes.
-    //  We should have the [LeafContainer]s in a row and we should probably
-    //  set all container transforms at the same time to avoid taking
-    //  the lock over and over again.
+    // The renderer shares one transform between all of the windows of a workspace,
+    // which the output publishes. Only the compositor needs to hear about each window.
+    std::optional<glm::mat4> workspace_transform;
     for_each_window([&](std::shared_ptr<Container> const& container)
     {
         auto window = container->window();
-        state->render_data_manager()->workspace_transform_change(*container);
         if (window)
         {
             auto surface = window->operator std::shared_ptr<mir::scene::Surface>();
@@ -449,10 +551,9 @@ void Workspace::workspace_transform_change_hack()
                 // While we don't use this transform in rendering, we do need it
                 // so that the compositor understands which surfaces overlap
                 // and properly obscures them.
-                auto full_transform = container->get_output_transform()
-                    * container->get_workspace_transform()
-                    * container->get_transform();
-                surface->set_transformation(full_transform);
+                if (!workspace_transform)
+                    workspace_transform = container->get_output_transform() * container->get_workspace_transform();
+                surface->set_transformation(workspace_transform.value() * container->get_transform());
             }
         }
         return false;
@@ -481,6 +582,7 @@ void Workspace::graft(std::shared_ptr<Container> const& container)
         parent->set_anchored(false);
         parent->set_workspace(this);
         floating_trees.push_back(parent);
+        state->container_tree_version++;
         break;
     }
     case ContainerType::leaf:
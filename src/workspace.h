@@ -18,10 +18,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef MIRACLEWM_WORKSPACE_CONTENT_H
 #define MIRACLEWM_WORKSPACE_CONTENT_H
 
+#include "container_tree.h"
+#include "spatial_index.h"
 #include "workspace_interface.h"
 
+#include <array>
 #include <glm/glm.hpp>
 #include <memory>
+#include <optional>
+#include <unordered_map>
 #include <miral/window_manager_tools.h>
 
 namespace miracle
@@ -60,6 +65,8 @@ public:
     void hide() override;
     void transfer_pinned_windows_to(std::shared_ptr<WorkspaceInterface> const& other) override;
     bool for_each_window(std::function<bool(std::shared_ptr<Container>)> const&) const override;
+    std::shared_ptr<Container> leaf_at(float x, float y, Container* ignored) const override;
+    void advise_area_changed(Container& container) override;
     std::shared_ptr<ParentContainer> create_floating_tree(mir::geometry::Rectangle const& area) override;
     void advise_focus_gained(std::shared_ptr<Container> const& container) override;
     void select_first_window() override;
@@ -75,6 +82,11 @@ public:
     [[nodiscard]] std::string display_name() const override;
     [[nodiscard]] std::shared_ptr<ParentContainer> get_root() const override { return root; }
 
+    /// A compact copy of the shape of this workspace's trees, with the floating
+    /// trees first. A new copy is built whenever any tree has changed shape, so
+    /// a copy that is held on to stays as it was.
+    [[nodiscard]] std::shared_ptr<ContainerTree const> get_tree() const;
+
 private:
     struct MoveResult
     {
@@ -100,6 +112,37 @@ private:
     std::shared_ptr<Config> config;
     std::weak_ptr<Container> last_selected_container;
     int config_handle = 0;
+    mutable std::shared_ptr<ContainerTree const> tree;
+    mutable std::optional<uint64_t> tree_version;
+
+    /// The visible areas of the tiled windows, for hit-testing the pointer.
+    mutable SpatialIndex<Container*> leaf_index;
+    /// The containers in [leaf_index], which is only keyed by their address.
+    mutable std::unordered_map<Container*, std::weak_ptr<Container>> leaf_index_containers;
+    mutable std::optional<uint64_t> leaf_index_version;
+
+    /// Rebuilds [leaf_index] if any tree has changed shape since it was built.
+    SpatialIndex<Container*> const& get_leaf_index() const;
+
+    /// The parts of the configuration that every container's layout depends on.
+    struct Spacing
+    {
+        int inner_gaps_x = 0;
+        int inner_gaps_y = 0;
+        int outer_gaps_x = 0;
+        int outer_gaps_y = 0;
+        int border_size = 0;
+
+        bool operator==(Spacing const&) const = default;
+    };
+
+    /// The spacing that the tree was last laid out with.
+    Spacing laid_out_spacing;
+
+    /// Lays out the root of the tree in [area], visiting only the subtrees
+    /// that have changed.
+    void layout(mir::geometry::Rectangle const& area);
+    [[nodiscard]] Spacing current_spacing() const;
 
     /// Retrieves the container that is currently being used for layout
     std::shared_ptr<ParentContainer> get_layout_container();
@@ -67,6 +67,13 @@ public:
     /// Returns true if the predicate returned true.
     virtual bool for_each_window(std::function<bool(std::shared_ptr<Container>)> const&) const = 0;
 
+    /// Finds the tiled window under the point, skipping [ignored] if it is provided.
+    virtual std::shared_ptr<Container> leaf_at(float x, float y, Container* ignored) const = 0;
+
+    /// Called when the visible area of [container] may have changed, so that
+    /// hit-testing can follow it.
+    virtual void advise_area_changed(Container& container) = 0;
+
     /// Creates a new floating tree on this workspace. The tree is empty by default
     /// and must be filled in by subsequent calls, lest it become a zombie tree with
     /// zero sub containers.
@@ -0,0 +1,149 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "workspace_snapshot.h"
+
+#include <mir/graphics/buffer.h>
+#include <mir/graphics/program_factory.h>
+#include <mir/graphics/renderable.h>
+#include <mir/graphics/texture.h>
+
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+using namespace miracle;
+
+namespace
+{
+class SnapshotTexture : public mg::gl::Texture
+{
+public:
+    explicit SnapshotTexture(geom::Size const& size)
+    {
+        glGenTextures(1, &id);
+        glBindTexture(GL_TEXTURE_2D, id);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size.width.as_int(), size.height.as_int(), 0,
+            GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    }
+
+    ~SnapshotTexture() override
+    {
+        glDeleteTextures(1, &id);
+    }
+
+    auto shader(mg::gl::ProgramFactory& factory) const -> mg::gl::Program const& override
+    {
+        static int const shader_id = 0;
+        return factory.compile_fragment_shader(
+            &shader_id,
+            "",
+            "uniform sampler2D tex;\n"
+            "vec4 sample_to_rgba(in vec2 texcoord)\n"
+            "{\n"
+            "    return texture2D(tex, texcoord);\n"
+            "}\n");
+    }
+
+    // Snapshots are drawn upside down, so that their first row is the top of the workspace
+    auto layout() const -> Layout override { return Layout::GL; }
+    void bind() override { glBindTexture(GL_TEXTURE_2D, id); }
+    auto tex_id() const -> GLuint override { return id; }
+    void add_syncpoint() override { }
+
+private:
+    GLuint id = 0;
+};
+
+/// Gives the renderable of a snapshot the size that its texture coordinates are computed from.
+class SnapshotBuffer : public mg::Buffer
+{
+public:
+    explicit SnapshotBuffer(geom::Size const& size) :
+        size_ { size }
+    {
+    }
+
+    mg::BufferID id() const override { return id_; }
+    geom::Size size() const override { return size_; }
+    MirPixelFormat pixel_format() const override { return mir_pixel_format_argb_8888; }
+    mg::NativeBufferBase* native_buffer_base() override { return nullptr; }
+
+private:
+    mg::BufferID const id_;
+    geom::Size const size_;
+};
+
+class SnapshotRenderable : public mg::Renderable
+{
+public:
+    SnapshotRenderable(geom::Rectangle const& area, std::shared_ptr<mg::Buffer> buffer) :
+        area { area },
+        buffer_ { std::move(buffer) }
+    {
+    }
+
+    ID id() const override { return this; }
+    std::shared_ptr<mg::Buffer> buffer() const override { return buffer_; }
+    geom::Rectangle screen_position() const override { return area; }
+    geom::RectangleD src_bounds() const override
+    {
+        return {
+            { 0, 0 },
+            { area.size.width.as_int(), area.size.height.as_int() }
+        };
+    }
+    std::optional<geom::Rectangle> clip_area() const override { return std::nullopt; }
+    float alpha() const override { return 1.f; }
+    glm::mat4 transformation() const override { return glm::mat4(1.f); }
+
+    // The areas between windows are transparent
+    bool shaped() const override { return true; }
+    std::optional<mir::scene::Surface const*> surface_if_any() const override { return std::nullopt; }
+
+private:
+    geom::Rectangle const area;
+    std::shared_ptr<mg::Buffer> const buffer_;
+};
+}
+
+WorkspaceSnapshot::WorkspaceSnapshot(geom::Rectangle const& area) :
+    size { area.size },
+    texture_ { std::make_shared<SnapshotTexture>(area.size) },
+    renderable_ { std::make_shared<SnapshotRenderable>(area, std::make_shared<SnapshotBuffer>(area.size)) }
+{
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture_->tex_id(), 0);
+}
+
+WorkspaceSnapshot::~WorkspaceSnapshot()
+{
+    glDeleteFramebuffers(1, &framebuffer);
+}
+
+bool WorkspaceSnapshot::bind() const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        return false;
+
+    glViewport(0, 0, size.width.as_int(), size.height.as_int());
+    return true;
+}
@@ -0,0 +1,79 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLE_WM_WORKSPACE_SNAPSHOT_H
+#define MIRACLE_WM_WORKSPACE_SNAPSHOT_H
+
+#include <GLES2/gl2.h>
+#include <memory>
+#include <mir/geometry/rectangle.h>
+#include <mir/graphics/buffer_id.h>
+#include <unordered_map>
+
+namespace mir
+{
+namespace scene
+{
+    class Surface;
+}
+namespace graphics
+{
+    class Renderable;
+}
+namespace graphics::gl
+{
+    class Texture;
+}
+}
+
+namespace miracle
+{
+
+/// An offscreen copy of a workspace. While a workspace is animated as a whole,
+/// the renderer draws its snapshot in place of its windows.
+class WorkspaceSnapshot
+{
+public:
+    /// Creates a snapshot that covers [area]. Requires a current GL context.
+    explicit WorkspaceSnapshot(mir::geometry::Rectangle const& area);
+    ~WorkspaceSnapshot();
+
+    WorkspaceSnapshot(WorkspaceSnapshot const&) = delete;
+    WorkspaceSnapshot& operator=(WorkspaceSnapshot const&) = delete;
+
+    /// Binds the framebuffer of the snapshot and sets the GL viewport to cover it.
+    /// \returns false if the snapshot cannot be drawn to
+    bool bind() const;
+
+    [[nodiscard]] std::shared_ptr<mir::graphics::gl::Texture> const& texture() const { return texture_; }
+
+    /// A renderable that draws the snapshot over the area that it was created for.
+    [[nodiscard]] std::shared_ptr<mir::graphics::Renderable> const& renderable() const { return renderable_; }
+
+    /// The buffer of each surface at the time that it was drawn into the snapshot.
+    std::unordered_map<mir::scene::Surface const*, mir::graphics::BufferID> sources;
+
+private:
+    mir::geometry::Size size;
+    GLuint framebuffer = 0;
+    std::shared_ptr<mir::graphics::gl::Texture> texture_;
+    std::shared_ptr<mir::graphics::Renderable> renderable_;
+};
+
+} // miracle
+
+#endif // MIRACLE_WM_WORKSPACE_SNAPSHOT_H
@@ -33,6 +33,8 @@ namespace test
         MOCK_METHOD(void, set_size_hack, (AnimationHandle, geom::Size const&), (override));
         MOCK_METHOD(miral::Window, window_at, (float, float), (override));
         MOCK_METHOD(void, process_animation, (AnimationStepResult const&, std::shared_ptr<Container> const&), (override));
+        MOCK_METHOD(void, begin, (), (override));
+        MOCK_METHOD(void, commit, (), (override));
     };
 
 } // namespace test
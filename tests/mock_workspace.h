@@ -55,6 +55,8 @@ namespace test
 
         MOCK_METHOD(bool, for_each_window,
             (std::function<bool(std::shared_ptr<Container>)> const&), (const, override));
+        MOCK_METHOD(std::shared_ptr<Container>, leaf_at, (float, float, Container*), (const, override));
+        MOCK_METHOD(void, advise_area_changed, (Container&), (override));
 
         MOCK_METHOD(void, advise_focus_gained, (std::shared_ptr<Container> const& container), (override));
 
@@ -101,20 +101,34 @@ namespace test
             return { num, ContainerType::leaf, name };
         }
 
-        int register_listener(std::function<void(miracle::Config&)> const&) override
+        int register_listener(std::function<void(miracle::Config&)> const& listener) override
         {
-            return -1;
+            return register_listener(listener, 5);
         }
 
         /// Register a listener on configuration change. A lower "priority" number signifies that the
         /// listener should be triggered earlier. A higher priority means later
-        int register_listener(std::function<void(miracle::Config&)> const&, int priority) override
+        int register_listener(std::function<void(miracle::Config&)> const& listener, int priority) override
         {
-            return -1;
+            listeners.push_back(listener);
+            return static_cast<int>(listeners.size() - 1);
         }
 
         void unregister_listener(int handle) override
         {
+            if (handle >= 0 && static_cast<size_t>(handle) < listeners.size())
+                listeners[static_cast<size_t>(handle)] = nullptr;
+        }
+
+        /// Changes the border size and notifies the listeners, as a reload would.
+        void set_border_size(int size)
+        {
+            border_config.size = size;
+            for (auto const& listener : listeners)
+            {
+                if (listener)
+                    listener(*this);
+            }
         }
 
         void try_process_change() override { }
@@ -139,6 +153,11 @@ namespace test
             return 0;
         }
 
+        [[nodiscard]] RenderingConfiguration rendering() const override
+        {
+            return {};
+        }
+
     private:
         miracle::BorderConfig border_config;
         std::array<AnimationDefinition, static_cast<int>(AnimateableEvent::max)> animations;
@@ -146,6 +165,7 @@ namespace test
         std::vector<StartupApp> startup_apps;
         std::optional<std::string> terminal_command;
         std::vector<EnvironmentVariable> env;
+        std::vector<std::function<void(miracle::Config&)>> listeners;
     };
 }
 }
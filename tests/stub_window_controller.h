@@ -141,6 +141,9 @@ public:
     {
     }
 
+    void begin() override { }
+    void commit() override { }
+
 private:
     std::vector<StubWindowData>& pairs;
     miral::WindowInfo stub_win_info;
@@ -16,7 +16,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 **/
 
 #include "animator.h"
+#include <atomic>
 #include <gtest/gtest.h>
+#include <thread>
 
 using namespace miracle;
 
@@ -38,10 +40,62 @@ public:
     void on_tick(AnimationStepResult const& asr) override
     {
         was_called = true;
+        last_result = asr;
     }
 
     bool was_called = false;
+    AnimationStepResult last_result;
 };
+
+/// Counts its dispatches and those that arrive after it was removed while
+/// still being current, from any thread.
+class CountingAnimation : public Animation
+{
+public:
+    CountingAnimation(Animator& animator, AnimationHandle handle, AnimationDefinition const& definition) :
+        Animation(
+            handle,
+            definition,
+            mir::geometry::Rectangle({ 0, 0 }, { 100, 100 }),
+            mir::geometry::Rectangle({ 500, 0 }, { 100, 100 }),
+            mir::geometry::Rectangle({ 0, 0 }, { 100, 100 })),
+        animator { animator }
+    {
+    }
+
+    void on_tick(AnimationStepResult const& asr) override
+    {
+        dispatches++;
+        if (removed && animator.is_current(asr))
+            late_dispatches++;
+    }
+
+    Animator& animator;
+    std::atomic<int> dispatches = 0;
+    std::atomic<int> late_dispatches = 0;
+    std::atomic<bool> removed = false;
+};
+
+std::shared_ptr<StubAnimation> make_slide(AnimationHandle handle, EaseFunction function, int distance)
+{
+    AnimationDefinition definition {
+        .type = AnimationType::slide,
+        .function = function,
+        .duration_seconds = 1
+    };
+    return std::make_shared<StubAnimation>(
+        handle,
+        definition,
+        mir::geometry::Rectangle(
+            mir::geometry::Point(0, 0),
+            mir::geometry::Size(100, 100)),
+        mir::geometry::Rectangle(
+            mir::geometry::Point(distance, 0),
+            mir::geometry::Size(100, 100)),
+        mir::geometry::Rectangle(
+            mir::geometry::Point(0, 0),
+            mir::geometry::Size(100, 100)));
+}
 }
 
 class AnimatorTest : public testing::Test
@@ -74,3 +128,216 @@ TEST_F(AnimatorTest, CanStepLinearSlideAnimation)
     animator.tick(0.16);
     EXPECT_EQ(animation->was_called, true);
 }
+
+TEST_F(AnimatorTest, BatchedStorageMatchesObjectStorage)
+{
+    Animator objects(AnimatorStorage::objects);
+    Animator batched(AnimatorStorage::batched);
+
+    std::vector<std::shared_ptr<StubAnimation>> object_animations;
+    std::vector<std::shared_ptr<StubAnimation>> batched_animations;
+    for (int i = 0; i < 12; i++)
+    {
+        auto const function = static_cast<EaseFunction>(i % 3 == 0 ? 0 : i);
+        auto const distance = 100 * (i + 1);
+        object_animations.push_back(make_slide(objects.register_animateable(), function, distance));
+        batched_animations.push_back(make_slide(batched.register_animateable(), function, distance));
+        objects.append(object_animations.back());
+        batched.append(batched_animations.back());
+    }
+
+    for (int step = 0; step < 5; step++)
+    {
+        objects.tick(0.1f);
+        batched.tick(0.1f);
+        for (size_t i = 0; i < object_animations.size(); i++)
+        {
+            auto const& expected = object_animations[i]->last_result;
+            auto const& actual = batched_animations[i]->last_result;
+            EXPECT_EQ(expected.is_complete, actual.is_complete);
+            ASSERT_TRUE(actual.position);
+            EXPECT_FLOAT_EQ(expected.position->x, actual.position->x);
+            EXPECT_FLOAT_EQ(expected.position->y, actual.position->y);
+        }
+    }
+}
+
+TEST_F(AnimatorTest, BatchedAnimationIsRemovedWhenComplete)
+{
+    Animator animator(AnimatorStorage::batched);
+    auto const animation = make_slide(animator.register_animateable(), EaseFunction::ease_in_out_cubic, 600);
+    animator.append(animation);
+    EXPECT_TRUE(animator.has_animations());
+
+    animator.tick(0.5f);
+    EXPECT_FALSE(animation->last_result.is_complete);
+    EXPECT_TRUE(animator.has_animations());
+
+    animator.tick(0.6f);
+    EXPECT_TRUE(animation->last_result.is_complete);
+    EXPECT_FALSE(animator.has_animations());
+}
+
+TEST_F(AnimatorTest, BatchedAnimationIsReplacedByLaterAnimationWithSameHandle)
+{
+    Animator animator(AnimatorStorage::batched);
+    auto const handle = animator.register_animateable();
+    auto const first = make_slide(handle, EaseFunction::linear, 600);
+    auto const second = make_slide(handle, EaseFunction::ease_out_sine, 300);
+    animator.append(first);
+    animator.append(second);
+
+    first->was_called = false;
+    animator.tick(0.1f);
+    EXPECT_FALSE(first->was_called);
+    EXPECT_TRUE(second->was_called);
+}
+
+TEST_F(AnimatorTest, RemovingAnAnimationKeepsTheOthersTicking)
+{
+    for (auto const storage : { AnimatorStorage::objects, AnimatorStorage::batched })
+    {
+        Animator animator(storage);
+        std::vector<std::shared_ptr<StubAnimation>> animations;
+        for (int i = 0; i < 5; i++)
+        {
+            animations.push_back(make_slide(animator.register_animateable(), EaseFunction::linear, 100 * (i + 1)));
+            animator.append(animations.back());
+        }
+
+        animator.remove_by_animation_handle(animations[1]->get_handle());
+        animator.remove_by_animation_handle(animations[4]->get_handle());
+        for (auto const& animation : animations)
+            animation->was_called = false;
+
+        animator.tick(0.1f);
+        EXPECT_TRUE(animations[0]->was_called);
+        EXPECT_FALSE(animations[1]->was_called);
+        EXPECT_TRUE(animations[2]->was_called);
+        EXPECT_TRUE(animations[3]->was_called);
+        EXPECT_FALSE(animations[4]->was_called);
+
+        animator.tick(1.f);
+        EXPECT_FALSE(animator.has_animations());
+    }
+}
+
+TEST_F(AnimatorTest, SupersedingAnAnimationLeavesOneAnimationPerHandle)
+{
+    for (auto const storage : { AnimatorStorage::objects, AnimatorStorage::batched })
+    {
+        Animator animator(storage);
+        std::vector<AnimationHandle> handles;
+        for (int i = 0; i < 4; i++)
+            handles.push_back(animator.register_animateable());
+
+        std::vector<std::shared_ptr<StubAnimation>> latest(handles.size());
+        for (int round = 0; round < 3; round++)
+        {
+            for (size_t i = 0; i < handles.size(); i++)
+            {
+                // Alternate the curve so that batched animations move between groups
+                auto const function = round % 2 == 0 ? EaseFunction::linear : EaseFunction::ease_out_sine;
+                latest[i] = make_slide(handles[i], function, 100 * (round + 1));
+                animator.append(latest[i]);
+            }
+        }
+
+        for (auto const& animation : latest)
+            animation->was_called = false;
+
+        animator.tick(1.f);
+        for (auto const& animation : latest)
+        {
+            EXPECT_TRUE(animation->was_called);
+            EXPECT_TRUE(animation->last_result.is_complete);
+        }
+        EXPECT_FALSE(animator.has_animations());
+    }
+}
+
+TEST_F(AnimatorTest, ResultsOfReplacedOrRemovedAnimationsAreNotCurrent)
+{
+    Animator animator;
+    auto const handle = animator.register_animateable();
+    auto const first = make_slide(handle, EaseFunction::linear, 600);
+    animator.append(first);
+    animator.tick(0.1f);
+    auto const first_result = first->last_result;
+    EXPECT_TRUE(animator.is_current(first_result));
+
+    auto const second = make_slide(handle, EaseFunction::linear, 300);
+    animator.append(second);
+    EXPECT_FALSE(animator.is_current(first_result));
+    EXPECT_TRUE(animator.is_current(second->last_result));
+
+    animator.remove_by_animation_handle(handle);
+    EXPECT_FALSE(animator.is_current(second->last_result));
+}
+
+TEST_F(AnimatorTest, ResultsFromOutsideTheAnimatorAreAlwaysCurrent)
+{
+    Animator animator;
+    auto const handle = animator.register_animateable();
+    animator.append(make_slide(handle, EaseFunction::linear, 600));
+    EXPECT_TRUE(animator.is_current(AnimationStepResult { handle, true }));
+}
+
+TEST_F(AnimatorTest, AnimationsCanBeChangedWhileAnotherThreadTicks)
+{
+    for (auto const storage : { AnimatorStorage::objects, AnimatorStorage::batched })
+    {
+        Animator animator(storage);
+        std::vector<AnimationHandle> handles;
+        for (int i = 0; i < 16; i++)
+            handles.push_back(animator.register_animateable());
+
+        std::atomic<bool> done = false;
+        std::thread ticker([&]()
+        {
+            while (!done)
+                animator.tick(0.001f);
+        });
+
+        std::vector<std::shared_ptr<CountingAnimation>> superseded_or_removed;
+        std::vector<std::shared_ptr<CountingAnimation>> latest(handles.size());
+        for (int round = 0; round < 2000; round++)
+        {
+            auto const i = static_cast<size_t>(round) % handles.size();
+            AnimationDefinition definition {
+                .type = round % 3 == 0 ? AnimationType::grow : AnimationType::slide,
+                .function = round % 2 == 0 ? EaseFunction::linear : EaseFunction::ease_out_sine,
+                .duration_seconds = 0.05f
+            };
+
+            auto const animation = std::make_shared<CountingAnimation>(animator, handles[i], definition);
+            animator.append(animation);
+            if (latest[i])
+            {
+                latest[i]->removed = true;
+                superseded_or_removed.push_back(latest[i]);
+            }
+            latest[i] = animation;
+
+            if (round % 7 == 0)
+                animator.set_size_hack(handles[i], { 120, 120 });
+
+            if (round % 5 == 0)
+            {
+                animator.remove_by_animation_handle(handles[i]);
+                latest[i]->removed = true;
+                superseded_or_removed.push_back(latest[i]);
+                latest[i] = nullptr;
+            }
+        }
+
+        done = true;
+        ticker.join();
+
+        for (auto const& animation : superseded_or_removed)
+        {
+            EXPECT_GE(animation->dispatches, 1);
+            EXPECT_EQ(animation->late_dispatches, 0);
+        }
+    }
+}
@@ -105,3 +105,36 @@ TEST_F(CommandControllerTest, cannot_move_active_to_same_workspace_by_name)
     std::string expected = "Test";
     ASSERT_FALSE(command_controller->move_active_to_workspace_named(expected, false));
 }
+
+TEST_F(CommandControllerTest, commands_in_a_transaction_are_applied_together)
+{
+    auto container = std::make_shared<testing::NiceMock<test::MockContainer>>();
+    state->add(container);
+    state->focus_container(container);
+
+    testing::InSequence sequence;
+    EXPECT_CALL(*window_controller, begin());
+    EXPECT_CALL(*container, move(Direction::left))
+        .WillOnce(testing::Return(true));
+    EXPECT_CALL(*container, move(Direction::up))
+        .WillOnce(testing::Return(true));
+    EXPECT_CALL(*window_controller, commit());
+
+    CommandController::Transaction transaction(*command_controller);
+    ASSERT_TRUE(command_controller->try_move(Direction::left));
+    ASSERT_TRUE(command_controller->try_move(Direction::up));
+}
+
+TEST_F(CommandControllerTest, commands_do_not_open_transactions_of_their_own)
+{
+    auto container = std::make_shared<testing::NiceMock<test::MockContainer>>();
+    state->add(container);
+    state->focus_container(container);
+
+    EXPECT_CALL(*window_controller, begin()).Times(0);
+    EXPECT_CALL(*window_controller, commit()).Times(0);
+    ON_CALL(*container, move(Direction::left))
+        .WillByDefault(testing::Return(true));
+
+    ASSERT_TRUE(command_controller->try_move(Direction::left));
+}
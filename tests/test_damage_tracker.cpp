@@ -0,0 +1,157 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "damage_tracker.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <gtest/gtest.h>
+
+using namespace miracle;
+namespace geom = mir::geometry;
+
+namespace
+{
+geom::Rectangle const viewport {
+    { 0, 0 },
+    { 1920, 1080 }
+};
+
+int const first_id = 1;
+int const second_id = 2;
+}
+
+class DamageTrackerTest : public testing::Test
+{
+public:
+    DamageTracker tracker;
+
+    static DamageTracker::Element element(void const* id, geom::Rectangle const& position, uint32_t buffer = 1)
+    {
+        DamageTracker::Element result;
+        result.id = id;
+        result.buffer_id = mir::graphics::BufferID { buffer };
+        result.screen_position = position;
+        return result;
+    }
+
+    /// Runs a single frame containing [elements] and returns the repaint region.
+    std::optional<geom::Rectangle> frame(std::vector<DamageTracker::Element> const& elements, int buffer_age = 1)
+    {
+        tracker.begin_frame(viewport);
+        for (auto const& e : elements)
+            tracker.add(e);
+        return tracker.end_frame(buffer_age);
+    }
+};
+
+TEST_F(DamageTrackerTest, first_frame_is_repainted_in_full)
+{
+    auto const result = frame({ element(&first_id, { { 0, 0 }, { 100, 100 } }) });
+    EXPECT_EQ(result, std::nullopt);
+}
+
+TEST_F(DamageTrackerTest, unchanged_frame_has_no_damage)
+{
+    auto const e = element(&first_id, { { 0, 0 }, { 100, 100 } });
+    frame({ e });
+    auto const result = frame({ e });
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result->size, geom::Size(0, 0));
+}
+
+TEST_F(DamageTrackerTest, new_buffer_damages_the_bounds_of_the_element)
+{
+    frame({ element(&first_id, { { 10, 20 }, { 100, 100 } }, 1) });
+    auto const result = frame({ element(&first_id, { { 10, 20 }, { 100, 100 } }, 2) });
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result.value(), geom::Rectangle({ 10, 20 }, { 100, 100 }));
+}
+
+TEST_F(DamageTrackerTest, moved_element_damages_old_and_new_position)
+{
+    frame({ element(&first_id, { { 0, 0 }, { 100, 100 } }) });
+    auto const result = frame({ element(&first_id, { { 200, 0 }, { 100, 100 } }) });
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result.value(), geom::Rectangle({ 0, 0 }, { 300, 100 }));
+}
+
+TEST_F(DamageTrackerTest, removed_element_damages_its_old_position)
+{
+    auto const first = element(&first_id, { { 0, 0 }, { 100, 100 } });
+    auto const second = element(&second_id, { { 500, 500 }, { 50, 50 } });
+    frame({ first, second });
+    auto const result = frame({ first });
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result.value(), geom::Rectangle({ 500, 500 }, { 50, 50 }));
+}
+
+TEST_F(DamageTrackerTest, older_buffers_accumulate_damage_of_previous_frames)
+{
+    frame({ element(&first_id, { { 0, 0 }, { 100, 100 } }, 1) });
+    frame({ element(&first_id, { { 0, 0 }, { 100, 100 } }, 2) });
+    auto const result = frame({ element(&first_id, { { 0, 0 }, { 100, 100 } }, 2),
+                                  element(&second_id, { { 500, 500 }, { 50, 50 } }) },
+        2);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result.value(), geom::Rectangle({ 0, 0 }, { 550, 550 }));
+}
+
+TEST_F(DamageTrackerTest, unknown_buffer_age_is_repainted_in_full)
+{
+    auto const e = element(&first_id, { { 0, 0 }, { 100, 100 } });
+    frame({ e });
+    EXPECT_EQ(frame({ e }, 0), std::nullopt);
+    EXPECT_EQ(frame({ e }, DamageTracker::max_buffer_age + 1), std::nullopt);
+}
+
+TEST_F(DamageTrackerTest, damage_all_repaints_in_full)
+{
+    auto const e = element(&first_id, { { 0, 0 }, { 100, 100 } });
+    frame({ e });
+    tracker.begin_frame(viewport);
+    tracker.add(e);
+    tracker.damage_all();
+    EXPECT_EQ(tracker.end_frame(1), std::nullopt);
+}
+
+TEST_F(DamageTrackerTest, outline_change_damages_the_outline)
+{
+    auto e = element(&first_id, { { 100, 100 }, { 100, 100 } });
+    e.outline_size = 5;
+    frame({ e });
+    e.outline_color = glm::vec4(1.f);
+    auto const result = frame({ e });
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result.value(), geom::Rectangle({ 95, 95 }, { 110, 110 }));
+}
+
+TEST_F(DamageTrackerTest, damage_is_clipped_to_the_viewport)
+{
+    frame({ element(&first_id, { { 1900, 0 }, { 100, 100 } }, 1) });
+    auto const result = frame({ element(&first_id, { { 1900, 0 }, { 100, 100 } }, 2) });
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result.value(), geom::Rectangle({ 1900, 0 }, { 20, 100 }));
+}
+
+TEST_F(DamageTrackerTest, transformed_bounds_apply_the_workspace_transform)
+{
+    auto const result = transformed_bounds(
+        { { 0, 0 }, { 100, 100 } },
+        glm::scale(glm::mat4(1.f), glm::vec3(0.5f, 0.5f, 1.f)),
+        glm::translate(glm::mat4(1.f), glm::vec3(10.f, 20.f, 0.f)));
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result.value(), geom::Rectangle({ 10, 20 }, { 50, 50 }));
+}
@@ -0,0 +1,121 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "easing.h"
+#include <cmath>
+#include <gtest/gtest.h>
+
+using namespace miracle;
+
+namespace
+{
+float max_table_error(AnimationDefinition const& definition)
+{
+    auto const table = ease_table(definition);
+    float error = 0;
+    for (int i = 0; i <= 100000; i++)
+    {
+        auto const t = static_cast<float>(i) / 100000.f;
+        error = std::max(error, std::abs(table->ease(t) - ease(definition, t)));
+    }
+    return error;
+}
+}
+
+TEST(EasingTest, table_is_within_tolerance_of_every_curve)
+{
+    for (int i = 0; i < static_cast<int>(EaseFunction::max); i++)
+    {
+        AnimationDefinition definition;
+        definition.function = static_cast<EaseFunction>(i);
+        EXPECT_LE(max_table_error(definition), 1e-3f) << "ease function " << i;
+    }
+}
+
+TEST(EasingTest, table_is_exact_at_the_ends)
+{
+    for (int i = 0; i < static_cast<int>(EaseFunction::max); i++)
+    {
+        AnimationDefinition definition;
+        definition.function = static_cast<EaseFunction>(i);
+        auto const table = ease_table(definition);
+        EXPECT_FLOAT_EQ(table->ease(0.f), ease(definition, 0.f)) << "ease function " << i;
+        EXPECT_FLOAT_EQ(table->ease(1.f), ease(definition, 1.f)) << "ease function " << i;
+    }
+}
+
+TEST(EasingTest, table_batch_matches_single_values)
+{
+    AnimationDefinition definition;
+    definition.function = EaseFunction::ease_in_out_cubic;
+    auto const table = ease_table(definition);
+
+    float t[64];
+    float out[64];
+    for (int i = 0; i < 64; i++)
+        t[i] = static_cast<float>(i) / 63.f;
+    table->ease_batch(t, out, 64);
+    for (int i = 0; i < 64; i++)
+        EXPECT_EQ(out[i], table->ease(t[i]));
+}
+
+TEST(EasingTest, tables_are_shared_by_the_same_curve)
+{
+    AnimationDefinition first;
+    first.function = EaseFunction::ease_out_back;
+    first.duration_seconds = 0.25f;
+    AnimationDefinition second;
+    second.function = EaseFunction::ease_out_back;
+    second.duration_seconds = 2.f;
+
+    // Constants that ease_out_back does not use do not make a new curve
+    second.c4 = 5.f;
+    EXPECT_EQ(ease_table(first), ease_table(second));
+}
+
+TEST(EasingTest, custom_constant_builds_a_new_table)
+{
+    AnimationDefinition standard;
+    standard.function = EaseFunction::ease_out_back;
+    AnimationDefinition custom = standard;
+    custom.c1 = 2.5f;
+    custom.c3 = 3.5f;
+
+    EXPECT_NE(ease_table(standard), ease_table(custom));
+    EXPECT_LE(max_table_error(custom), 1e-3f);
+}
+
+TEST(EasingTest, tables_that_are_no_longer_used_are_dropped)
+{
+    AnimationDefinition definition;
+    definition.function = EaseFunction::ease_out_elastic;
+    auto const held = ease_table(definition);
+    AnimationDefinition previous = definition;
+    previous.c4 = 1.f;
+    std::weak_ptr<EaseTable const> const released = ease_table(previous);
+
+    // Enough reloads with new constants to fill the cache
+    for (size_t i = 0; i < max_cached_ease_tables; i++)
+    {
+        auto custom = definition;
+        custom.c4 = 2.f + static_cast<float>(i);
+        ease_table(custom);
+    }
+
+    EXPECT_TRUE(released.expired());
+    EXPECT_EQ(ease_table(definition), held);
+}
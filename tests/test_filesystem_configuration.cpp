@@ -509,4 +509,115 @@ TEST_F(FilesystemConfigurationTest, DragAndDropMissingModifiers)
     FilesystemConfiguration config(runner, path, true);
     EXPECT_EQ(config.drag_and_drop().enabled, true);
     EXPECT_EQ(config.drag_and_drop().modifiers, miracle_input_event_modifier_default | mir_input_event_modifier_shift);
-}
\ No newline at end of file
+}
+
+TEST_F(FilesystemConfigurationTest, RenderingBorderModeDefaultsToStencil)
+{
+    YAML::Node node;
+    node["rendering"] = YAML::Node(YAML::NodeType::Map);
+    write_yaml_node(node);
+
+    FilesystemConfiguration config(runner, path, true);
+    EXPECT_EQ(config.rendering().border_mode, BorderMode::stencil);
+}
+
+TEST_F(FilesystemConfigurationTest, RenderingBorderModeCanBeAnalytic)
+{
+    YAML::Node rendering;
+    rendering["border_mode"] = "analytic";
+
+    YAML::Node node;
+    node["rendering"] = rendering;
+    write_yaml_node(node);
+
+    FilesystemConfiguration config(runner, path, true);
+    EXPECT_EQ(config.rendering().border_mode, BorderMode::analytic);
+}
+
+TEST_F(FilesystemConfigurationTest, RenderingInvalidBorderModeIsIgnored)
+{
+    YAML::Node rendering;
+    rendering["border_mode"] = "invalid";
+
+    YAML::Node node;
+    node["rendering"] = rendering;
+    write_yaml_node(node);
+
+    FilesystemConfiguration config(runner, path, true);
+    EXPECT_EQ(config.rendering().border_mode, BorderMode::stencil);
+}
+
+TEST_F(FilesystemConfigurationTest, RenderingFilterDefaultsToNone)
+{
+    YAML::Node node;
+    node["rendering"] = YAML::Node(YAML::NodeType::Map);
+    write_yaml_node(node);
+
+    FilesystemConfiguration config(runner, path, true);
+    EXPECT_EQ(config.rendering().filter, RenderFilter::none);
+}
+
+TEST_F(FilesystemConfigurationTest, RenderingFilterCanBeDeuteranopia)
+{
+    YAML::Node rendering;
+    rendering["filter"] = "deuteranopia";
+
+    YAML::Node node;
+    node["rendering"] = rendering;
+    write_yaml_node(node);
+
+    FilesystemConfiguration config(runner, path, true);
+    EXPECT_EQ(config.rendering().filter, RenderFilter::deuteranopia);
+}
+
+TEST_F(FilesystemConfigurationTest, RenderingFullscreenFastPathCanBeDisabled)
+{
+    YAML::Node rendering;
+    rendering["fullscreen_fast_path"] = false;
+
+    YAML::Node node;
+    node["rendering"] = rendering;
+    write_yaml_node(node);
+
+    FilesystemConfiguration config(runner, path, true);
+    EXPECT_FALSE(config.rendering().fullscreen_fast_path);
+}
+
+TEST_F(FilesystemConfigurationTest, RenderingWorkspaceSnapshotsCanBeEnabled)
+{
+    YAML::Node rendering;
+    rendering["workspace_snapshots"] = true;
+
+    YAML::Node node;
+    node["rendering"] = rendering;
+    write_yaml_node(node);
+
+    FilesystemConfiguration config(runner, path, true);
+    EXPECT_TRUE(config.rendering().workspace_snapshots);
+}
+
+TEST_F(FilesystemConfigurationTest, RenderingMaxAnimationRateCanBeSet)
+{
+    YAML::Node rendering;
+    rendering["max_animation_rate"] = 75;
+
+    YAML::Node node;
+    node["rendering"] = rendering;
+    write_yaml_node(node);
+
+    FilesystemConfiguration config(runner, path, true);
+    EXPECT_EQ(config.rendering().max_animation_rate, 75);
+}
+
+TEST_F(FilesystemConfigurationTest, RenderingTransactionTimeoutCanBeSet)
+{
+    YAML::Node rendering;
+    rendering["transaction_timeout_ms"] = 150;
+
+    YAML::Node node;
+    node["rendering"] = rendering;
+    write_yaml_node(node);
+
+    FilesystemConfiguration config(runner, path, true);
+    EXPECT_EQ(config.rendering().transaction_timeout_ms, 150);
+}
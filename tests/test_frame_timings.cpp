@@ -0,0 +1,93 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "frame_timings.h"
+#include <gtest/gtest.h>
+
+using namespace miracle;
+using namespace std::chrono_literals;
+
+TEST(DurationHistogramTest, empty_histogram_summarizes_to_zero)
+{
+    DurationHistogram histogram;
+    auto const summary = histogram.summarize();
+    EXPECT_EQ(summary.count, 0);
+    EXPECT_EQ(summary.p99, 0us);
+    EXPECT_EQ(summary.max, 0us);
+}
+
+TEST(DurationHistogramTest, buckets_are_ordered_by_duration)
+{
+    EXPECT_EQ(DurationHistogram::bucket_for(0ns), 0);
+    EXPECT_EQ(DurationHistogram::bucket_for(10us), 0);
+    EXPECT_EQ(DurationHistogram::bucket_for(11us), 1);
+    EXPECT_LT(DurationHistogram::bucket_for(1ms), DurationHistogram::bucket_for(2ms));
+    EXPECT_EQ(DurationHistogram::bucket_for(1h), DurationHistogram::bucket_count - 1);
+}
+
+TEST(DurationHistogramTest, percentiles_are_within_one_bucket)
+{
+    DurationHistogram histogram;
+    for (int i = 1; i <= 100; i++)
+        histogram.record(std::chrono::microseconds(i * 100));
+
+    auto const summary = histogram.summarize();
+    EXPECT_EQ(summary.count, 100);
+    EXPECT_EQ(summary.max, 10ms);
+    EXPECT_EQ(summary.mean, 5050us);
+
+    // Buckets are 25% wide, so the reported value may be up to 25% larger
+    EXPECT_GE(summary.p50, 5000us);
+    EXPECT_LE(summary.p50, 6250us);
+    EXPECT_GE(summary.p90, 9000us);
+    EXPECT_LE(summary.p90, 10ms);
+    EXPECT_GE(summary.p99, 9900us);
+    EXPECT_LE(summary.p99, 10ms);
+}
+
+TEST(DurationHistogramTest, percentiles_never_exceed_max)
+{
+    DurationHistogram histogram;
+    histogram.record(11us);
+    auto const summary = histogram.summarize();
+    EXPECT_EQ(summary.p50, 11us);
+    EXPECT_EQ(summary.p99, 11us);
+}
+
+TEST(FrameTimingsTest, area_can_be_read_back)
+{
+    FrameTimings timings;
+    mir::geometry::Rectangle const area {
+        { 1920, 0 },
+        { 2560, 1440 }
+    };
+    timings.area(area);
+    EXPECT_EQ(timings.area(), area);
+}
+
+TEST(FrameTimingsRegistryTest, released_timings_are_forgotten)
+{
+    FrameTimingsRegistry registry;
+    auto first = registry.add();
+    auto second = registry.add();
+    EXPECT_EQ(registry.all().size(), 2);
+
+    first.reset();
+    auto const all = registry.all();
+    ASSERT_EQ(all.size(), 1);
+    EXPECT_EQ(all[0], second);
+}
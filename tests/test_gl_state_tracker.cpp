@@ -0,0 +1,72 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "gl_state_tracker.h"
+#include <gtest/gtest.h>
+
+using namespace miracle;
+
+TEST(UniformShadowTest, first_value_is_always_uploaded)
+{
+    UniformShadow shadow;
+    float const value = 1.f;
+    EXPECT_TRUE(shadow.update(0, &value, 1));
+}
+
+TEST(UniformShadowTest, repeated_value_is_elided)
+{
+    UniformShadow shadow;
+    float const value[] = { 1.f, 2.f, 3.f, 4.f };
+    shadow.update(3, value, 4);
+    EXPECT_FALSE(shadow.update(3, value, 4));
+}
+
+TEST(UniformShadowTest, changed_value_is_uploaded)
+{
+    UniformShadow shadow;
+    float value[] = { 1.f, 2.f, 3.f, 4.f };
+    shadow.update(3, value, 4);
+    value[3] = 5.f;
+    EXPECT_TRUE(shadow.update(3, value, 4));
+    EXPECT_FALSE(shadow.update(3, value, 4));
+}
+
+TEST(UniformShadowTest, locations_are_independent)
+{
+    UniformShadow shadow;
+    int const value = 7;
+    shadow.update(0, &value, 1);
+    EXPECT_TRUE(shadow.update(1, &value, 1));
+    EXPECT_FALSE(shadow.update(0, &value, 1));
+}
+
+TEST(UniformShadowTest, clear_forgets_values)
+{
+    UniformShadow shadow;
+    int const value = 7;
+    shadow.update(0, &value, 1);
+    shadow.clear();
+    EXPECT_TRUE(shadow.update(0, &value, 1));
+}
+
+TEST(UniformShadowTest, invalid_location_is_never_recorded)
+{
+    UniformShadow shadow;
+    int const value = 7;
+    EXPECT_TRUE(shadow.update(-1, &value, 1));
+    EXPECT_TRUE(shadow.update(-1, &value, 1));
+}
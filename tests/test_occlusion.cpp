@@ -0,0 +1,108 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "occlusion.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <gtest/gtest.h>
+
+using namespace miracle;
+namespace geom = mir::geometry;
+
+TEST(OcclusionTest, rectangle_is_covered_by_larger_rectangle)
+{
+    EXPECT_TRUE(is_covered({ { 10, 10 }, { 50, 50 } }, { { { 0, 0 }, { 100, 100 } } }));
+}
+
+TEST(OcclusionTest, rectangle_is_not_covered_by_overlapping_rectangle)
+{
+    EXPECT_FALSE(is_covered({ { 10, 10 }, { 50, 50 } }, { { { 20, 0 }, { 100, 100 } } }));
+}
+
+TEST(OcclusionTest, rectangle_is_covered_by_union_of_rectangles)
+{
+    EXPECT_TRUE(is_covered(
+        { { 0, 0 }, { 100, 100 } },
+        { { { 0, 0 }, { 50, 100 } },
+            { { 50, 0 }, { 50, 60 } },
+            { { 40, 50 }, { 60, 50 } } }));
+}
+
+TEST(OcclusionTest, rectangle_with_a_hole_is_not_covered)
+{
+    EXPECT_FALSE(is_covered(
+        { { 0, 0 }, { 100, 100 } },
+        { { { 0, 0 }, { 100, 40 } },
+            { { 0, 60 }, { 100, 40 } },
+            { { 0, 40 }, { 40, 20 } },
+            { { 60, 40 }, { 40, 20 } } }));
+}
+
+TEST(OcclusionTest, elements_below_an_opaque_element_are_occluded)
+{
+    std::vector<Occludable> elements = {
+        { geom::Rectangle { { 10, 10 }, { 20, 20 } }, geom::Rectangle { { 10, 10 }, { 20, 20 } } },
+        { geom::Rectangle { { 500, 10 }, { 20, 20 } }, std::nullopt },
+        { geom::Rectangle { { 0, 0 }, { 100, 100 } }, geom::Rectangle { { 0, 0 }, { 100, 100 } } }
+    };
+
+    std::vector<bool> occluded;
+    EXPECT_EQ(find_occluded(elements, occluded), 1u);
+    EXPECT_TRUE(occluded[0]);
+    EXPECT_FALSE(occluded[1]);
+    EXPECT_FALSE(occluded[2]);
+}
+
+TEST(OcclusionTest, translucent_elements_do_not_occlude)
+{
+    std::vector<Occludable> elements = {
+        { geom::Rectangle { { 10, 10 }, { 20, 20 } }, std::nullopt },
+        { geom::Rectangle { { 0, 0 }, { 100, 100 } }, std::nullopt }
+    };
+
+    std::vector<bool> occluded;
+    EXPECT_EQ(find_occluded(elements, occluded), 0u);
+}
+
+TEST(OcclusionTest, elements_with_unknown_bounds_are_never_occluded)
+{
+    std::vector<Occludable> elements = {
+        { std::nullopt, std::nullopt },
+        { geom::Rectangle { { 0, 0 }, { 100, 100 } }, geom::Rectangle { { 0, 0 }, { 100, 100 } } }
+    };
+
+    std::vector<bool> occluded;
+    EXPECT_EQ(find_occluded(elements, occluded), 0u);
+}
+
+TEST(OcclusionTest, opaque_bounds_apply_translation)
+{
+    auto const result = opaque_bounds(
+        { { 0, 0 }, { 100, 100 } },
+        glm::mat4(1.f),
+        glm::translate(glm::mat4(1.f), glm::vec3(-50.f, 10.f, 0.f)));
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result.value(), geom::Rectangle({ -50, 10 }, { 100, 100 }));
+}
+
+TEST(OcclusionTest, rotated_elements_have_no_opaque_bounds)
+{
+    auto const result = opaque_bounds(
+        { { 0, 0 }, { 100, 100 } },
+        glm::rotate(glm::mat4(1.f), 0.5f, glm::vec3(0.f, 0.f, 1.f)),
+        glm::mat4(1.f));
+    EXPECT_FALSE(result.has_value());
+}
@@ -0,0 +1,132 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "pending_window_changes.h"
+#include "stub_session.h"
+#include "stub_surface.h"
+#include <gtest/gtest.h>
+
+using namespace miracle;
+
+namespace geom = mir::geometry;
+
+class PendingWindowChangesTest : public testing::Test
+{
+public:
+    miral::Window create_window()
+    {
+        auto session = std::make_shared<test::StubSession>();
+        sessions.push_back(session);
+        auto surface = std::make_shared<test::StubSurface>();
+        surfaces.push_back(surface);
+        return miral::Window(session, surface);
+    }
+
+    std::vector<std::shared_ptr<test::StubSession>> sessions;
+    std::vector<std::shared_ptr<test::StubSurface>> surfaces;
+    PendingWindowChanges changes;
+};
+
+TEST_F(PendingWindowChangesTest, only_the_outermost_commit_returns_the_changes)
+{
+    auto window = create_window();
+    changes.begin();
+    changes.begin();
+    changes.set_state(window, mir_window_state_fullscreen);
+
+    ASSERT_FALSE(changes.commit().has_value());
+    ASSERT_TRUE(changes.is_recording());
+
+    auto const committed = changes.commit();
+    ASSERT_TRUE(committed.has_value());
+    ASSERT_EQ(committed->size(), 1);
+    ASSERT_FALSE(changes.is_recording());
+}
+
+TEST_F(PendingWindowChangesTest, commit_without_begin_returns_nothing)
+{
+    ASSERT_FALSE(changes.commit().has_value());
+    ASSERT_FALSE(changes.is_recording());
+}
+
+TEST_F(PendingWindowChangesTest, recorded_state_can_be_read_before_commit)
+{
+    auto window = create_window();
+    auto other = create_window();
+    changes.begin();
+    changes.set_state(window, mir_window_state_fullscreen);
+
+    auto const change = changes.find(window);
+    ASSERT_NE(change, nullptr);
+    ASSERT_EQ(change->state, mir_window_state_fullscreen);
+    ASSERT_EQ(changes.find(other), nullptr);
+
+    changes.commit();
+    ASSERT_EQ(changes.find(window), nullptr);
+}
+
+TEST_F(PendingWindowChangesTest, every_window_is_committed_in_a_single_batch)
+{
+    auto window1 = create_window();
+    auto window2 = create_window();
+    geom::Rectangle const area { { 0, 0 }, { 100, 100 } };
+    geom::Rectangle const moved { { 100, 0 }, { 100, 100 } };
+
+    changes.begin();
+    changes.set_rectangle(window1, area, moved, true);
+    changes.set_state(window2, mir_window_state_maximized);
+    changes.modify(window1, miral::WindowSpecification());
+
+    auto const committed = changes.commit();
+    ASSERT_TRUE(committed.has_value());
+    ASSERT_EQ(committed->size(), 2);
+    ASSERT_EQ((*committed)[0].window, window1);
+    ASSERT_EQ((*committed)[0].modifications.size(), 1);
+    ASSERT_EQ((*committed)[0].rectangle->to, moved);
+    ASSERT_EQ((*committed)[1].window, window2);
+    ASSERT_EQ((*committed)[1].state, mir_window_state_maximized);
+}
+
+TEST_F(PendingWindowChangesTest, window_moved_twice_animates_from_where_it_began)
+{
+    auto window = create_window();
+    geom::Rectangle const start { { 0, 0 }, { 100, 100 } };
+    geom::Rectangle const middle { { 50, 0 }, { 100, 100 } };
+    geom::Rectangle const end { { 100, 0 }, { 100, 100 } };
+
+    changes.begin();
+    changes.set_rectangle(window, start, middle, true);
+    changes.set_rectangle(window, middle, end, false);
+
+    auto const committed = changes.commit();
+    auto const& rectangle = (*committed)[0].rectangle;
+    ASSERT_EQ(rectangle->from, start);
+    ASSERT_EQ(rectangle->to, end);
+    ASSERT_FALSE(rectangle->with_animations);
+}
+
+TEST_F(PendingWindowChangesTest, forgotten_windows_are_not_committed)
+{
+    auto window = create_window();
+    changes.begin();
+    changes.set_state(window, mir_window_state_fullscreen);
+    changes.forget(window);
+
+    auto const committed = changes.commit();
+    ASSERT_TRUE(committed.has_value());
+    ASSERT_TRUE(committed->empty());
+}
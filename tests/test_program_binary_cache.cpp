@@ -0,0 +1,79 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "program_binary_cache.h"
+#include <gtest/gtest.h>
+
+using namespace miracle;
+
+namespace
+{
+ProgramBinaryCache::Key const key { 0x1234, 0x5678 };
+
+ProgramBinaryCache::Binary make_binary()
+{
+    return {
+        0x8e21,
+        { 'p', 'r', 'o', 'g', 'r', 'a', 'm' },
+        std::chrono::milliseconds(12)
+    };
+}
+}
+
+TEST(ProgramBinaryCacheTest, entry_round_trips)
+{
+    auto const data = ProgramBinaryCache::serialize(key, make_binary());
+    auto const binary = ProgramBinaryCache::deserialize(key, data);
+    ASSERT_TRUE(binary.has_value());
+    EXPECT_EQ(binary->format, 0x8e21);
+    EXPECT_EQ(binary->data, make_binary().data);
+    EXPECT_EQ(binary->compile_time, std::chrono::milliseconds(12));
+}
+
+TEST(ProgramBinaryCacheTest, entry_from_other_driver_is_rejected)
+{
+    auto const data = ProgramBinaryCache::serialize(key, make_binary());
+    EXPECT_FALSE(ProgramBinaryCache::deserialize({ 0x4321, key.source_hash }, data).has_value());
+}
+
+TEST(ProgramBinaryCacheTest, entry_for_other_source_is_rejected)
+{
+    auto const data = ProgramBinaryCache::serialize(key, make_binary());
+    EXPECT_FALSE(ProgramBinaryCache::deserialize({ key.driver_hash, 0x8765 }, data).has_value());
+}
+
+TEST(ProgramBinaryCacheTest, truncated_entry_is_rejected)
+{
+    auto data = ProgramBinaryCache::serialize(key, make_binary());
+    data.pop_back();
+    EXPECT_FALSE(ProgramBinaryCache::deserialize(key, data).has_value());
+    EXPECT_FALSE(ProgramBinaryCache::deserialize(key, std::span(data).first(10)).has_value());
+}
+
+TEST(ProgramBinaryCacheTest, corrupted_entry_is_rejected)
+{
+    auto data = ProgramBinaryCache::serialize(key, make_binary());
+    data.back() ^= 1;
+    EXPECT_FALSE(ProgramBinaryCache::deserialize(key, data).has_value());
+}
+
+TEST(ProgramBinaryCacheTest, hash_depends_on_every_byte)
+{
+    EXPECT_EQ(ProgramBinaryCache::hash("shader"), ProgramBinaryCache::hash("shader"));
+    EXPECT_NE(ProgramBinaryCache::hash("shader"), ProgramBinaryCache::hash("shadeR"));
+    EXPECT_NE(ProgramBinaryCache::hash(""), ProgramBinaryCache::hash(std::string_view("\0", 1)));
+}
@@ -16,7 +16,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 **/
 
 #include "mock_container.h"
+#include "mock_workspace.h"
 #include "render_data_manager.h"
+#include "stub_session.h"
+#include "stub_surface.h"
 #include <gtest/gtest.h>
 
 using namespace miracle;
@@ -43,14 +46,16 @@ TEST_F(RenderDataManagerTest, values_are_populated_when_container_added)
     ON_CALL(container, is_focused())
         .WillByDefault(::testing::Return(true));
 
-    render_data_manager.add(container);
+    auto const handle = render_data_manager.add(container);
 
-    auto result = render_data_manager.get();
-    ASSERT_EQ(result.size(), 1);
-    ASSERT_TRUE(result[0].needs_outline);
-    ASSERT_TRUE(result[0].is_focused);
-    ASSERT_EQ(result[0].transform, glm::mat4(1.f));
-    ASSERT_EQ(result[0].workspace_transform, glm::mat4(1.f));
+    auto const result = render_data_manager.get();
+    ASSERT_EQ(result->size(), 1);
+    auto const* data = result->get(handle);
+    ASSERT_NE(data, nullptr);
+    ASSERT_TRUE(data->needs_outline);
+    ASSERT_TRUE(data->is_focused);
+    ASSERT_EQ(data->transform, glm::mat4(1.f));
+    ASSERT_EQ(result->workspace_transform(*data), glm::mat4(1.f));
 }
 
 TEST_F(RenderDataManagerTest, can_change_transform)
@@ -69,48 +74,78 @@ TEST_F(RenderDataManagerTest, can_change_transform)
     ON_CALL(container, is_focused())
         .WillByDefault(::testing::Return(true));
 
-    render_data_manager.add(container);
+    auto const handle = render_data_manager.add(container);
 
     ON_CALL(container, get_transform())
         .WillByDefault(::testing::Return(glm::mat4(2.f)));
-    render_data_manager.transform_change(container);
-
-    auto result = render_data_manager.get();
-    ASSERT_EQ(result.size(), 1);
-    ASSERT_TRUE(result[0].needs_outline);
-    ASSERT_TRUE(result[0].is_focused);
-    ASSERT_EQ(result[0].transform, glm::mat4(2.f));
-    ASSERT_EQ(result[0].workspace_transform, glm::mat4(1.f));
+    render_data_manager.transform_change(handle, container);
+
+    auto const result = render_data_manager.get();
+    ASSERT_EQ(result->size(), 1);
+    auto const* data = result->get(handle);
+    ASSERT_NE(data, nullptr);
+    ASSERT_TRUE(data->needs_outline);
+    ASSERT_TRUE(data->is_focused);
+    ASSERT_EQ(data->transform, glm::mat4(2.f));
+    ASSERT_EQ(result->workspace_transform(*data), glm::mat4(1.f));
 }
 
-TEST_F(RenderDataManagerTest, can_change_workspace_transform)
+TEST_F(RenderDataManagerTest, can_change_workspace)
 {
+    ::testing::NiceMock<test::MockWorkspace> first;
+    ::testing::NiceMock<test::MockWorkspace> second;
+    ON_CALL(first, id()).WillByDefault(::testing::Return(1));
+    ON_CALL(second, id()).WillByDefault(::testing::Return(2));
+
     ::testing::NiceMock<test::MockContainer> container;
     ON_CALL(container, window())
         .WillByDefault(::testing::Return(miral::Window()));
     ON_CALL(container, get_type())
         .WillByDefault(::testing::Return(ContainerType::leaf));
-    ON_CALL(container, get_output_transform())
-        .WillByDefault(::testing::Return(glm::mat4(1.f)));
-    ON_CALL(container, get_workspace_transform())
-        .WillByDefault(::testing::Return(glm::mat4(1.f)));
-    ON_CALL(container, get_transform())
-        .WillByDefault(::testing::Return(glm::mat4(1.f)));
-    ON_CALL(container, is_focused())
-        .WillByDefault(::testing::Return(true));
+    ON_CALL(container, get_workspace())
+        .WillByDefault(::testing::Return(&first));
 
-    render_data_manager.add(container);
+    auto const handle = render_data_manager.add(container);
+    ASSERT_EQ(render_data_manager.get()->get(handle)->workspace_id, 1);
 
-    ON_CALL(container, get_workspace_transform())
-        .WillByDefault(::testing::Return(glm::mat4(2.f)));
-    render_data_manager.workspace_transform_change(container);
-
-    auto result = render_data_manager.get();
-    ASSERT_EQ(result.size(), 1);
-    ASSERT_TRUE(result[0].needs_outline);
-    ASSERT_TRUE(result[0].is_focused);
-    ASSERT_EQ(result[0].transform, glm::mat4(1.f));
-    ASSERT_EQ(result[0].workspace_transform, glm::mat4(2.f));
+    ON_CALL(container, get_workspace())
+        .WillByDefault(::testing::Return(&second));
+    render_data_manager.workspace_change(handle, container);
+    ASSERT_EQ(render_data_manager.get()->get(handle)->workspace_id, 2);
+}
+
+TEST_F(RenderDataManagerTest, workspace_transform_is_shared_by_its_windows)
+{
+    ::testing::NiceMock<test::MockWorkspace> workspace;
+    ON_CALL(workspace, id()).WillByDefault(::testing::Return(1));
+
+    ::testing::NiceMock<test::MockContainer> container;
+    ON_CALL(container, window())
+        .WillByDefault(::testing::Return(miral::Window()));
+    ON_CALL(container, get_type())
+        .WillByDefault(::testing::Return(ContainerType::leaf));
+    ON_CALL(container, get_workspace())
+        .WillByDefault(::testing::Return(&workspace));
+
+    auto const first = render_data_manager.add(container);
+    auto const second = render_data_manager.add(container);
+    render_data_manager.set_workspace_transform(1, glm::mat4(2.f));
+
+    auto const result = render_data_manager.get();
+    ASSERT_EQ(result->workspace_transform(*result->get(first)), glm::mat4(2.f));
+    ASSERT_EQ(result->workspace_transform(*result->get(second)), glm::mat4(2.f));
+
+    render_data_manager.remove_workspace(1);
+    ASSERT_EQ(render_data_manager.get()->workspace_transform(*result->get(first)), glm::mat4(1.f));
+}
+
+TEST_F(RenderDataManagerTest, unchanged_workspace_transform_is_not_republished)
+{
+    render_data_manager.set_workspace_transform(1, glm::mat4(2.f));
+    auto const before = render_data_manager.get();
+
+    render_data_manager.set_workspace_transform(1, glm::mat4(2.f));
+    ASSERT_EQ(render_data_manager.get(), before);
 }
 
 TEST_F(RenderDataManagerTest, can_change_focus)
@@ -129,18 +164,136 @@ TEST_F(RenderDataManagerTest, can_change_focus)
     ON_CALL(container, is_focused())
         .WillByDefault(::testing::Return(true));
 
-    render_data_manager.add(container);
+    auto const handle = render_data_manager.add(container);
 
     ON_CALL(container, is_focused())
         .WillByDefault(::testing::Return(false));
-    render_data_manager.focus_change(container);
-
-    auto result = render_data_manager.get();
-    ASSERT_EQ(result.size(), 1);
-    ASSERT_TRUE(result[0].needs_outline);
-    ASSERT_FALSE(result[0].is_focused);
-    ASSERT_EQ(result[0].transform, glm::mat4(1.f));
-    ASSERT_EQ(result[0].workspace_transform, glm::mat4(1.f));
+    render_data_manager.focus_change(handle, container);
+
+    auto const result = render_data_manager.get();
+    ASSERT_EQ(result->size(), 1);
+    auto const* data = result->get(handle);
+    ASSERT_NE(data, nullptr);
+    ASSERT_TRUE(data->needs_outline);
+    ASSERT_FALSE(data->is_focused);
+    ASSERT_EQ(data->transform, glm::mat4(1.f));
+    ASSERT_EQ(result->workspace_transform(*data), glm::mat4(1.f));
+}
+
+TEST_F(RenderDataManagerTest, can_remove)
+{
+    ::testing::NiceMock<test::MockContainer> container;
+    ON_CALL(container, window())
+        .WillByDefault(::testing::Return(miral::Window()));
+    ON_CALL(container, get_type())
+        .WillByDefault(::testing::Return(ContainerType::leaf));
+
+    auto const handle = render_data_manager.add(container);
+    render_data_manager.remove(handle);
+
+    auto const result = render_data_manager.get();
+    ASSERT_EQ(result->size(), 0);
+    ASSERT_EQ(result->get(handle), nullptr);
+}
+
+TEST_F(RenderDataManagerTest, can_find_by_surface)
+{
+    auto session = std::make_shared<test::StubSession>();
+    auto surface = std::make_shared<test::StubSurface>();
+    ::testing::NiceMock<test::MockContainer> container;
+    ON_CALL(container, window())
+        .WillByDefault(::testing::Return(miral::Window(session, surface)));
+    ON_CALL(container, get_type())
+        .WillByDefault(::testing::Return(ContainerType::leaf));
+    ON_CALL(container, is_focused())
+        .WillByDefault(::testing::Return(true));
+
+    auto const handle = render_data_manager.add(container);
+    ASSERT_NE(render_data_manager.get()->find(surface.get()), nullptr);
+    ASSERT_TRUE(render_data_manager.get()->find(surface.get())->is_focused);
+
+    render_data_manager.remove(handle);
+    ASSERT_EQ(render_data_manager.get()->find(surface.get()), nullptr);
+}
+
+TEST_F(RenderDataManagerTest, published_snapshots_are_not_modified)
+{
+    ::testing::NiceMock<test::MockContainer> container;
+    ON_CALL(container, window())
+        .WillByDefault(::testing::Return(miral::Window()));
+    ON_CALL(container, get_type())
+        .WillByDefault(::testing::Return(ContainerType::leaf));
+    ON_CALL(container, get_transform())
+        .WillByDefault(::testing::Return(glm::mat4(1.f)));
+
+    auto const handle = render_data_manager.add(container);
+    auto const before = render_data_manager.get();
+
+    ON_CALL(container, get_transform())
+        .WillByDefault(::testing::Return(glm::mat4(2.f)));
+    render_data_manager.transform_change(handle, container);
+
+    ASSERT_EQ(before->get(handle)->transform, glm::mat4(1.f));
+    ASSERT_EQ(render_data_manager.get()->get(handle)->transform, glm::mat4(2.f));
+}
+
+TEST_F(RenderDataManagerTest, batch_publishes_once_when_complete)
+{
+    ::testing::NiceMock<test::MockContainer> container;
+    ON_CALL(container, window())
+        .WillByDefault(::testing::Return(miral::Window()));
+    ON_CALL(container, get_type())
+        .WillByDefault(::testing::Return(ContainerType::leaf));
+
+    auto const before = render_data_manager.get();
+    {
+        RenderDataManager::Batch batch(render_data_manager);
+        render_data_manager.add(container);
+        render_data_manager.add(container);
+        ASSERT_EQ(render_data_manager.get(), before);
+    }
+
+    ASSERT_NE(render_data_manager.get(), before);
+    ASSERT_EQ(render_data_manager.get()->size(), 2);
+}
+
+TEST_F(RenderDataManagerTest, unchanged_data_is_not_republished)
+{
+    auto const before = render_data_manager.get();
+    {
+        RenderDataManager::Batch batch(render_data_manager);
+    }
+
+    ASSERT_EQ(render_data_manager.get(), before);
+}
+
+TEST_F(RenderDataManagerTest, can_find_workspace_switch_by_output_area)
+{
+    mir::geometry::Rectangle const area { { 0, 0 }, { 1920, 1080 } };
+    mir::geometry::Rectangle const other_area { { 1920, 0 }, { 1920, 1080 } };
+    auto const serial = render_data_manager.begin_workspace_switch(area, { 1, 2 });
+
+    auto const* workspace_switch = render_data_manager.get()->find_workspace_switch(area);
+    ASSERT_NE(workspace_switch, nullptr);
+    ASSERT_EQ(workspace_switch->serial, serial);
+    ASSERT_EQ(workspace_switch->workspaces, std::vector<uint32_t>({ 1, 2 }));
+    ASSERT_EQ(render_data_manager.get()->find_workspace_switch(other_area), nullptr);
+}
+
+TEST_F(RenderDataManagerTest, new_workspace_switch_replaces_previous_on_same_output)
+{
+    mir::geometry::Rectangle const area { { 0, 0 }, { 1920, 1080 } };
+    auto const first = render_data_manager.begin_workspace_switch(area, { 1, 2 });
+    auto const second = render_data_manager.begin_workspace_switch(area, { 2, 3 });
+    ASSERT_NE(first, second);
+
+    // Ending a switch that was replaced leaves the new one in place
+    render_data_manager.end_workspace_switch(first);
+    ASSERT_EQ(render_data_manager.get()->workspace_switches.size(), 1);
+    ASSERT_EQ(render_data_manager.get()->find_workspace_switch(area)->serial, second);
+
+    render_data_manager.end_workspace_switch(second);
+    ASSERT_EQ(render_data_manager.get()->find_workspace_switch(area), nullptr);
 }
 
 class RenderDataManagerParameterizedTest : public RenderDataManagerTest, public ::testing::WithParamInterface<int>
@@ -169,8 +322,8 @@ TEST_P(RenderDataManagerParameterizedTest, can_add_many_containers)
         render_data_manager.add(container);
     }
 
-    auto result = render_data_manager.get();
-    ASSERT_EQ(result.size(), value);
+    auto const result = render_data_manager.get();
+    ASSERT_EQ(result->size(), value);
 }
 
 INSTANTIATE_TEST_SUITE_P(
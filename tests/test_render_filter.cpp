@@ -0,0 +1,76 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "render_filter.h"
+#include <gtest/gtest.h>
+
+using namespace miracle;
+
+namespace
+{
+std::array<float, 3> apply(ColorMatrix const& m, std::array<float, 3> const& c)
+{
+    return {
+        m[0] * c[0] + m[1] * c[1] + m[2] * c[2],
+        m[3] * c[0] + m[4] * c[1] + m[5] * c[2],
+        m[6] * c[0] + m[7] * c[1] + m[8] * c[2]
+    };
+}
+}
+
+TEST(RenderFilterTest, none_is_identity)
+{
+    auto const result = apply(color_matrix(RenderFilter::none), { 0.2f, 0.4f, 0.6f });
+    EXPECT_FLOAT_EQ(result[0], 0.2f);
+    EXPECT_FLOAT_EQ(result[1], 0.4f);
+    EXPECT_FLOAT_EQ(result[2], 0.6f);
+}
+
+TEST(RenderFilterTest, grayscale_produces_equal_channels)
+{
+    auto const result = apply(color_matrix(RenderFilter::grayscale), { 1.f, 0.f, 0.f });
+    EXPECT_FLOAT_EQ(result[0], 0.299f);
+    EXPECT_FLOAT_EQ(result[1], 0.299f);
+    EXPECT_FLOAT_EQ(result[2], 0.299f);
+}
+
+TEST(RenderFilterTest, color_vision_filters_preserve_grays)
+{
+    for (auto const filter : { RenderFilter::protanopia, RenderFilter::deuteranopia, RenderFilter::tritanopia })
+    {
+        auto const result = apply(color_matrix(filter), { 0.5f, 0.5f, 0.5f });
+        for (auto const channel : result)
+            EXPECT_NEAR(channel, 0.5f, 1e-4f);
+    }
+}
+
+TEST(RenderFilterTest, protanopia_shifts_red_into_other_channels)
+{
+    auto const result = apply(color_matrix(RenderFilter::protanopia), { 1.f, 0.f, 0.f });
+    EXPECT_FLOAT_EQ(result[0], 1.f);
+    EXPECT_GT(result[2], 0.5f);
+}
+
+TEST(RenderFilterTest, shader_source_defines_apply_filter)
+{
+    for (size_t i = 0; i < render_filter_count; i++)
+    {
+        auto const source = filter_shader_source(static_cast<RenderFilter>(i));
+        EXPECT_NE(source.find("vec4 apply_filter(vec4 color)"), std::string::npos);
+    }
+    EXPECT_NE(filter_shader_source(RenderFilter::grayscale).find("mat3(0.299000, 0.299000, 0.299000"), std::string::npos);
+}
@@ -0,0 +1,80 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "slot_map.h"
+#include <gtest/gtest.h>
+
+using namespace miracle;
+
+TEST(SlotMapTest, inserted_values_can_be_retrieved)
+{
+    SlotMap<int> map;
+    auto const first = map.insert(1);
+    auto const second = map.insert(2);
+    EXPECT_EQ(map.size(), 2);
+    EXPECT_EQ(*map.get(first), 1);
+    EXPECT_EQ(*map.get(second), 2);
+}
+
+TEST(SlotMapTest, erased_values_cannot_be_retrieved)
+{
+    SlotMap<int> map;
+    auto const handle = map.insert(1);
+    EXPECT_TRUE(map.erase(handle));
+    EXPECT_EQ(map.get(handle), nullptr);
+    EXPECT_FALSE(map.erase(handle));
+    EXPECT_TRUE(map.empty());
+}
+
+TEST(SlotMapTest, stale_handle_does_not_refer_to_reused_slot)
+{
+    SlotMap<int> map;
+    auto const stale = map.insert(1);
+    map.erase(stale);
+    auto const fresh = map.insert(2);
+    EXPECT_EQ(stale.index, fresh.index);
+    EXPECT_EQ(map.get(stale), nullptr);
+    EXPECT_EQ(*map.get(fresh), 2);
+}
+
+TEST(SlotMapTest, erasing_keeps_other_handles_valid)
+{
+    SlotMap<int> map;
+    std::vector<SlotMapHandle> handles;
+    for (int i = 0; i < 10; i++)
+        handles.push_back(map.insert(i));
+
+    map.erase(handles[0]);
+    map.erase(handles[5]);
+    for (size_t i = 0; i < handles.size(); i++)
+    {
+        if (i == 0 || i == 5)
+            continue;
+        ASSERT_NE(map.get(handles[i]), nullptr);
+        EXPECT_EQ(*map.get(handles[i]), static_cast<int>(i));
+    }
+    EXPECT_EQ(map.size(), 8u);
+}
+
+TEST(SlotMapTest, default_handle_is_invalid)
+{
+    SlotMap<int> map;
+    map.insert(1);
+    SlotMapHandle handle;
+    EXPECT_FALSE(handle.is_valid());
+    EXPECT_EQ(map.get(handle), nullptr);
+}
@@ -0,0 +1,101 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "spatial_index.h"
+#include <gtest/gtest.h>
+
+using namespace miracle;
+namespace geom = mir::geometry;
+
+namespace
+{
+geom::Rectangle rect(int x, int y, int width, int height)
+{
+    return {
+        { x,     y      },
+        { width, height }
+    };
+}
+}
+
+TEST(SpatialIndexTest, finds_the_rectangle_under_a_point)
+{
+    SpatialIndex<int> index(100);
+    index.insert(1, rect(0, 0, 640, 720), 0);
+    index.insert(2, rect(640, 0, 640, 720), 1);
+
+    ASSERT_EQ(*index.at({ 10, 10 }), 1);
+    ASSERT_EQ(*index.at({ 639, 719 }), 1);
+    ASSERT_EQ(*index.at({ 640, 0 }), 2);
+    ASSERT_EQ(index.at({ 1280, 0 }), nullptr);
+}
+
+TEST(SpatialIndexTest, finds_rectangles_at_negative_coordinates)
+{
+    SpatialIndex<int> index(100);
+    index.insert(1, rect(-1280, -50, 1280, 720), 0);
+
+    ASSERT_EQ(*index.at({ -1, -1 }), 1);
+    ASSERT_EQ(*index.at({ -1280, -50 }), 1);
+    ASSERT_EQ(index.at({ 0, 0 }), nullptr);
+    ASSERT_EQ(index.at({ -1281, 0 }), nullptr);
+}
+
+TEST(SpatialIndexTest, prefers_the_lowest_order_where_rectangles_overlap)
+{
+    SpatialIndex<int> index(100);
+    index.insert(1, rect(0, 0, 500, 500), 1);
+    index.insert(2, rect(100, 100, 100, 100), 0);
+
+    ASSERT_EQ(*index.at({ 150, 150 }), 2);
+    ASSERT_EQ(*index.at({ 50, 50 }), 1);
+}
+
+TEST(SpatialIndexTest, ignored_key_is_skipped)
+{
+    SpatialIndex<int> index(100);
+    index.insert(1, rect(0, 0, 500, 500), 0);
+    index.insert(2, rect(0, 0, 500, 500), 1);
+
+    int const ignored = 1;
+    ASSERT_EQ(*index.at({ 10, 10 }, &ignored), 2);
+}
+
+TEST(SpatialIndexTest, updated_rectangle_is_found_only_at_its_new_area)
+{
+    SpatialIndex<int> index(100);
+    index.insert(1, rect(0, 0, 100, 100), 0);
+    ASSERT_TRUE(index.update(1, rect(1000, 1000, 50, 50)));
+
+    ASSERT_EQ(index.at({ 10, 10 }), nullptr);
+    ASSERT_EQ(*index.at({ 1010, 1010 }), 1);
+    ASSERT_EQ(index.size(), 1);
+}
+
+TEST(SpatialIndexTest, update_of_unknown_key_fails)
+{
+    SpatialIndex<int> index;
+    ASSERT_FALSE(index.update(1, rect(0, 0, 100, 100)));
+    ASSERT_TRUE(index.empty());
+}
+
+TEST(SpatialIndexTest, empty_rectangles_are_never_found)
+{
+    SpatialIndex<int> index(100);
+    index.insert(1, rect(10, 10, 0, 100), 0);
+    ASSERT_EQ(index.at({ 10, 10 }), nullptr);
+}
@@ -0,0 +1,92 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "spsc_queue.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+
+using namespace miracle;
+
+TEST(SpscQueueTest, values_are_popped_in_the_order_they_were_pushed)
+{
+    SpscQueue<int> queue;
+    for (int i = 0; i < 10; i++)
+        queue.push(i);
+
+    for (int i = 0; i < 10; i++)
+        EXPECT_EQ(queue.pop(), i);
+    EXPECT_EQ(queue.pop(), std::nullopt);
+}
+
+TEST(SpscQueueTest, empty_queue_is_empty)
+{
+    SpscQueue<int> queue;
+    EXPECT_TRUE(queue.empty());
+    queue.push(1);
+    EXPECT_FALSE(queue.empty());
+    queue.pop();
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(SpscQueueTest, popped_values_are_released)
+{
+    SpscQueue<std::shared_ptr<int>> queue;
+    auto const value = std::make_shared<int>(1);
+    queue.push(value);
+    EXPECT_EQ(value.use_count(), 2);
+
+    queue.pop();
+    EXPECT_EQ(value.use_count(), 1);
+}
+
+TEST(SpscQueueTest, queued_values_are_released_with_the_queue)
+{
+    auto const value = std::make_shared<int>(1);
+    {
+        SpscQueue<std::shared_ptr<int>> queue;
+        queue.push(value);
+        queue.push(value);
+    }
+    EXPECT_EQ(value.use_count(), 1);
+}
+
+TEST(SpscQueueTest, values_cross_threads_in_order)
+{
+    constexpr int count = 1000000;
+    SpscQueue<int> queue;
+    std::thread producer([&]()
+    {
+        for (int i = 0; i < count; i++)
+            queue.push(i);
+    });
+
+    int expected = 0;
+    while (expected < count)
+    {
+        if (auto const value = queue.pop())
+        {
+            ASSERT_EQ(value.value(), expected);
+            expected++;
+        }
+        else
+            std::this_thread::yield();
+    }
+
+    producer.join();
+    EXPECT_TRUE(queue.empty());
+}
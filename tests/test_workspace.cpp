@@ -69,12 +69,13 @@ public:
         state(std::make_shared<CompositorState>()),
         output(create_output(OUTPUT_SIZE)),
         window_controller(std::make_shared<StubWindowController>(pairs)),
+        config(std::make_shared<test::StubConfiguration>()),
         workspace(
             output.get(),
             0,
             0,
             "0",
-            std::make_shared<test::StubConfiguration>(),
+            config,
             window_controller,
             state)
     {
@@ -112,6 +113,7 @@ public:
     std::vector<StubWindowData> pairs;
     std::shared_ptr<StubWindowController> window_controller;
     std::unique_ptr<test::MockOutput> output;
+    std::shared_ptr<test::StubConfiguration> config;
     Workspace workspace;
 };
 
@@ -279,6 +281,174 @@ TEST_F(WorkspaceTest, dragged_windows_are_unconstrained)
     ASSERT_EQ(window_controller->get_window_data(leaf1).clip, leaf1->get_visible_area());
 }
 
+TEST_F(WorkspaceTest, recalculating_an_unchanged_area_recomputes_no_containers)
+{
+    create_leaf();
+    create_leaf();
+    create_leaf();
+
+    auto const before = state->layout_counters;
+    workspace.recalculate_area();
+    ASSERT_EQ(state->layout_counters.recomputed, before.recomputed);
+    ASSERT_EQ(state->layout_counters.skipped, before.skipped + 1);
+}
+
+TEST_F(WorkspaceTest, changing_the_area_recomputes_each_container_once)
+{
+    create_leaf();
+    auto leaf2 = create_leaf();
+
+    auto const before = state->layout_counters;
+    workspace.set_area(geom::Rectangle(geom::Point(0, 0), geom::Size(1000, 500)));
+
+    // The root and both of its leaves
+    ASSERT_EQ(state->layout_counters.recomputed, before.recomputed + 3);
+    ASSERT_EQ(leaf2->get_logical_area().size, geom::Size(500, 500));
+}
+
+TEST_F(WorkspaceTest, invalidating_a_lane_lays_it_out_again_under_an_unchanged_parent)
+{
+    create_leaf();
+    auto leaf2 = create_leaf();
+    auto lane = workspace.get_root()->convert_to_parent(leaf2);
+    create_leaf(lane);
+
+    auto const before = state->layout_counters;
+    lane->invalidate_layout();
+    workspace.recalculate_area();
+
+    // The root and every container beneath it, even though the root's area is unchanged
+    ASSERT_EQ(state->layout_counters.recomputed, before.recomputed + 5);
+}
+
+TEST_F(WorkspaceTest, changing_the_border_size_lays_out_every_window_again)
+{
+    auto leaf1 = create_leaf();
+    auto leaf2 = create_leaf();
+
+    config->set_border_size(10);
+    ASSERT_EQ(window_controller->get_window_data(leaf1).rectangle, leaf1->get_visible_area());
+    ASSERT_EQ(window_controller->get_window_data(leaf2).rectangle, leaf2->get_visible_area());
+    ASSERT_EQ(window_controller->get_window_data(leaf1).rectangle.top_left, geom::Point(10, 10));
+}
+
+TEST_F(WorkspaceTest, tree_lists_children_by_index)
+{
+    auto leaf1 = create_leaf();
+    auto leaf2 = create_leaf();
+    auto lane = workspace.get_root()->convert_to_parent(leaf2);
+    auto leaf3 = create_leaf(lane);
+
+    auto const tree = workspace.get_tree();
+    ASSERT_EQ(tree->size(), 5);
+    ASSERT_EQ((*tree)[0].container.lock(), workspace.get_root());
+    ASSERT_EQ((*tree)[0].end, 5);
+    ASSERT_EQ(tree->first_child(0), 1);
+    ASSERT_EQ((*tree)[1].container.lock(), leaf1);
+    ASSERT_EQ(tree->first_child(1), ContainerTree::no_node);
+    ASSERT_EQ(tree->next_sibling(1), 2);
+    ASSERT_EQ((*tree)[2].container.lock(), lane);
+    ASSERT_EQ(tree->next_sibling(2), ContainerTree::no_node);
+    ASSERT_EQ(tree->first_child(2), 3);
+    ASSERT_EQ((*tree)[3].container.lock(), leaf2);
+    ASSERT_EQ(tree->next_sibling(3), 4);
+    ASSERT_EQ((*tree)[4].container.lock(), leaf3);
+    ASSERT_EQ((*tree)[4].parent, 2);
+}
+
+TEST_F(WorkspaceTest, held_tree_keeps_its_shape_after_the_tree_changes)
+{
+    create_leaf();
+    auto const before = workspace.get_tree();
+    create_leaf();
+
+    ASSERT_EQ(before->size(), 2);
+    ASSERT_EQ(workspace.get_tree()->size(), 3);
+}
+
+TEST_F(WorkspaceTest, for_each_window_follows_changes_to_the_tree)
+{
+    auto leaf1 = create_leaf();
+    auto leaf2 = create_leaf();
+
+    auto const visit_order = [&]
+    {
+        std::vector<std::shared_ptr<Container>> visited;
+        workspace.for_each_window([&](std::shared_ptr<Container> const& container)
+        {
+            visited.push_back(container);
+            return false;
+        });
+        return visited;
+    };
+
+    ASSERT_EQ(visit_order(), (std::vector<std::shared_ptr<Container>> { leaf1, leaf2 }));
+
+    leaf1->move_to(*leaf2);
+    ASSERT_EQ(visit_order(), (std::vector<std::shared_ptr<Container>> { leaf2, leaf1 }));
+
+    auto leaf3 = create_leaf();
+    ASSERT_EQ(visit_order(), (std::vector<std::shared_ptr<Container>> { leaf2, leaf1, leaf3 }));
+}
+
+TEST_F(WorkspaceTest, for_each_window_visits_the_remaining_windows_when_one_is_removed)
+{
+    auto leaf1 = create_leaf();
+    auto leaf2 = create_leaf();
+    auto leaf3 = create_leaf();
+
+    std::vector<std::shared_ptr<Container>> visited;
+    workspace.for_each_window([&](std::shared_ptr<Container> const& container)
+    {
+        visited.push_back(container);
+        if (container == leaf1)
+            workspace.delete_container(leaf1);
+        return false;
+    });
+
+    ASSERT_EQ(visited, (std::vector<std::shared_ptr<Container>> { leaf1, leaf2, leaf3 }));
+}
+
+TEST_F(WorkspaceTest, for_each_window_skips_windows_removed_before_they_are_visited)
+{
+    auto leaf1 = create_leaf();
+    auto leaf2 = create_leaf();
+    auto leaf3 = create_leaf();
+
+    std::vector<std::shared_ptr<Container>> visited;
+    workspace.for_each_window([&](std::shared_ptr<Container> const& container)
+    {
+        visited.push_back(container);
+        if (container == leaf1)
+            workspace.delete_container(leaf2);
+        return false;
+    });
+
+    ASSERT_EQ(visited, (std::vector<std::shared_ptr<Container>> { leaf1, leaf3 }));
+}
+
+TEST_F(WorkspaceTest, leaf_at_finds_the_window_under_a_point)
+{
+    auto leaf1 = create_leaf();
+    auto leaf2 = create_leaf();
+
+    ASSERT_EQ(workspace.leaf_at(10, 10, nullptr), leaf1);
+    ASSERT_EQ(workspace.leaf_at(OUTPUT_WIDTH - 10, 10, nullptr), leaf2);
+    ASSERT_EQ(workspace.leaf_at(10, 10, leaf1.get()), nullptr);
+}
+
+TEST_F(WorkspaceTest, leaf_at_follows_windows_when_the_area_changes)
+{
+    auto leaf1 = create_leaf();
+    auto leaf2 = create_leaf();
+    ASSERT_EQ(workspace.leaf_at(OUTPUT_WIDTH - 10, 10, nullptr), leaf2);
+
+    workspace.set_area(geom::Rectangle(geom::Point(0, 0), geom::Size(1000, 500)));
+    ASSERT_EQ(workspace.leaf_at(490, 10, nullptr), leaf1);
+    ASSERT_EQ(workspace.leaf_at(510, 10, nullptr), leaf2);
+    ASSERT_EQ(workspace.leaf_at(OUTPUT_WIDTH - 10, 10, nullptr), nullptr);
+}
+
 TEST_F(WorkspaceTest, workspace_bounds_are_initialized_to_output_size_when_no_app_zones_are_present)
 {
     // Assert that the first tree (w/o app zones) is equal to the output size.